@@ -0,0 +1,387 @@
+/**
+ * @file AllocationTrace.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Records the Allocate and Free calls made on an Object Allocator (OA) to a compact binary trace and
+ *        loads a trace back so it can be replayed (see replay.cpp). Each event is a type byte followed by
+ *        variable-length numbers: the block id, the label id and the nanoseconds since the previous event.
+ *        The sequence number of an event is its position in the trace. Block ids are reused once their
+ *        block is freed, so there are never more ids than the most blocks in use at once.
+ * @date 10-14-2026
+ */
+
+#include "AllocationTrace.h"
+#include <cstring>
+#include <new>
+
+// Starts every trace file (the last character is the version of the format)
+static const char TRACE_MAGIC[8] = { 'O', 'A', 'T', 'R', 'A', 'C', 'E', '1' };
+
+// The type byte of the text of a new label (it gets the next label id)
+static const unsigned char TRACE_LABEL = 4;
+
+/**
+ * @brief Creates the trace file and writes its header (the object size of the allocator).
+ *
+ * @param path - the file to write the trace to
+ * @param objectSize - the object size of the allocator being traced
+ */
+TraceRecorder::TraceRecorder(const char *path, size_t objectSize) : File(std::fopen(path, "wb")), Failed(false),
+                                                                    Last(std::chrono::steady_clock::now()), NextId(0)
+{
+    if(File == nullptr)
+        return;
+
+    std::fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), File);
+    WriteNumber(objectSize);
+}
+
+/**
+ * @brief Closes the trace file if it wasn't closed yet.
+ */
+TraceRecorder::~TraceRecorder()
+{
+    Close();
+}
+
+/**
+ * @brief Returns true if the file was created and every event so far was recorded.
+ *
+ * @return bool
+ */
+bool TraceRecorder::IsOpen() const
+{
+    return File != nullptr && !Failed;
+}
+
+/**
+ * @brief Records an allocation. The block gets the most recently freed id (or a new one).
+ *
+ * @param block - the block allocated
+ * @param label - the label it was allocated with (can be null)
+ */
+void TraceRecorder::RecordAllocate(const void *block, const char *label) noexcept
+{
+    if(!IsOpen())
+        return;
+
+    try
+    {
+        unsigned labelId = (label != nullptr) ? LabelId(label) : 0;
+
+        unsigned id = NextId;
+        if(!FreeIds.empty())
+        {
+            id = FreeIds.back();
+            FreeIds.pop_back();
+        }
+        else
+        {
+            NextId++;
+        }
+
+        BlockIds[block] = id;
+
+        WriteEvent(TraceEvent::etAllocate, id, labelId);
+    }
+    catch(const std::bad_alloc& e)
+    {
+        Failed = true;
+    }
+}
+
+/**
+ * @brief Records a free. Blocks allocated before the recording started aren't recorded.
+ *
+ * @param block - the block freed
+ */
+void TraceRecorder::RecordFree(const void *block) noexcept
+{
+    if(!IsOpen())
+        return;
+
+    std::unordered_map<const void*, unsigned>::iterator found = BlockIds.find(block);
+    if(found == BlockIds.end())
+        return;
+
+    unsigned id = found->second;
+    BlockIds.erase(found);
+
+    try
+    {
+        FreeIds.push_back(id);
+    }
+    catch(const std::bad_alloc& e)
+    {
+        Failed = true;
+
+        return;
+    }
+
+    WriteEvent(TraceEvent::etFree, id, 0);
+}
+
+/**
+ * @brief Records a reset. Every block is free after it, so every id can be used again.
+ *
+ * @param keepPages - the most pages Reset was told to keep
+ */
+void TraceRecorder::RecordReset(unsigned keepPages) noexcept
+{
+    if(!IsOpen())
+        return;
+
+    BlockIds.clear();
+    FreeIds.clear();
+    NextId = 0;
+
+    WriteEvent(TraceEvent::etReset, keepPages, 0);
+}
+
+/**
+ * @brief Records a call to FreeEmptyPages (the replay frees the empty pages at the same point).
+ */
+void TraceRecorder::RecordFreeEmptyPages() noexcept
+{
+    if(!IsOpen())
+        return;
+
+    WriteEvent(TraceEvent::etFreeEmptyPages, 0, 0);
+}
+
+/**
+ * @brief Moves the id of a block moved by Compact to its new address, so its free is recorded with the 
+ *        same id. The replay never moves blocks, so nothing is written.
+ *
+ * @param from - the old address of the block
+ * @param to - the new address of the block
+ */
+void TraceRecorder::RecordMove(const void *from, const void *to) noexcept
+{
+    if(!IsOpen())
+        return;
+
+    std::unordered_map<const void*, unsigned>::iterator found = BlockIds.find(from);
+    if(found == BlockIds.end())
+        return;
+
+    unsigned id = found->second;
+    BlockIds.erase(found);
+
+    try
+    {
+        BlockIds[to] = id;
+    }
+    catch(const std::bad_alloc& e)
+    {
+        Failed = true;
+    }
+}
+
+/**
+ * @brief Flushes and closes the trace file.
+ *
+ * @return bool - false if the file wasn't created or some of the trace couldn't be written
+ */
+bool TraceRecorder::Close()
+{
+    if(File == nullptr)
+        return false;
+
+    if(std::ferror(File) != 0)
+        Failed = true;
+    if(std::fclose(File) != 0)
+        Failed = true;
+
+    File = nullptr;
+
+    return !Failed;
+}
+
+/**
+ * @brief Writes an event: the type, the block id (the pages kept for a reset), the label id of an
+ *        allocation and the nanoseconds since the last event.
+ *
+ * @param type - what happened
+ * @param id - the block id (or the pages kept)
+ * @param label - the label id
+ */
+void TraceRecorder::WriteEvent(TraceEvent::EVENT_TYPE type, unsigned id, unsigned label)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    long long delta = std::chrono::duration_cast<std::chrono::nanoseconds>(now - Last).count();
+    Last = now;
+
+    std::fputc(static_cast<int>(type), File);
+
+    if(type != TraceEvent::etFreeEmptyPages)
+        WriteNumber(id);
+    if(type == TraceEvent::etAllocate)
+        WriteNumber(label);
+
+    WriteNumber(delta > 0 ? static_cast<unsigned long long>(delta) : 0);
+}
+
+/**
+ * @brief Writes a number in as few bytes as it takes, 7 bits at a time starting with the lowest. Every
+ *        byte but the last has its high bit set.
+ *
+ * @param value - the number
+ */
+void TraceRecorder::WriteNumber(unsigned long long value)
+{
+    while(value >= 0x80)
+    {
+        std::fputc(static_cast<int>((value & 0x7F) | 0x80), File);
+        value >>= 7;
+    }
+
+    std::fputc(static_cast<int>(value), File);
+}
+
+/**
+ * @brief Returns the id of a label. Most labels are string literals, so the address is looked up first
+ *        (and checked against the text, in case the address was reused). A new label is written to the
+ *        trace before the event that uses it.
+ *
+ * @param label - the label
+ * @return unsigned - the label id (starting at 1)
+ */
+unsigned TraceRecorder::LabelId(const char *label)
+{
+    std::unordered_map<const char*, unsigned>::iterator byAddress = LabelsByAddress.find(label);
+    if(byAddress != LabelsByAddress.end() && LabelText[byAddress->second - 1] == label)
+        return byAddress->second;
+
+    std::string text(label);
+
+    std::unordered_map<std::string, unsigned>::iterator byText = LabelsByText.find(text);
+    if(byText != LabelsByText.end())
+    {
+        LabelsByAddress[label] = byText->second;
+
+        return byText->second;
+    }
+
+    LabelText.push_back(text);
+    unsigned id = static_cast<unsigned>(LabelText.size());
+    LabelsByText[text] = id;
+    LabelsByAddress[label] = id;
+
+    std::fputc(TRACE_LABEL, File);
+    WriteNumber(text.size());
+    std::fwrite(text.data(), 1, text.size(), File);
+
+    return id;
+}
+
+/**
+ * @brief Reads a number written by TraceRecorder::WriteNumber.
+ *
+ * @param bytes - the trace
+ * @param position - where the number starts (moved past it)
+ * @param value - where to put the number
+ * @return whether a whole number was read
+ */
+static bool ReadNumber(const std::vector<unsigned char>& bytes, size_t& position, unsigned long long& value)
+{
+    value = 0;
+
+    for(unsigned shift = 0; shift < 64; shift += 7)
+    {
+        if(position >= bytes.size())
+            return false;
+
+        unsigned char byte = bytes[position++];
+        value |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+
+        if((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Loads a whole trace into memory, so replaying it doesn't read the file.
+ *
+ * @param path - the trace file
+ * @param trace - where to put the trace
+ * @return whether the file was a whole trace
+ */
+bool LoadTrace(const char *path, AllocationTrace &trace)
+{
+    std::FILE* file = std::fopen(path, "rb");
+    if(file == nullptr)
+        return false;
+
+    std::vector<unsigned char> bytes;
+    unsigned char buffer[65536];
+    size_t read;
+    while((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        bytes.insert(bytes.end(), buffer, buffer + read);
+
+    std::fclose(file);
+
+    if(bytes.size() < sizeof(TRACE_MAGIC) || std::memcmp(bytes.data(), TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0)
+        return false;
+
+    size_t position = sizeof(TRACE_MAGIC);
+    unsigned long long value;
+
+    if(!ReadNumber(bytes, position, value))
+        return false;
+
+    trace.objectSize_ = static_cast<size_t>(value);
+    trace.events_.clear();
+    trace.labels_.clear();
+    trace.blockIds_ = 0;
+
+    while(position < bytes.size())
+    {
+        unsigned char type = bytes[position++];
+
+        if(type == TRACE_LABEL)
+        {
+            if(!ReadNumber(bytes, position, value) || value > bytes.size() - position)
+                return false;
+
+            size_t length = static_cast<size_t>(value);
+            trace.labels_.push_back(std::string(reinterpret_cast<const char*>(bytes.data() + position), length));
+            position += length;
+
+            continue;
+        }
+
+        if(type > TraceEvent::etFreeEmptyPages)
+            return false;
+
+        TraceEvent event;
+        event.type_ = static_cast<TraceEvent::EVENT_TYPE>(type);
+        event.id_ = 0;
+        event.label_ = 0;
+
+        if(event.type_ != TraceEvent::etFreeEmptyPages)
+        {
+            if(!ReadNumber(bytes, position, value))
+                return false;
+            event.id_ = static_cast<unsigned>(value);
+        }
+
+        if(event.type_ == TraceEvent::etAllocate)
+        {
+            if(!ReadNumber(bytes, position, value) || value > trace.labels_.size())
+                return false;
+            event.label_ = static_cast<unsigned>(value);
+
+            if(event.id_ >= trace.blockIds_)
+                trace.blockIds_ = event.id_ + 1;
+        }
+
+        if(!ReadNumber(bytes, position, event.delta_))
+            return false;
+
+        trace.events_.push_back(event);
+    }
+
+    return true;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file AllocationTrace.h
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Records the Allocate and Free calls made on an Object Allocator (OA) to a compact binary trace and
+ *        loads a trace back so it can be replayed (see replay.cpp). Each event is a type byte followed by
+ *        variable-length numbers: the block id, the label id and the nanoseconds since the previous event.
+ *        The sequence number of an event is its position in the trace. Block ids are reused once their
+ *        block is freed, so there are never more ids than the most blocks in use at once.
+ * @date 10-14-2026
+ */
+
+//---------------------------------------------------------------------------
+#ifndef ALLOCATIONTRACEH
+#define ALLOCATIONTRACEH
+//---------------------------------------------------------------------------
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*!
+  One event of a trace
+*/
+struct TraceEvent
+{
+  /*!
+    What happened
+  */
+  enum EVENT_TYPE
+  {
+    etAllocate,       //!< a block was allocated (with a new id and a label)
+    etFree,           //!< a block was freed (its id can be reused after this)
+    etReset,          //!< every block was freed by Reset (the id is the pages kept)
+    etFreeEmptyPages  //!< the empty pages were freed
+  };
+
+  EVENT_TYPE type_;          //!< what happened
+  unsigned id_;              //!< the block (or the pages kept by a reset)
+  unsigned label_;           //!< the label of an allocation (0 for none)
+  unsigned long long delta_; //!< nanoseconds since the previous event
+};
+
+/*!
+  A trace loaded into memory
+*/
+struct AllocationTrace
+{
+  size_t objectSize_;               //!< the object size of the allocator that was traced
+  std::vector<TraceEvent> events_;  //!< every event, in order
+  std::vector<std::string> labels_; //!< the text of each label (label i is labels_[i - 1])
+  unsigned blockIds_;               //!< the number of block ids used (the most blocks in use at once)
+};
+
+  // Loads a whole trace written by a TraceRecorder. Returns false if the file can't be read or isn't a trace.
+bool LoadTrace(const char *path, AllocationTrace &trace);
+
+/*!
+  Writes the events of one allocator to a trace file
+*/
+class TraceRecorder
+{
+  public:
+      // Creates the trace file for an allocator with the given object size (IsOpen tells if it worked)
+    TraceRecorder(const char *path, size_t objectSize);
+
+      // Closes the trace file (never throws)
+    ~TraceRecorder();
+
+      // Returns true if the file was created and nothing has failed to be written
+    bool IsOpen() const;
+
+      // Record one event each. They never throw, a failure stops the recording (reported by Close).
+    void RecordAllocate(const void *block, const char *label) noexcept;
+    void RecordFree(const void *block) noexcept;
+    void RecordReset(unsigned keepPages) noexcept;
+    void RecordFreeEmptyPages() noexcept;
+
+      // Gives a block moved by Compact the id of its old address (nothing is written, a replay doesn't move)
+    void RecordMove(const void *from, const void *to) noexcept;
+
+      // Flushes and closes the file, returns false if any of it couldn't be written
+    bool Close();
+
+      // Prevent copy construction and assignment
+    TraceRecorder(const TraceRecorder &tr) = delete;            //!< Do not implement!
+    TraceRecorder &operator=(const TraceRecorder &tr) = delete; //!< Do not implement!
+
+  private:
+    // Writes the type of an event, the numbers it has and the time since the last event.
+    void WriteEvent(TraceEvent::EVENT_TYPE type, unsigned id, unsigned label);
+
+    // Writes a number 7 bits at a time (the high bit is set on every byte but the last).
+    void WriteNumber(unsigned long long value);
+
+    // Returns the id of a label, writing the label to the trace the first time it's seen.
+    unsigned LabelId(const char *label);
+
+  private:
+    std::FILE *File; //!< the trace file (nullptr once closed)
+    bool Failed;     //!< something couldn't be recorded, so the trace is incomplete
+
+    // when the last event was recorded
+    std::chrono::steady_clock::time_point Last;
+
+    // the id of each block in use, the ids freed (reused last freed first) and the next id never used
+    std::unordered_map<const void*, unsigned> BlockIds;
+    std::vector<unsigned> FreeIds;
+    unsigned NextId;
+
+    // the id of each label, looked up by its address first and then by its text (label i is LabelText[i - 1])
+    std::unordered_map<const char*, unsigned> LabelsByAddress;
+    std::unordered_map<std::string, unsigned> LabelsByText;
+    std::vector<std::string> LabelText;
+};
+
+#endif
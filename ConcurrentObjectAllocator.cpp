@@ -0,0 +1,669 @@
+/**
+ * @file ConcurrentObjectAllocator.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief This is a thread-safe front-end for the Object Allocator (OA). Each thread keeps a small magazine
+ *        of free blocks that it allocates from and frees to without locking. When a thread's magazine
+ *        runs empty or fills up, half of it is refilled from or drained back to the shared OA under a lock,
+ *        so the lock is taken once per batch instead of once per call. Instead of magazines, the free
+ *        blocks can also be kept on one lock-free stack shared by all the threads.
+ * @date 10-14-2026
+ */
+
+#include "ConcurrentObjectAllocator.h"
+
+thread_local ConcurrentObjectAllocator::CacheSlot ConcurrentObjectAllocator::CacheSlots[CACHE_SLOTS];
+thread_local ConcurrentObjectAllocator::ThreadCacheList ConcurrentObjectAllocator::ThreadCaches = { nullptr, false };
+std::mutex ConcurrentObjectAllocator::ThreadsLock;
+std::atomic<unsigned> ConcurrentObjectAllocator::NextId(1);
+
+// User space addresses fit in the low 48 bits of a 64-bit pointer, so the top 16 bits of a lock-free stack head
+// hold the tag. With 32-bit pointers, the tag gets the whole top half.
+static const unsigned TAG_SHIFT = sizeof(void*) == 8 ? 48 : 32;
+static const std::uint64_t ADDRESS_MASK = (static_cast<std::uint64_t>(1) << TAG_SHIFT) - 1;
+
+static_assert(sizeof(std::uintptr_t) <= sizeof(std::uint64_t), "a pointer must fit in a lock-free stack head");
+static_assert(64 - TAG_SHIFT >= 16, "the tag of a lock-free stack head must have at least 16 bits");
+
+/**
+ * @brief Creates the shared object allocator. The magazines are only used when the OA doesn't need to see
+ *        every call (debugging is off, no external headers and not using the CPP manager).
+ *
+ * @param ObjectSize - the size each object in the allocator will be
+ * @param config - the configuration settings (objects per page, pad bytes, etc.)
+ * @param MagazineSize - the most free blocks each thread can cache (or how many blocks the lock-free stack
+ *                       is refilled with at a time)
+ * @param CacheType - whether to use a magazine per thread or one lock-free stack
+ */
+ConcurrentObjectAllocator::ConcurrentObjectAllocator(size_t ObjectSize, const OAConfig& config, unsigned MagazineSize, CACHE_TYPE CacheType)
+    : Pool(ObjectSize, config), Caches(nullptr), RetiredAllocations(0), RetiredDeallocations(0), MagazineSize(MagazineSize), 
+      CacheType(CacheType), UseFreeStack(CacheType == ctLockFree), FreeStack(0), Id(NextId++)
+{
+    // The magazines are linked through the blocks, so the blocks have to hold a pointer
+    UseMagazines = MagazineSize > 0 && !config.DebugOn_ && !config.UseCPPMemManager_ && config.HBlockInfo_.type_ != OAConfig::hbExternal && 
+                   ObjectSize >= sizeof(GenericObject*);
+
+    // A refill is at most MagazineSize blocks
+    if(UseMagazines)
+        Batch.resize(MagazineSize);
+}
+
+/**
+ * @brief Destroys the thread caches (taking them off their threads' lists, so the threads don't give them 
+ *        back when they exit). Their blocks are still on the shared allocator's pages, so they get freed 
+ *        with the pages.
+ */
+ConcurrentObjectAllocator::~ConcurrentObjectAllocator()
+{
+    std::lock_guard<std::mutex> threads(ThreadsLock);
+
+    while(Caches != nullptr)
+    {
+        ThreadCache* temp = Caches->next_;
+        UnlinkThreadCache(Caches);
+        delete Caches;
+        Caches = temp;
+    }
+}
+
+/**
+ * @brief Gives the magazine of each allocator the exiting thread used back to its allocator, so the free 
+ *        blocks aren't stuck in a cache nobody uses anymore, and deletes the caches. The thread's cache 
+ *        slots are forgotten, so if it still uses an allocator (from another thread_local's destructor), 
+ *        it gets a new cache that's only deleted with the allocator.
+ */
+ConcurrentObjectAllocator::ThreadCacheList::~ThreadCacheList()
+{
+    std::lock_guard<std::mutex> threads(ThreadsLock);
+
+    exited_ = true;
+
+    for(CacheSlot& slot : CacheSlots)
+    {
+        slot.id_ = 0;
+    }
+
+    while(caches_ != nullptr)
+    {
+        ThreadCache* cache = caches_;
+        UnlinkThreadCache(cache);
+
+        cache->allocator_->RetireThreadCache(cache);
+    }
+}
+
+/**
+ * @brief Allocates a block from the calling thread's magazine (or the lock-free stack). If it's empty, it gets
+ *        refilled from the shared allocator first.
+ *
+ * @param label - the label to assign an external block
+ * @return void* - The allocated block
+ */
+void* ConcurrentObjectAllocator::Allocate(const char *label)
+{
+    if(!UseMagazines)
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+
+        return Pool.Allocate(label);
+    }
+
+    ThreadCache* cache = GetThreadCache();
+    GenericObject* block;
+
+    // Nothing is popped once the stack fell back to the magazines
+    block = UseFreeStack.load(std::memory_order_relaxed) ? PopFreeStack(label) : nullptr;
+
+    if(block == nullptr)
+    {
+        // If the magazine is empty, get more blocks from the shared allocator
+        if(cache->blocks_ == nullptr)
+        {
+            Refill(cache, label);
+        }
+
+        // Take the first block in the magazine
+        block = cache->blocks_;
+        cache->blocks_ = block->Next;
+        cache->count_--;
+    }
+
+    // Update the stats
+    Increment(cache->allocations_);
+
+    return block;
+}
+
+/**
+ * @brief Frees a block to the calling thread's magazine (or the lock-free stack). If the magazine is full, 
+ *        half of it gets drained back to the shared allocator first.
+ *
+ * @param Object - the object to free
+ */
+void ConcurrentObjectAllocator::Free(void *Object)
+{
+    if(!UseMagazines)
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+
+        Pool.Free(Object);
+
+        return;
+    }
+
+    ThreadCache* cache = GetThreadCache();
+    GenericObject* block = static_cast<GenericObject*>(Object);
+
+    if(UseFreeStack.load(std::memory_order_relaxed) && FitsFreeStack(block))
+    {
+        PushFreeStack(block, block);
+    }
+    else
+    {
+        // If the magazine is full, give half of it back to the shared allocator
+        if(cache->count_ >= MagazineSize)
+        {
+            Drain(cache, MagazineSize - MagazineSize / 2);
+        }
+
+        // Put the block at the front of the magazine
+        block->Next = cache->blocks_;
+        cache->blocks_ = block;
+        cache->count_++;
+    }
+
+    // Update the stats
+    Increment(cache->deallocations_);
+}
+
+/**
+ * @brief Gives every block in the calling thread's magazine back to the shared allocator.
+ */
+void ConcurrentObjectAllocator::FlushThreadCache()
+{
+    if(!UseMagazines)
+        return;
+
+    ThreadCache* cache = GetThreadCache();
+
+    Drain(cache, cache->count_);
+}
+
+/**
+ * @brief Frees all empty pages of the shared allocator. Blocks cached in magazines are in use as far as the
+ *        shared allocator knows, so call FlushThreadCache on each thread first to free as much as possible.
+ *        The lock-free stack is given back to the shared allocator first. A thread popping from the stack
+ *        could still read a block on a page being freed, so no other thread may use the allocator meanwhile.
+ *
+ * @return unsigned - Number of pages freed
+ */
+unsigned ConcurrentObjectAllocator::FreeEmptyPages()
+{
+    std::lock_guard<std::mutex> guard(Lock);
+
+    if(UseMagazines && CacheType == ctLockFree)
+    {
+        // Take the whole stack
+        std::uint64_t head = FreeStack.load(std::memory_order_acquire);
+        while(!FreeStack.compare_exchange_weak(head, PackHead(nullptr, HeadTag(head) + 1), std::memory_order_acquire, std::memory_order_acquire))
+        {
+        }
+
+        // Give each block back to the shared allocator
+        GenericObject* block = HeadBlock(head);
+        while(block != nullptr)
+        {
+            GenericObject* next = block->Next;
+            Pool.Free(block);
+            block = next;
+        }
+    }
+
+    return Pool.FreeEmptyPages();
+}
+
+/**
+ * @brief Returns the configurations of the shared allocator.
+ */
+OAConfig ConcurrentObjectAllocator::GetConfig() const
+{
+    std::lock_guard<std::mutex> guard(Lock);
+
+    return Pool.GetConfig();
+}
+
+/**
+ * @brief Returns the instrumentation counters of the shared allocator (all 0 unless compiled with 
+ *        OA_INSTRUMENT). Calls served from the magazines or the lock-free stack never reach the shared 
+ *        allocator, so only the refills, drains and by-passed calls are counted and timed.
+ *
+ * @return OAInstrumentation
+ */
+OAInstrumentation ConcurrentObjectAllocator::GetInstrumentation() const
+{
+    std::lock_guard<std::mutex> guard(Lock);
+
+    return Pool.GetInstrumentation();
+}
+
+/**
+ * @brief Sets how often the shared allocator times its Allocate and Free calls.
+ *
+ * @param SampleEvery - time 1 of every this many calls (0 turns sampling off)
+ */
+void ConcurrentObjectAllocator::SetLatencySampling(unsigned SampleEvery)
+{
+    std::lock_guard<std::mutex> guard(Lock);
+
+    Pool.SetLatencySampling(SampleEvery);
+}
+
+/**
+ * @brief Returns the statistics as seen by the clients. Blocks cached in magazines (or on the lock-free stack)
+ *        are counted as free objects instead of objects in use, and the allocations/frees are the totals of 
+ *        every thread. The counts are exact when no other thread is allocating or freeing at the same time. 
+ *        Otherwise a block can be allocated by one thread and freed by another between reading their 
+ *        counters, so the frees can look like more than the allocations, and the objects in use are kept 
+ *        between 0 and what the shared allocator handed out. The most objects is the shared allocator's 
+ *        peak, which counts the blocks that were cached as well.
+ */
+OAStats ConcurrentObjectAllocator::GetStats() const
+{
+    std::lock_guard<std::mutex> guard(Lock);
+
+    OAStats stats = Pool.GetStats();
+
+    if(!UseMagazines)
+        return stats;
+
+    unsigned allocations = RetiredAllocations;
+    unsigned deallocations = RetiredDeallocations;
+
+    // Add up the counters of every thread
+    for(ThreadCache* cache = Caches; cache != nullptr; cache = cache->next_)
+    {
+        allocations += cache->allocations_.load(std::memory_order_relaxed);
+        deallocations += cache->deallocations_.load(std::memory_order_relaxed);
+    }
+
+    // The difference is signed (the counters can wrap). A block allocated by a thread whose counter was 
+    // already read and freed by one whose counter wasn't is only counted as a free.
+    int difference = static_cast<int>(allocations - deallocations);
+    unsigned inUse = difference > 0 ? static_cast<unsigned>(difference) : 0;
+    if(inUse > stats.ObjectsInUse_)
+        inUse = stats.ObjectsInUse_;
+
+    // Whatever the shared allocator handed out that the clients don't have is cached
+    unsigned cached = stats.ObjectsInUse_ - inUse;
+
+    stats.FreeObjects_ += cached;
+    stats.ObjectsInUse_ = inUse;
+    stats.Allocations_ = allocations;
+    stats.Deallocations_ = deallocations;
+
+    return stats;
+}
+
+// ---------- Private methods -------------
+
+/**
+ * @brief Returns the calling thread's cache. The thread remembers it in one of its cache slots, so the lock
+ *        is only taken the first time (or after another allocator took the slot).
+ *
+ * @return ThreadCache*
+ */
+ConcurrentObjectAllocator::ThreadCache* ConcurrentObjectAllocator::GetThreadCache()
+{
+    CacheSlot& slot = CacheSlots[Id % CACHE_SLOTS];
+
+    if(slot.id_ == Id)
+    {
+        return slot.cache_;
+    }
+
+    std::lock_guard<std::mutex> threads(ThreadsLock);
+    std::lock_guard<std::mutex> guard(Lock);
+
+    std::thread::id self = std::this_thread::get_id();
+
+    // Look for the cache the thread already has
+    ThreadCache* cache = Caches;
+    while(cache != nullptr && cache->owner_ != self)
+    {
+        cache = cache->next_;
+    }
+
+    // Otherwise, create one
+    if(cache == nullptr)
+    {
+        try
+        {
+            cache = new ThreadCache;
+        }
+        catch(const std::bad_alloc& e)
+        {
+            throw OAException(OAException::E_NO_MEMORY, "get_thread_cache: No system memory available.");
+        }
+
+        cache->owner_ = self;
+        cache->blocks_ = nullptr;
+        cache->count_ = 0;
+        cache->allocations_.store(0, std::memory_order_relaxed);
+        cache->deallocations_.store(0, std::memory_order_relaxed);
+        cache->allocator_ = this;
+
+        // Push the cache to the front of the allocator's caches and the thread's caches
+        cache->next_ = Caches;
+        Caches = cache;
+
+        cache->thread_ = nullptr;
+        cache->threadPrevious_ = nullptr;
+        cache->threadNext_ = nullptr;
+        if(!ThreadCaches.exited_)
+        {
+            cache->thread_ = &ThreadCaches;
+            cache->threadNext_ = ThreadCaches.caches_;
+            if(ThreadCaches.caches_ != nullptr)
+                ThreadCaches.caches_->threadPrevious_ = cache;
+            ThreadCaches.caches_ = cache;
+        }
+    }
+
+    slot.id_ = Id;
+    slot.cache_ = cache;
+
+    return cache;
+}
+
+/**
+ * @brief Returns how many of the given number of blocks the shared allocator can hand out. AllocateN takes 
+ *        nothing if the batch doesn't fit in the remaining pages, so near the last page the batch is cut to 
+ *        what's left (at least 1, so running out throws the shared allocator's exception).
+ *
+ * @param count - the blocks wanted
+ * @return unsigned - the blocks to ask for
+ */
+unsigned ConcurrentObjectAllocator::BatchSize(unsigned count) const
+{
+    OAConfig config = Pool.GetConfig();
+    OAStats stats = Pool.GetStats();
+
+    // 0 max pages means unlimited
+    if(config.MaxPages_ == 0)
+        return count;
+
+    unsigned available = stats.FreeObjects_;
+    if(stats.PagesInUse_ < config.MaxPages_)
+        available += (config.MaxPages_ - stats.PagesInUse_) * config.ObjectsPerPage_;
+
+    if(available >= count)
+        return count;
+
+    return available > 0 ? available : 1;
+}
+
+/**
+ * @brief Moves half a magazine of blocks from the shared allocator to the cache, taking them with one call 
+ *        to AllocateN. If the shared allocator runs out before any block was moved, its exception is passed 
+ *        on to the client.
+ *
+ * @param cache - the calling thread's cache
+ * @param label - the label to assign an external block
+ */
+void ConcurrentObjectAllocator::Refill(ThreadCache *cache, const char *label)
+{
+    std::lock_guard<std::mutex> guard(Lock);
+
+    unsigned count = BatchSize(MagazineSize / 2 > 0 ? MagazineSize / 2 : 1);
+
+    Pool.AllocateN(Batch.data(), count, label);
+
+    for(unsigned i = 0; i < count; ++i)
+    {
+        GenericObject* block = static_cast<GenericObject*>(Batch[i]);
+        block->Next = cache->blocks_;
+        cache->blocks_ = block;
+    }
+
+    cache->count_ += count;
+}
+
+/**
+ * @brief Moves the given number of blocks from the cache back to the shared allocator.
+ *
+ * @param cache - the calling thread's cache
+ * @param count - how many blocks to move
+ */
+void ConcurrentObjectAllocator::Drain(ThreadCache *cache, unsigned count)
+{
+    std::lock_guard<std::mutex> guard(Lock);
+
+    unsigned moved = 0;
+
+    for(; moved < count && cache->blocks_ != nullptr; ++moved)
+    {
+        GenericObject* block = cache->blocks_;
+        cache->blocks_ = block->Next;
+
+        Pool.Free(block);
+    }
+
+    cache->count_ -= moved;
+}
+
+/**
+ * @brief Gives every block of an exiting thread's cache back to the shared allocator, adds its counters to 
+ *        the retired ones (so GetStats still counts them) and deletes it. The cache was already taken off 
+ *        the thread's list.
+ *
+ * @param cache - the cache of the exiting thread
+ */
+void ConcurrentObjectAllocator::RetireThreadCache(ThreadCache *cache)
+{
+    Drain(cache, cache->count_);
+
+    std::lock_guard<std::mutex> guard(Lock);
+
+    RetiredAllocations += cache->allocations_.load(std::memory_order_relaxed);
+    RetiredDeallocations += cache->deallocations_.load(std::memory_order_relaxed);
+
+    // Take the cache off the allocator's caches
+    ThreadCache** link = &Caches;
+    while((*link) != cache)
+    {
+        link = &(*link)->next_;
+    }
+    (*link) = cache->next_;
+
+    delete cache;
+}
+
+/**
+ * @brief Takes a cache off the list of caches of the thread that owns it.
+ *
+ * @param cache - the cache
+ */
+void ConcurrentObjectAllocator::UnlinkThreadCache(ThreadCache *cache)
+{
+    if(cache->thread_ == nullptr)
+        return;
+
+    if(cache->threadPrevious_ != nullptr)
+        cache->threadPrevious_->threadNext_ = cache->threadNext_;
+    else
+        cache->thread_->caches_ = cache->threadNext_;
+
+    if(cache->threadNext_ != nullptr)
+        cache->threadNext_->threadPrevious_ = cache->threadPrevious_;
+}
+
+/**
+ * @brief Pops a block from the lock-free stack. If the stack is empty, it gets refilled from the shared 
+ *        allocator first.
+ *
+ * @param label - the label to assign an external block
+ * @return GenericObject* - the popped block, or nullptr if the stack fell back to the magazines
+ */
+GenericObject* ConcurrentObjectAllocator::PopFreeStack(const char *label)
+{
+    std::uint64_t head = FreeStack.load(std::memory_order_acquire);
+
+    for(;;)
+    {
+        GenericObject* block = HeadBlock(head);
+
+        if(block == nullptr)
+        {
+            if(!RefillFreeStack(label))
+                return nullptr;
+
+            head = FreeStack.load(std::memory_order_acquire);
+
+            continue;
+        }
+
+        // Another thread can pop this block and change its Next before we swap, but then the tag has
+        // changed too and the swap fails
+        std::uint64_t next = PackHead(NextLink(block).load(std::memory_order_relaxed), HeadTag(head) + 1);
+
+        if(FreeStack.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire))
+        {
+            return block;
+        }
+    }
+}
+
+/**
+ * @brief Pushes a chain of blocks onto the lock-free stack with one compare-and-swap, so the whole chain 
+ *        shows up to the other threads at once.
+ *
+ * @param first - the first block of the chain
+ * @param last - the last block of the chain (the same as first for one block)
+ */
+void ConcurrentObjectAllocator::PushFreeStack(GenericObject *first, GenericObject *last)
+{
+    std::uint64_t head = FreeStack.load(std::memory_order_relaxed);
+
+    do
+    {
+        NextLink(last).store(HeadBlock(head), std::memory_order_relaxed);
+    }
+    while(!FreeStack.compare_exchange_weak(head, PackHead(first, HeadTag(head) + 1), std::memory_order_release, std::memory_order_relaxed));
+}
+
+/**
+ * @brief Moves MagazineSize blocks from the shared allocator to the lock-free stack, taking them with one 
+ *        call to AllocateN. The blocks are linked privately and then pushed as one chain. Nothing is moved 
+ *        if another thread already refilled it. If a block's address doesn't fit beside the tag, the blocks 
+ *        go back to the shared allocator and the magazines are used from then on.
+ *
+ * @param label - the label to assign an external block
+ * @return bool - false if the stack fell back to the magazines
+ */
+bool ConcurrentObjectAllocator::RefillFreeStack(const char *label)
+{
+    std::lock_guard<std::mutex> guard(Lock);
+
+    if(!UseFreeStack.load(std::memory_order_relaxed))
+        return false;
+
+    // Another thread may have refilled it while we were waiting for the lock
+    if(HeadBlock(FreeStack.load(std::memory_order_acquire)) != nullptr)
+        return true;
+
+    unsigned count = BatchSize(MagazineSize);
+
+    Pool.AllocateN(Batch.data(), count, label);
+
+    for(unsigned i = 0; i < count; ++i)
+    {
+        if(!FitsFreeStack(Batch[i]))
+        {
+            Pool.FreeN(Batch.data(), count);
+            UseFreeStack.store(false, std::memory_order_relaxed);
+
+            return false;
+        }
+    }
+
+    // Link the blocks into one chain
+    for(unsigned i = 0; i + 1 < count; ++i)
+    {
+        static_cast<GenericObject*>(Batch[i])->Next = static_cast<GenericObject*>(Batch[i + 1]);
+    }
+
+    PushFreeStack(static_cast<GenericObject*>(Batch[0]), static_cast<GenericObject*>(Batch[count - 1]));
+
+    return true;
+}
+
+/**
+ * @brief Returns the Next pointer of a block on the lock-free stack as an atomic. A popping thread can read it
+ *        while another thread pushes the same block again, so both sides have to access it atomically.
+ *
+ * @param block - the block
+ * @return std::atomic<GenericObject*>& - the block's Next pointer
+ */
+std::atomic<GenericObject*>& ConcurrentObjectAllocator::NextLink(GenericObject *block)
+{
+    static_assert(sizeof(std::atomic<GenericObject*>) == sizeof(GenericObject*), "atomic pointers must fit in a block's Next pointer");
+
+    return *reinterpret_cast<std::atomic<GenericObject*>*>(&block->Next);
+}
+
+/**
+ * @brief Packs a block and a tag into one word for the head of the lock-free stack.
+ *
+ * @param block - the first block of the stack
+ * @param tag - the tag (only the bits that fit are kept)
+ * @return std::uint64_t - the head
+ */
+std::uint64_t ConcurrentObjectAllocator::PackHead(GenericObject *block, std::uint64_t tag)
+{
+    return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(block)) | (tag << TAG_SHIFT);
+}
+
+/**
+ * @brief Returns whether a block's address fits below the tag of a lock-free stack head. User space addresses 
+ *        are 48 bits on most 64-bit systems, but not all of them (5-level paging gives 57).
+ *
+ * @param block - the block
+ * @return bool - true if the block can be pushed onto the lock-free stack
+ */
+bool ConcurrentObjectAllocator::FitsFreeStack(const void *block)
+{
+    return (static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(block)) & ~ADDRESS_MASK) == 0;
+}
+
+/**
+ * @brief Returns the block packed in a lock-free stack head.
+ *
+ * @param head - the head
+ * @return GenericObject* - the first block of the stack
+ */
+GenericObject* ConcurrentObjectAllocator::HeadBlock(std::uint64_t head)
+{
+    return reinterpret_cast<GenericObject*>(static_cast<std::uintptr_t>(head & ADDRESS_MASK));
+}
+
+/**
+ * @brief Returns the tag packed in a lock-free stack head.
+ *
+ * @param head - the head
+ * @return std::uint64_t - the tag
+ */
+std::uint64_t ConcurrentObjectAllocator::HeadTag(std::uint64_t head)
+{
+    return head >> TAG_SHIFT;
+}
+
+/**
+ * @brief Bumps a counter that only the calling thread writes to. Other threads only read it, so it doesn't
+ *        need an atomic read-modify-write (a plain load and store is enough).
+ *
+ * @param counter - the counter to bump
+ * @param amount - how much to add
+ */
+void ConcurrentObjectAllocator::Increment(std::atomic<unsigned> &counter, unsigned amount)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
@@ -0,0 +1,206 @@
+/**
+ * @file ConcurrentObjectAllocator.h
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief This is a thread-safe front-end for the Object Allocator (OA). Each thread keeps a small magazine
+ *        of free blocks that it allocates from and frees to without locking. When a thread's magazine
+ *        runs empty or fills up, half of it is refilled from or drained back to the shared OA under a lock,
+ *        so the lock is taken once per batch instead of once per call. Instead of magazines, the free
+ *        blocks can also be kept on one lock-free stack shared by all the threads.
+ * @date 10-14-2026
+ */
+
+//---------------------------------------------------------------------------
+#ifndef CONCURRENTOBJECTALLOCATORH
+#define CONCURRENTOBJECTALLOCATORH
+//---------------------------------------------------------------------------
+
+#include "ObjectAllocator.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <vector>
+
+// If the client doesn't specify it:
+static const unsigned DEFAULT_MAGAZINE_SIZE = 64;
+
+/*!
+  This class is an ObjectAllocator that can be shared by many threads
+*/
+class ConcurrentObjectAllocator
+{
+  public:
+    /*!
+      Where the free blocks are kept in front of the shared ObjectAllocator
+    */
+    enum CACHE_TYPE
+    {
+      ctMagazines, //!< each thread caches up to MagazineSize free blocks
+      ctLockFree   //!< one lock-free stack shared by all the threads, refilled MagazineSize blocks at a time (falls
+                   //!< back to the magazines if a block's address is too wide to pack with the stack's tag)
+    };
+
+      // Creates the shared ObjectAllocator per the specified values. With magazines, each thread caches up 
+      // to MagazineSize free blocks (0 means no caching, every call takes the lock).
+      // Throws an exception if the construction fails. (Memory allocation problem)
+    ConcurrentObjectAllocator(size_t ObjectSize, const OAConfig& config, unsigned MagazineSize = DEFAULT_MAGAZINE_SIZE,
+                              CACHE_TYPE CacheType = ctMagazines);
+
+      // Destroys the thread caches and the shared ObjectAllocator (never throws)
+    ~ConcurrentObjectAllocator();
+
+      // Takes an object from the calling thread's magazine (or the lock-free stack), refilling it if it's empty
+      // Throws an exception if the object can't be allocated. (Memory allocation problem)
+    void *Allocate(const char *label = 0);
+
+      // Returns an object to the calling thread's magazine (or the lock-free stack), draining it if it's full
+      // Throws an exception if the the object can't be freed. (Invalid object)
+    void Free(void *Object);
+
+      // Gives every block in the calling thread's magazine back to the shared ObjectAllocator (done for every 
+      // allocator a thread used when the thread exits)
+    void FlushThreadCache();
+
+      // Frees all empty pages of the shared ObjectAllocator (blocks in magazines count as in use). With the
+      // lock-free stack, the stack is emptied first, so no other thread may use the allocator during the call.
+    unsigned FreeEmptyPages();
+
+      // Testing/Debugging/Statistic methods
+    OAConfig GetConfig() const;       // returns the configuration parameters
+    OAStats GetStats() const;         // returns the statistics as seen by the clients (the most objects counts cached blocks)
+
+      // Instrumentation of the shared ObjectAllocator (only counted when compiled with OA_INSTRUMENT)
+    void SetLatencySampling(unsigned SampleEvery);   // time 1 of every SampleEvery calls (0=off)
+    OAInstrumentation GetInstrumentation() const;    // returns the instrumentation counters
+
+      // Prevent copy construction and assignment
+    ConcurrentObjectAllocator(const ConcurrentObjectAllocator &oa) = delete;            //!< Do not implement!
+    ConcurrentObjectAllocator &operator=(const ConcurrentObjectAllocator &oa) = delete; //!< Do not implement!
+
+  private:
+    struct ThreadCacheList;
+
+    /*!
+      The free blocks and counters of one thread. Only the owning thread changes them, the counters are
+      atomic so GetStats can read them from other threads.
+    */
+    struct ThreadCache
+    {
+      std::thread::id owner_;                //!< the thread using this cache
+      GenericObject *blocks_;                //!< the magazine (a list of free blocks)
+      unsigned count_;                       //!< number of blocks in the magazine
+      std::atomic<unsigned> allocations_;    //!< requests to allocate memory made by the thread
+      std::atomic<unsigned> deallocations_;  //!< requests to free memory made by the thread
+      ThreadCache *next_;                    //!< the next cache of the same allocator
+      ConcurrentObjectAllocator *allocator_; //!< the allocator the cache belongs to
+      ThreadCacheList *thread_;              //!< the caches of the same thread (nullptr if it was exiting)
+      ThreadCache *threadPrevious_;          //!< the previous cache of the same thread
+      ThreadCache *threadNext_;              //!< the next cache of the same thread
+    };
+
+    /*!
+      The caches of one thread (one for each allocator it used). When the thread exits, each magazine is 
+      given back to its allocator and the cache is deleted.
+    */
+    struct ThreadCacheList
+    {
+      ThreadCache *caches_; //!< the first of the thread's caches
+      bool exited_;         //!< the thread is exiting, caches made from now on aren't put on the list
+
+      ~ThreadCacheList();
+    };
+
+    /*!
+      Remembers the cache a thread uses for one allocator, so finding it doesn't take the lock
+    */
+    struct CacheSlot
+    {
+      unsigned id_;        //!< the Id of the allocator (0 for an unused slot)
+      ThreadCache *cache_; //!< the thread's cache for that allocator
+    };
+
+    static const unsigned CACHE_SLOTS = 16; //!< number of allocators a thread remembers at once
+
+    static thread_local CacheSlot CacheSlots[CACHE_SLOTS]; //!< the calling thread's remembered caches
+    static thread_local ThreadCacheList ThreadCaches;      //!< the calling thread's caches
+    static std::mutex ThreadsLock;                         //!< guards the caches lists of every thread
+    static std::atomic<unsigned> NextId;                   //!< the Id of the next allocator created
+
+    // Returns the calling thread's cache, creating it if needed.
+    ThreadCache *GetThreadCache();
+
+    // Returns how many of count blocks the shared ObjectAllocator can hand out (Lock must be held).
+    unsigned BatchSize(unsigned count) const;
+
+    // Moves half a magazine of blocks from the shared ObjectAllocator to the cache.
+    void Refill(ThreadCache *cache, const char *label);
+
+    // Moves the given number of blocks from the cache back to the shared ObjectAllocator.
+    void Drain(ThreadCache *cache, unsigned count);
+
+    // Gives the blocks of an exiting thread's cache back, keeps its counters and deletes it.
+    void RetireThreadCache(ThreadCache *cache);
+
+    // Takes a cache off its thread's list of caches (ThreadsLock must be held).
+    static void UnlinkThreadCache(ThreadCache *cache);
+
+    // Pops a block from the lock-free stack, refilling the stack if it's empty.
+    GenericObject *PopFreeStack(const char *label);
+
+    // Pushes a chain of blocks (first to last, already linked) onto the lock-free stack.
+    void PushFreeStack(GenericObject *first, GenericObject *last);
+
+    // Moves MagazineSize blocks from the shared ObjectAllocator to the lock-free stack (if it's still empty).
+    // Returns false if a block doesn't fit in the stack's head, then the magazines are used instead.
+    bool RefillFreeStack(const char *label);
+
+    // Returns the Next pointer of a block on the lock-free stack as an atomic.
+    static std::atomic<GenericObject*> &NextLink(GenericObject *block);
+
+    // Packs a block and a tag into one word for the head of the lock-free stack.
+    static std::uint64_t PackHead(GenericObject *block, std::uint64_t tag);
+    // Returns whether a block's address fits beside the tag of a lock-free stack head.
+    static bool FitsFreeStack(const void *block);
+    // Returns the block packed in a lock-free stack head.
+    static GenericObject *HeadBlock(std::uint64_t head);
+    // Returns the tag packed in a lock-free stack head.
+    static std::uint64_t HeadTag(std::uint64_t head);
+
+    // Bumps a counter that only the calling thread writes to (no atomic read-modify-write needed).
+    static void Increment(std::atomic<unsigned> &counter, unsigned amount = 1);
+
+  private:
+    mutable std::mutex Lock; //!< guards Pool and Caches
+    ObjectAllocator Pool;    //!< the shared allocator the magazines are filled from
+    ThreadCache *Caches;     //!< the caches of every thread that used this allocator
+
+    // room for the blocks of one refill, taken from the shared allocator with one AllocateN (guarded by Lock)
+    std::vector<void*> Batch;
+
+    // the allocations and frees made by threads that have exited (their caches are gone)
+    unsigned RetiredAllocations;
+    unsigned RetiredDeallocations;
+
+    // the most blocks a thread's magazine can hold
+    unsigned MagazineSize;
+
+    // false when the magazines (and the lock-free stack) are by-passed (debug checks, external headers, 
+    // objects smaller than a pointer and new/delete need every call)
+    bool UseMagazines;
+
+    // what the free blocks are kept in when UseMagazines is true
+    CACHE_TYPE CacheType;
+
+    // true while the lock-free stack is used, false once a block's address didn't fit beside the tag (the 
+    // magazines are used from then on, the blocks left on the stack are given back by FreeEmptyPages)
+    std::atomic<bool> UseFreeStack;
+
+    // the head of the lock-free stack: the first block plus a tag that changes on every push and pop, so a 
+    // compare-and-swap fails if the head was popped and pushed back in the meantime (ABA)
+    std::atomic<std::uint64_t> FreeStack;
+
+    // identifies this allocator in the threads' cache slots (never reused)
+    unsigned Id;
+};
+
+#endif
@@ -0,0 +1,252 @@
+/**
+ * @file NumaObjectAllocator.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief This is a NUMA-aware front-end for the Object Allocator (OA). It owns one OA per NUMA node, each
+ *        with its pages bound to its node, and sends each allocation to the OA of the node the calling
+ *        thread is running on, so the objects a thread uses stay on its socket. Frees go back to the OA
+ *        that owns the block, whichever node the freeing thread is on. Each node's OA has its own lock.
+ * @date 10-14-2026
+ */
+
+#include "NumaObjectAllocator.h"
+#include <cstdio>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Returns the number of NUMA nodes the system can have, read from the last node listed as possible.
+ *
+ * @param possible - the file listing the possible nodes
+ * @return unsigned - the number of nodes (1 if it can't be found)
+ */
+unsigned NumaObjectAllocator::NodeCount(const char* possible)
+{
+    unsigned count = 1;
+
+#if defined(__linux__)
+    // The file lists the nodes as ranges, like "0" or "0-1"
+    std::FILE* file = std::fopen(possible, "r");
+    if(file == nullptr)
+        return count;
+
+    unsigned first = 0;
+    unsigned last = 0;
+    if(std::fscanf(file, "%u", &first) == 1)
+    {
+        last = first;
+
+        while(std::fscanf(file, "%*[-,]%u", &last) == 1)
+        {
+        }
+
+        count = last + 1;
+    }
+
+    std::fclose(file);
+#else
+    (void)possible;
+#endif
+
+    return count;
+}
+
+/**
+ * @brief Returns the NUMA node the calling thread is running on. The thread can move to another node right
+ *        after, so this is only where it's likely to be.
+ *
+ * @return unsigned - the node (0 if it can't be found)
+ */
+unsigned NumaObjectAllocator::CurrentNode()
+{
+    unsigned cpu = 0;
+    unsigned node = 0;
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+    // Doesn't enter the kernel on most systems
+    if(getcpu(&cpu, &node) != 0)
+        node = 0;
+#elif defined(__linux__) && defined(SYS_getcpu)
+    if(syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+        node = 0;
+#endif
+
+    (void)cpu;
+
+    return node;
+}
+
+/**
+ * @brief Creates an object allocator for each node, with its pages bound to that node.
+ *
+ * @param ObjectSize - the size of each object
+ * @param config - the configuration settings every node uses (the NUMA node is set for each)
+ * @param Nodes - the number of nodes to keep an allocator for
+ */
+NumaObjectAllocator::NumaObjectAllocator(size_t ObjectSize, const OAConfig& config, unsigned Nodes) : Pools(nullptr), Nodes(Nodes > 0 ? Nodes : 1)
+{
+    try
+    {
+        Pools = new NodePool[this->Nodes];
+    }
+    catch(const std::bad_alloc& e)
+    {
+        throw OAException(OAException::E_NO_MEMORY, "NumaObjectAllocator: No system memory available.");
+    }
+
+    for(unsigned i = 0; i < this->Nodes; ++i)
+        Pools[i].pool_ = nullptr;
+
+    try
+    {
+        for(unsigned i = 0; i < this->Nodes; ++i)
+        {
+            OAConfig nodeConfig = config;
+            nodeConfig.NumaNode_ = static_cast<int>(i);
+
+            Pools[i].pool_ = new ObjectAllocator(ObjectSize, nodeConfig);
+        }
+    }
+    catch(const std::bad_alloc& e)
+    {
+        for(unsigned i = 0; i < this->Nodes; ++i)
+            delete Pools[i].pool_;
+        delete [] Pools;
+
+        throw OAException(OAException::E_NO_MEMORY, "NumaObjectAllocator: No system memory available.");
+    }
+    catch(const OAException& e)
+    {
+        for(unsigned i = 0; i < this->Nodes; ++i)
+            delete Pools[i].pool_;
+        delete [] Pools;
+
+        throw;
+    }
+}
+
+/**
+ * @brief Destroys the allocator of every node (along with its pages).
+ */
+NumaObjectAllocator::~NumaObjectAllocator()
+{
+    for(unsigned i = 0; i < Nodes; ++i)
+        delete Pools[i].pool_;
+
+    delete [] Pools;
+}
+
+/**
+ * @brief Allocates a block from the allocator of the calling thread's node.
+ *
+ * @param label - the label to assign an external block
+ * @return void* - The allocated block
+ */
+void* NumaObjectAllocator::Allocate(const char *label)
+{
+    return AllocateOnNode(LocalNode(), label);
+}
+
+/**
+ * @brief Allocates a block from the allocator of the given node.
+ *
+ * @param node - the node (nodes past the ones with an allocator wrap around)
+ * @param label - the label to assign an external block
+ * @return void* - The allocated block
+ */
+void* NumaObjectAllocator::AllocateOnNode(unsigned node, const char *label)
+{
+    NodePool& pool = Pools[node % Nodes];
+
+    std::lock_guard<std::mutex> guard(pool.lock_);
+
+    return pool.pool_->Allocate(label);
+}
+
+/**
+ * @brief Frees a block to the allocator that owns it. The calling thread's node is checked first, since
+ *        that's where most blocks are freed. A block no node owns (like with the CPP manager) goes to the
+ *        calling thread's node, which reports it if it's invalid.
+ *
+ * @param Object - the object to free
+ */
+void NumaObjectAllocator::Free(void *Object)
+{
+    unsigned local = LocalNode();
+
+    for(unsigned i = 0; i < Nodes; ++i)
+    {
+        NodePool& node = Pools[(local + i) % Nodes];
+
+        std::lock_guard<std::mutex> guard(node.lock_);
+
+        if(node.pool_->OwnsObject(Object))
+        {
+            node.pool_->Free(Object);
+
+            return;
+        }
+    }
+
+    NodePool& node = Pools[local];
+
+    std::lock_guard<std::mutex> guard(node.lock_);
+
+    node.pool_->Free(Object);
+}
+
+/**
+ * @brief Frees all the empty pages of every node.
+ *
+ * @return unsigned - Number of pages freed
+ */
+unsigned NumaObjectAllocator::FreeEmptyPages()
+{
+    unsigned numFreed = 0;
+
+    for(unsigned i = 0; i < Nodes; ++i)
+    {
+        std::lock_guard<std::mutex> guard(Pools[i].lock_);
+
+        numFreed += Pools[i].pool_->FreeEmptyPages();
+    }
+
+    return numFreed;
+}
+
+/**
+ * @brief Returns the number of nodes with an allocator.
+ *
+ * @return unsigned
+ */
+unsigned NumaObjectAllocator::GetNodes() const
+{
+    return Nodes;
+}
+
+/**
+ * @brief Returns the statistics of a node's allocator.
+ *
+ * @param node - the node
+ * @return OAStats
+ */
+OAStats NumaObjectAllocator::GetNodeStats(unsigned node) const
+{
+    std::lock_guard<std::mutex> guard(Pools[node].lock_);
+
+    return Pools[node].pool_->GetStats();
+}
+
+/**
+ * @brief Returns the node whose allocator the calling thread should use (nodes past the ones with an
+ *        allocator wrap around).
+ *
+ * @return unsigned - the node
+ */
+unsigned NumaObjectAllocator::LocalNode() const
+{
+    return CurrentNode() % Nodes;
+}
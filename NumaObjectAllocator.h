@@ -0,0 +1,81 @@
+/**
+ * @file NumaObjectAllocator.h
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief This is a NUMA-aware front-end for the Object Allocator (OA). It owns one OA per NUMA node, each
+ *        with its pages bound to its node, and sends each allocation to the OA of the node the calling
+ *        thread is running on, so the objects a thread uses stay on its socket. Frees go back to the OA
+ *        that owns the block, whichever node the freeing thread is on. Each node's OA has its own lock.
+ * @date 10-14-2026
+ */
+
+//---------------------------------------------------------------------------
+#ifndef NUMAOBJECTALLOCATORH
+#define NUMAOBJECTALLOCATORH
+//---------------------------------------------------------------------------
+
+#include "ObjectAllocator.h"
+#include <mutex>
+
+/*!
+  This class keeps one ObjectAllocator per NUMA node that can be shared by many threads
+*/
+class NumaObjectAllocator
+{
+  public:
+      // Returns the number of NUMA nodes the system can have, read from the file listing the possible 
+      // nodes (1 if it can't be found).
+    static unsigned NodeCount(const char *possible = "/sys/devices/system/node/possible");
+
+      // Returns the NUMA node the calling thread is running on (0 if it can't be found).
+    static unsigned CurrentNode();
+
+      // Creates an ObjectAllocator for each of the nodes with the same configuration, except that each
+      // one's pages are bound to its node. Throws an exception if the construction fails. (Memory allocation problem)
+    NumaObjectAllocator(size_t ObjectSize, const OAConfig& config, unsigned Nodes = NodeCount());
+
+      // Destroys the ObjectAllocator of every node (never throws)
+    ~NumaObjectAllocator();
+
+      // Takes an object from the ObjectAllocator of the calling thread's node
+      // Throws an exception if the object can't be allocated. (Memory allocation problem)
+    void *Allocate(const char *label = 0);
+
+      // Takes an object from the ObjectAllocator of the given node (nodes past the ones with an 
+      // ObjectAllocator wrap around)
+      // Throws an exception if the object can't be allocated. (Memory allocation problem)
+    void *AllocateOnNode(unsigned node, const char *label = 0);
+
+      // Returns an object to the ObjectAllocator of the node that owns it
+      // Throws an exception if the the object can't be freed. (Invalid object)
+    void Free(void *Object);
+
+      // Frees all empty pages of every node
+    unsigned FreeEmptyPages();
+
+      // Testing/Debugging/Statistic methods
+    unsigned GetNodes() const;                  // returns the number of nodes with an ObjectAllocator
+    OAStats GetNodeStats(unsigned node) const;  // returns the statistics of a node's ObjectAllocator
+
+      // Prevent copy construction and assignment
+    NumaObjectAllocator(const NumaObjectAllocator &noa) = delete;            //!< Do not implement!
+    NumaObjectAllocator &operator=(const NumaObjectAllocator &noa) = delete; //!< Do not implement!
+
+  private:
+    /*!
+      The ObjectAllocator of one node and the lock guarding it
+    */
+    struct NodePool
+    {
+      mutable std::mutex lock_; //!< guards pool_
+      ObjectAllocator *pool_;   //!< the allocator with its pages on the node
+    };
+
+    // Returns the node whose ObjectAllocator should be used by the calling thread.
+    unsigned LocalNode() const;
+
+  private:
+    NodePool *Pools; //!< the pool of each node
+    unsigned Nodes;  //!< the number of pools
+};
+
+#endif
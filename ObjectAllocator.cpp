@@ -10,27 +10,301 @@
  */
 
 #include "ObjectAllocator.h"
+#include "AllocationTrace.h"
 #include <cstring>
+#include <climits>
+#include <algorithm>
+#include <new>
+#include <chrono>
+
+#ifdef OA_INSTRUMENT
+
+// Counts an instrumentation event
+#define OA_COUNT(counter) (instrumentation.counter++)
+
+namespace
+{
+  /*!
+    Times a call from its construction to its destruction and adds it to a latency histogram
+  */
+  class LatencySample
+  {
+    public:
+      // Starts timing if there's a histogram (nullptr if the call isn't sampled)
+      explicit LatencySample(unsigned* histogram) : histogram_(histogram)
+      {
+        if(histogram_ != nullptr)
+          start_ = std::chrono::steady_clock::now();
+      }
+
+      // Adds the time since the start to the bucket of its power of 2
+      ~LatencySample()
+      {
+        if(histogram_ == nullptr)
+          return;
+
+        long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+
+        unsigned bucket = 0;
+        while(bucket + 1 < LATENCY_BUCKETS && (nanoseconds >> (bucket + 1)) > 0)
+          bucket++;
+
+        histogram_[bucket]++;
+      }
+
+    private:
+      unsigned* histogram_;                          //!< where the latency goes
+      std::chrono::steady_clock::time_point start_;  //!< when the call started
+  };
+}
+
+// Times the rest of the call if it's sampled
+#define OA_SAMPLE_LATENCY(histogram) LatencySample latencySample(SampleLatency(instrumentation.histogram))
+#else
+#define OA_COUNT(counter) ((void)0)
+#define OA_SAMPLE_LATENCY(histogram) ((void)0)
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define OA_HAS_MMAP
+#endif
+
+// Marks the start of a mapped file holding a pool ("OAMAPPED")
+static const std::uint64_t MAPPED_FILE_MAGIC = 0x4F414D4150504544ull;
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(SYS_mbind)
+#define OA_HAS_MBIND
+
+// The mbind policy that only allows the given nodes (from numaif.h, without needing libnuma)
+static const int OA_MPOL_BIND = 2;
+#endif
+#endif
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define OA_HAS_BACKTRACE
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+  /**
+   * @brief Checks if every byte of a range is the given pattern. 16 bytes are compared at a time with 
+   *        SSE2 or NEON when they're available, then 8 bytes at a time, then the bytes left one at a time.
+   * 
+   * @param bytes - the start of the range
+   * @param count - the number of bytes
+   * @param pattern - the byte every byte should be
+   * @return whether every byte is the pattern
+   */
+  bool IsPattern(const unsigned char* bytes, size_t count, unsigned char pattern)
+  {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i patterns = _mm_set1_epi8(static_cast<char>(pattern));
+    for(; i + 16 <= count; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+      if(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, patterns)) != 0xFFFF)
+        return false;
+    }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    const uint8x16_t patterns = vdupq_n_u8(pattern);
+    for(; i + 16 <= count; i += 16)
+    {
+      if(vminvq_u8(vceqq_u8(vld1q_u8(bytes + i), patterns)) != 0xFF)
+        return false;
+    }
+#endif
+
+    // The pattern in every byte of a word
+    const std::uint64_t words = 0x0101010101010101ULL * pattern;
+    for(; i + 8 <= count; i += 8)
+    {
+      std::uint64_t chunk;
+      memcpy(&chunk, bytes + i, sizeof(chunk));
+
+      if(chunk != words)
+        return false;
+    }
+
+    for(; i < count; ++i)
+    {
+      if(bytes[i] != pattern)
+        return false;
+    }
+
+    return true;
+  }
+}
 
 /**
  * @brief Creates and sets the configurations and stats for the object allocator. Allocates the first page.
+ *        With a mapped file, the pages are kept in the file instead (reopening the pool saved in it).
  * 
  * @param ObjectSize - the size each object in the allocator will be
  * @param config - the configuration settings (objects per page, pad bytes, etc.)
+ * @param MappedFile - the file to keep the pages in (nullptr to allocate them from the system)
  */
-ObjectAllocator::ObjectAllocator(size_t ObjectSize, const OAConfig& config)
+ObjectAllocator::ObjectAllocator(size_t ObjectSize, const OAConfig& config, const char *MappedFile)
 {
     PageList_ = nullptr;
     FreeList_ = nullptr;
+    HeaderPool = nullptr;
+    MappedHeader = nullptr;
+    ReleasedPages = nullptr;
+    Trace = nullptr;
+    LabelArena = nullptr;
+    LabelArenaUsed = 0;
+    LabelArenaSize = 0;
+    CurrentChunk = nullptr;
+    NextReservedPage = nullptr;
+    ReservedPages = 0;
+    NextChunkPages = 1;
+    LatencyCountdown = 0;
+    AllocationSampleEvery = 0;
+    AllocationCountdown = 0;
+    SampleRandom = 2463534242u;
+    FrontierPage = nullptr;
+    FrontierBlocks = 0;
+    ValidatePage = nullptr;
+    ValidateBlock = 0;
+    ValidateSweeps = 0;
+    CompactTo = 0;
+    CompactFrom = 0;
+    CompactToIndex = 0;
+    CompactFromIndex = 0;
+    CompactFreeTail = nullptr;
+    CompactPlanned = false;
+    CompactAllocations = 0;
+    CompactDeallocations = 0;
+    CompactPagesInUse = 0;
+    RemoteFrees.store(nullptr, std::memory_order_relaxed);
 
     // Initialize config
     this->config = config;
 
     stats.ObjectSize_ = ObjectSize;
 
-    // Calculate the size of each block, including the object, the header block, and the 2 pad blocks
-    FullBlockSize = ObjectSize + config.PadBytes_ * 2 + config.HBlockInfo_.size_;
-    stats.PageSize_ = FullBlockSize * config.ObjectsPerPage_ + sizeof(GenericObject*); // Set the page size
+    // Objects smaller than a pointer can't hold the free list links, their free blocks have to be kept in 
+    // the page bitmaps (address ordered or most full page reuse)
+    if(ObjectSize < sizeof(GenericObject*) && !config.UseCPPMemManager_ && config.Reuse_ == OAConfig::rtLIFO)
+        throw OAException(OAException::E_BAD_CONFIG, "ObjectAllocator: Objects smaller than a pointer can't use LIFO reuse.");
+
+    // The header blocks in the side table take no room between the blocks
+    InlineHeaderSize = config.SideTableHeaders_ ? 0 : config.HBlockInfo_.size_;
+
+    // Guard pages need the pages to be mapped on system pages (huge pages can't be protected one by one). 
+    // A mapped file has neither, its pages are mapped from the file.
+    GuardSize = 0;
+    GuardOffset = 0;
+    GuardSlack = 0;
+    if(MappedFile != nullptr)
+        this->config.HugePages_ = false;
+#ifdef OA_HAS_MMAP
+    if(config.GuardPages_ && !config.UseCPPMemManager_ && MappedFile == nullptr)
+    {
+        GuardSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        this->config.HugePages_ = false;
+    }
+#endif
+    if(GuardSize == 0)
+        this->config.GuardPages_ = false;
+
+    if(GuardSize > 0)
+    {
+        // The bytes from a block's header to the end of its right pad bytes, and the bytes after them that 
+        // keep the object on the alignment (the alignment has to divide the system page size)
+        size_t used = ObjectSize + config.PadBytes_ * 2 + InlineHeaderSize;
+        size_t slack = (config.Alignment_ > 1) ? (config.Alignment_ - (ObjectSize + config.PadBytes_) % config.Alignment_) % config.Alignment_ : 0;
+
+        // Each block (the first one after the page's Next pointer) ends on a system page, followed by its 
+        // guard page. The guard page is part of the alignment bytes in front of the next block.
+        size_t span = (sizeof(GenericObject*) + used + slack + GuardSize - 1) / GuardSize * GuardSize;
+
+        this->config.LeftAlignSize_ = static_cast<unsigned>(span - sizeof(GenericObject*) - used - slack);
+        this->config.InterAlignSize_ = static_cast<unsigned>(span + GuardSize - used);
+
+        GuardOffset = span;
+
+        if(config.DebugOn_)
+            GuardSlack = slack;
+    }
+    // Calculate the alignment bytes needed so the first block and every block after it land on the alignment
+    else if(config.Alignment_ > 1)
+    {
+        size_t leftSize = sizeof(GenericObject*) + InlineHeaderSize + config.PadBytes_;
+        size_t interSize = ObjectSize + config.PadBytes_ * 2 + InlineHeaderSize;
+
+        this->config.LeftAlignSize_ = static_cast<unsigned>((config.Alignment_ - leftSize % config.Alignment_) % config.Alignment_);
+        this->config.InterAlignSize_ = static_cast<unsigned>((config.Alignment_ - interSize % config.Alignment_) % config.Alignment_);
+    }
+    else
+    {
+        this->config.LeftAlignSize_ = 0;
+        this->config.InterAlignSize_ = 0;
+    }
+
+    // Calculate the size of each block, including the object, the header block, the 2 pad blocks and the 
+    // alignment bytes in front of it
+    FullBlockSize = ObjectSize + config.PadBytes_ * 2 + InlineHeaderSize + this->config.InterAlignSize_;
+    FirstBlockOffset = sizeof(GenericObject*) + this->config.LeftAlignSize_ + InlineHeaderSize + config.PadBytes_;
+
+    // Set the page size (there are no alignment bytes in front of the first block, the left alignment bytes are used instead)
+    stats.PageSize_ = sizeof(GenericObject*) + this->config.LeftAlignSize_ + FullBlockSize * config.ObjectsPerPage_ - this->config.InterAlignSize_;
+
+    // Each page keeps a bitmap of its allocated blocks right after the page (one bit per block). Without 
+    // header blocks it's how double frees are caught, and it lets DumpMemoryInUse skip over free blocks
+    PageBitmapSize = (config.ObjectsPerPage_ + 7) / 8;
+
+    // new only guarantees the fundamental alignment, so pages that need more are over-allocated (mapped 
+    // pages with guard pages already start on a system page)
+    PageAlignPadding = (GuardSize == 0 && config.Alignment_ > 1 && alignof(std::max_align_t) % config.Alignment_ != 0) ? config.Alignment_ - 1 : 0;
+
+    // The page info goes right after the page (moved up to its own alignment, or past the guard page after 
+    // the last block), followed by the bitmap and the side table (moved up to a pointer's alignment for 
+    // the external header blocks)
+    PageInfoOffset = (stats.PageSize_ + alignof(PageInfo) - 1) / alignof(PageInfo) * alignof(PageInfo);
+    if(GuardSize > 0)
+        PageInfoOffset = GuardOffset + (config.ObjectsPerPage_ - 1) * FullBlockSize + GuardSize;
+    SideTableOffset = (PageInfoOffset + sizeof(PageInfo) + PageBitmapSize + alignof(MemBlockInfo*) - 1) / 
+                      alignof(MemBlockInfo*) * alignof(MemBlockInfo*);
+    if(config.SideTableHeaders_)
+        PageTailSize = SideTableOffset - stats.PageSize_ + config.HBlockInfo_.size_ * config.ObjectsPerPage_;
+    else
+        PageTailSize = PageInfoOffset - stats.PageSize_ + sizeof(PageInfo) + PageBitmapSize;
+
+    // The pages of a chunk come one after another, each one starting on the alignment
+    PageStride = (stats.PageSize_ + PageTailSize + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+    if(config.Alignment_ > 1)
+        PageStride = (PageStride + config.Alignment_ - 1) / config.Alignment_ * config.Alignment_;
+
+    ChunkHeaderSize = (sizeof(PageChunk) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+    // With guard pages, every page of a chunk starts on a system page
+    if(GuardSize > 0)
+    {
+        PageStride = (PageStride + GuardSize - 1) / GuardSize * GuardSize;
+        ChunkHeaderSize = (ChunkHeaderSize + GuardSize - 1) / GuardSize * GuardSize;
+    }
+
+    // Make the page map buckets the smallest power of 2 that can hold a page
+    PageMapShift = 0;
+    while((static_cast<size_t>(1) << PageMapShift) < stats.PageSize_)
+        PageMapShift++;
 
     // If it's using the CPP manager, return so the first page doesn't get created
     if(config.UseCPPMemManager_)
@@ -38,81 +312,105 @@ ObjectAllocator::ObjectAllocator(size_t ObjectSize, const OAConfig& config)
 
     stats.FreeObjects_ = 0;
 
+    // The pages come from the file (the first page is only allocated for a new pool)
+    if(MappedFile != nullptr)
+    {
+        OpenMappedFile(MappedFile);
+
+        return;
+    }
+
+    // External header blocks come from a pool of their own instead of new
+    if(config.HBlockInfo_.type_ == OAConfig::hbExternal)
+    {
+        try
+        {
+            HeaderPool = new ObjectAllocator(sizeof(MemBlockInfo), OAConfig(false, config.ObjectsPerPage_, 0));
+        }
+        catch(const std::bad_alloc& e)
+        {
+            throw OAException(OAException::E_NO_MEMORY, "ObjectAllocator: No system memory available.");
+        }
+    }
+
     // Allocate the first page of the OA
-    AllocatePage();
+    try
+    {
+        AllocatePage();
+    }
+    catch(const OAException& e)
+    {
+        delete HeaderPool;
+
+        throw;
+    }
 }
 
 /**
- * @brief Destroy the object allocator. If the header block is external, walk through each object and 
- *        delete the allocated block. Delete each page.
+ * @brief Destroy the object allocator. The external header blocks and labels are freed all at once with 
+ *        their pool and arena. Delete each page.
  */
 ObjectAllocator::~ObjectAllocator()
 {
-    // Delete all the allocated external header blocks
-    if(config.HBlockInfo_.type_ == OAConfig::hbExternal)
-    {
-        // This will walk the pages
-        GenericObject* pageWalker = PageList_;
-
-        // This will go along the pages block to block
-        char* block = reinterpret_cast<char*>(PageList_);
-
-        block += sizeof(GenericObject*) + config.HBlockInfo_.size_ + config.PadBytes_;
+    StopTrace();
 
-        // Get the header block location
-        MemBlockInfo **externalHeaderBlock = reinterpret_cast<MemBlockInfo**>(block - config.PadBytes_ - config.HBlockInfo_.size_);
-
-        // As long as we still have pages
-        while(pageWalker != nullptr)
+#ifdef OA_HAS_MMAP
+    // The pages stay in the mapped file for the next time it's opened (saving frees the blocks queued by 
+    // FreeRemote, so they aren't kept in the file as in use)
+    if(MappedHeader != nullptr)
+    {
+        try
         {
-            // As long as we are still in the page
-            while(block < reinterpret_cast<char*>(pageWalker) + stats.PageSize_)
-            {
-                if(IsObjectInList(FreeList_, block))
-                {
-                    // If the object is in the free list, it is not allocated so just skip over it
-                    block += stats.ObjectSize_ + config.HBlockInfo_.size_ + config.PadBytes_ * 2;
-
-                    continue;
-                }
+            SaveMappedFile();
+        }
+        catch(const OAException& e)
+        {
+        }
+    }
+#endif
 
-                // Free the label
-                if((*externalHeaderBlock)->label != nullptr)
-                {
-                    delete [] (*externalHeaderBlock)->label;
+    // The queued blocks of the pages are deleted with their pages, only the CPP manager's need deleting
+    GenericObject* remote = RemoteFrees.exchange(nullptr, std::memory_order_acquire);
+    while(config.UseCPPMemManager_ && remote != nullptr)
+    {
+        GenericObject* next = remote->Next;
+        delete [] reinterpret_cast<char*>(remote);
+        remote = next;
+    }
 
-                    (*externalHeaderBlock)->label = nullptr;
-                }
-                
-                // Free the structure
-                delete (*externalHeaderBlock);
+    delete HeaderPool;
 
-                (*externalHeaderBlock) = nullptr;
+    // Delete each label arena chunk (each one starts with a pointer to the previous chunk)
+    while(LabelArena != nullptr)
+    {
+        char* previous;
+        memcpy(&previous, LabelArena, sizeof(char*));
 
-                // Go to the next block
-                block += stats.ObjectSize_ + config.HBlockInfo_.size_ + config.PadBytes_ * 2;
-                // Get the header block location
-                externalHeaderBlock = reinterpret_cast<MemBlockInfo**>(block - config.PadBytes_ - config.HBlockInfo_.size_);
-            }
+        delete [] LabelArena;
+        LabelArena = previous;
+    }
 
-            // Go to the next page
-            pageWalker = pageWalker->Next;
+#ifdef OA_HAS_MMAP
+    // The pages were saved above, only the mapping is let go of
+    if(MappedHeader != nullptr)
+    {
+        munmap(MappedHeader, MappedHeader->layout_.size_);
 
-            block = reinterpret_cast<char*>(pageWalker);
-            // Go to the first block in the page
-            block += sizeof(GenericObject*) + config.HBlockInfo_.size_ + config.PadBytes_;
-            // Get the header block location
-            externalHeaderBlock = reinterpret_cast<MemBlockInfo**>(block - config.PadBytes_ - config.HBlockInfo_.size_);
-        }
+        return;
     }
+#endif
 
     // Delete each page
     while (PageList_)
     {
         GenericObject *temp = PageList_->Next;
-        delete [] reinterpret_cast<char *>(PageList_);
+        DeletePage(reinterpret_cast<char *>(PageList_));
         PageList_ = temp;
     }
+
+    // Let go of the pages that were reserved but never handed out
+    if(CurrentChunk != nullptr && ReservedPages > 0)
+        ReleaseChunkPages(CurrentChunk, ReservedPages);
 }
 
 /**
@@ -123,22 +421,38 @@ ObjectAllocator::~ObjectAllocator()
  */
 void* ObjectAllocator::Allocate(const char *label)
 {
+    OA_SAMPLE_LATENCY(AllocateLatency_);
+
     if(config.UseCPPMemManager_)
     {
-        return AllocateWithCPPManager();
+        char* cppAllocation = AllocateWithCPPManager();
+        SampleAllocation(cppAllocation, label);
+
+        if(Trace != nullptr)
+            Trace->RecordAllocate(cppAllocation, label);
+
+        return cppAllocation;
     }
 
+    // Take back the blocks other threads freed before allocating another page
+    if(stats.FreeObjects_ <= 0 && RemoteFrees.load(std::memory_order_relaxed) != nullptr)
+        ReclaimRemoteFrees();
+
     // If we are out of free objects
     if(stats.FreeObjects_ <= 0)
     {
-        // If we have another available page
-        if(stats.PagesInUse_ < config.MaxPages_)
+        OA_COUNT(FreeListStalls_);
+
+        // If we have another available page (0 max pages means unlimited)
+        if(config.MaxPages_ == 0 || stats.PagesInUse_ < config.MaxPages_)
         {
             // Allocate another page
             AllocatePage();
         }
         else
         {
+            OA_COUNT(NoPagesHits_);
+
             // Otherwise, we are out of memory so throw an exception
             throw OAException(OAException::E_NO_PAGES, "Allocate: memory manager out of logical memory (max pages has been reached)");
 
@@ -151,396 +465,2707 @@ void* ObjectAllocator::Allocate(const char *label)
     stats.Allocations_++;
     stats.ObjectsInUse_++;
 
-    // Get an available block (first on the free list)
-    char* availableBlock = reinterpret_cast<char*>( FreeList_ );
-    AssignHeaderBlockValues(availableBlock, true, label);
+    char* availableBlock;
+
+    // The header block is set up before the block is taken, so if there's no memory for an external header 
+    // block (or its label) the block stays free and only the stats are put back
+    try
+    {
+        if(config.Reuse_ != OAConfig::rtLIFO)
+        {
+            // Get the block the reuse policy picks
+            char* page;
+            availableBlock = NextReusedBlock(&page);
+            AssignHeaderBlockValues(availableBlock, true, label);
+
+            TakePageBlock(page, availableBlock);
+        }
+        else
+        {
+            // Set up the next page kept by Reset once the other free blocks run out
+            if(FrontierBlocks == 0 && FreeList_ == nullptr)
+                ReuseResetPage();
+
+            // Get an available block (the next uncarved block, otherwise the first on the free list)
+            availableBlock = (FrontierBlocks > 0) ? FormatBlock(FrontierPage, config.ObjectsPerPage_ - FrontierBlocks) 
+                                                  : reinterpret_cast<char*>( FreeList_ );
+            AssignHeaderBlockValues(availableBlock, true, label);
+
+            // Move to the next uncarved block or the next object in the free list
+            if(FrontierBlocks > 0)
+                FrontierBlocks--;
+            else
+                FreeList_ = FreeList_->Next;
+
+            // Keep the allocation bitmap current so double frees can be caught without walking the free list
+            if(config.DebugOn_ && config.HBlockInfo_.type_ == OAConfig::hbNone)
+                SetBlockAllocated(ObjectPageLocation(availableBlock), availableBlock, true);
+        }
+    }
+    catch(const OAException& e)
+    {
+        stats.FreeObjects_++;
+        stats.Allocations_--;
+        stats.ObjectsInUse_--;
 
-    // Move to the next object in the free list
-    FreeList_ = FreeList_->Next;
+        throw;
+    }
 
     // Set the memory to the allocated pattern
     if(config.DebugOn_)
         memset(availableBlock, ALLOCATED_PATTERN, stats.ObjectSize_); 
 
     // Update the most objects statistic
-    if(stats.Allocations_ > stats.MostObjects_)
+    if(stats.ObjectsInUse_ > stats.MostObjects_)
     {
-        stats.MostObjects_ = stats.Allocations_;
+        stats.MostObjects_ = stats.ObjectsInUse_;
     }
 
+    SampleAllocation(availableBlock, label);
+
+    if(Trace != nullptr)
+        Trace->RecordAllocate(availableBlock, label);
+
     return availableBlock;
 }
 
 /**
- * @brief Frees a block from the memory manager (adds it back to the free list).
+ * @brief Allocates n blocks at once. Any pages the batch needs are allocated first (each one is spliced onto 
+ *        the free list as one chain), then the blocks are taken off the front of the free list and the stats 
+ *        are updated once for the whole batch. With debugging on, external headers, the CPP manager, a 
+ *        reuse policy other than LIFO, allocation sampling or tracing, each block goes through Allocate so 
+ *        every check and label is done the same way.
  * 
- * @param Object - the object to free
+ * @param out - where to put the allocated blocks (room for n)
+ * @param n - the number of blocks to allocate
+ * @param label - the label to assign the external blocks
  */
-void ObjectAllocator::Free(void *Object)
+void ObjectAllocator::AllocateN(void **out, size_t n, const char *label)
 {
-    char* freedObject = reinterpret_cast<char*>(Object);
+    if(!config.UseCPPMemManager_ && n > stats.FreeObjects_ && RemoteFrees.load(std::memory_order_relaxed) != nullptr)
+        ReclaimRemoteFrees();
 
-    if(config.UseCPPMemManager_)
+    if(!config.UseCPPMemManager_ && n > stats.FreeObjects_)
     {
-        // Delete with the CPP manager if it's on
-        stats.Deallocations_++;
-        stats.ObjectsInUse_--;
+        size_t pagesNeeded = (n - stats.FreeObjects_ + config.ObjectsPerPage_ - 1) / config.ObjectsPerPage_;
 
-        delete [] freedObject;
+        // Make sure the whole batch fits before taking anything (0 max pages means unlimited)
+        if(config.MaxPages_ != 0 && stats.PagesInUse_ + pagesNeeded > config.MaxPages_)
+        {
+            OA_COUNT(NoPagesHits_);
 
-        return;
+            throw OAException(OAException::E_NO_PAGES, "AllocateN: memory manager out of logical memory (max pages has been reached)");
+        }
+
+        for(size_t i = 0; i < pagesNeeded; ++i)
+        {
+            AllocatePage();
+        }
     }
 
-    // Checks for exceptions if debug is on
-    if(config.DebugOn_)
+    if(config.UseCPPMemManager_ || config.DebugOn_ || config.HBlockInfo_.type_ == OAConfig::hbExternal || 
+       config.Reuse_ != OAConfig::rtLIFO || AllocationSampleEvery != 0 || Trace != nullptr)
     {
-        // If the client is trying to double free
-        if(IsObjectInList(FreeList_, freedObject))
+        for(size_t i = 0; i < n; ++i)
         {
-            // Throw a double free exception
-            throw OAException(OAException::E_MULTIPLE_FREE, "FreeObject: Object has already been freed.");
+            out[i] = Allocate(label);
         }
 
-        CheckForBadBoundary(freedObject);
-        
-        if(config.PadBytes_ > 0)
+        return;
+    }
+
+    unsigned firstAllocation = stats.Allocations_;
+
+    // Carve the uncarved blocks first, then take the blocks off the front of the free list
+    for(size_t i = 0; i < n; ++i)
+    {
+        if(FrontierBlocks == 0 && FreeList_ == nullptr)
+            ReuseResetPage();
+
+        char* block;
+        if(FrontierBlocks > 0)
         {
-            // Get the location of the block (the comparison with PAD_PATTERN only works if this is also an unsigned char*)
-            const unsigned char* block = static_cast<const unsigned char*>( Object );
-            if(CheckForPaddingCorruption(block))
-            {
-                throw OAException(OAException::E_CORRUPTED_BLOCK, "FreeObject: Object block has been corrupted.");
-            }
+            block = FormatBlock(FrontierPage, config.ObjectsPerPage_ - FrontierBlocks);
+            FrontierBlocks--;
+        }
+        else
+        {
+            block = reinterpret_cast<char*>(FreeList_);
+            FreeList_ = FreeList_->Next;
         }
-    }
 
-    // Reset the header block values
-    AssignHeaderBlockValues(freedObject, false);
+        out[i] = block;
 
-    // Set the memory back to the freed pattern
-    if(config.DebugOn_)
-        memset(freedObject, FREED_PATTERN, stats.ObjectSize_);
+        if(config.HBlockInfo_.type_ != OAConfig::hbNone)
+        {
+            // Number the blocks the same as separate calls to Allocate would
+            stats.Allocations_ = firstAllocation + static_cast<unsigned>(i) + 1;
+            AssignHeaderBlockValues(block, true, label);
+        }
+    }
 
-    // Put the block back on the free list
-    PushFront(&FreeList_, freedObject);
+    // Update the stats once for the whole batch
+    stats.FreeObjects_ -= static_cast<unsigned>(n);
+    stats.Allocations_ = firstAllocation + static_cast<unsigned>(n);
+    stats.ObjectsInUse_ += static_cast<unsigned>(n);
 
-    // Update the stats
-    stats.FreeObjects_++;
-    stats.Deallocations_++;
-    stats.ObjectsInUse_--;
+    // Update the most objects statistic
+    if(stats.ObjectsInUse_ > stats.MostObjects_)
+    {
+        stats.MostObjects_ = stats.ObjectsInUse_;
+    }
 }
 
 /**
- * @brief Calls the callback fn for each block in use by the client.
+ * @brief Frees a block from the memory manager (adds it back to the free list).
  * 
- * @param fn - callback
- * @return The amount of objects in use.
+ * @param Object - the object to free
  */
-unsigned ObjectAllocator::DumpMemoryInUse(DUMPCALLBACK fn) const
+void ObjectAllocator::Free(void *Object)
 {
-    // This will walk the pages
-    GenericObject* pageWalker = PageList_;
+    OA_SAMPLE_LATENCY(FreeLatency_);
 
-    // This will go along the pages block to block
-    char* allocatedBlock = reinterpret_cast<char*>(PageList_);
+    char* freedObject = reinterpret_cast<char*>(Object);
 
-    // Go to the first block
-    allocatedBlock += sizeof(GenericObject*) + config.HBlockInfo_.size_ + config.PadBytes_;
+    // Find the page the object lives on (only needed for the checks and the reuse policies)
+    char* page = nullptr;
+    if(!config.UseCPPMemManager_ && (config.DebugOn_ || config.Reuse_ != OAConfig::rtLIFO))
+        page = ObjectPageLocation(freedObject);
 
-    // As long as we still have pages
-    while(pageWalker != nullptr)
+    // Checks for exceptions if debug is on
+    OAException::OA_EXCEPTION error;
+    if(CheckFree(page, freedObject, &error))
     {
-        // As long as we are still in the page
-        while(allocatedBlock < reinterpret_cast<char*>(pageWalker) + stats.PageSize_)
+        switch(error)
         {
-            if(IsObjectInList(FreeList_, allocatedBlock))
-            {
-                // If the object is in the free list, it is not allocated so just skip over it
-                allocatedBlock += stats.ObjectSize_ + config.HBlockInfo_.size_ + config.PadBytes_ * 2;
+            case OAException::E_BAD_BOUNDARY:
+                throw OAException(error, "validate_object: Object not on a boundary.");
+            case OAException::E_MULTIPLE_FREE:
+                throw OAException(error, "FreeObject: Object has already been freed.");
+            default:
+                throw OAException(error, "FreeObject: Object block has been corrupted.");
+        }
+    }
 
-                continue;
-            }
+    ReleaseBlock(page, freedObject);
+}
 
-            // Otherwise, call the callback for the block
-            fn(allocatedBlock, stats.ObjectSize_);
+/**
+ * @brief Allocates a block like Allocate, but returns nullptr instead of throwing. Running out of pages is 
+ *        checked before calling Allocate, so pool exhaustion never throws. Only running out of system memory 
+ *        (which is rare) is thrown by Allocate and caught here.
+ * 
+ * @param label - the label to assign an external block
+ * @return void* - The allocated block, or nullptr if there was no memory
+ */
+void* ObjectAllocator::TryAllocate(const char *label) noexcept
+{
+    // If we are out of free objects and can't allocate another page (0 max pages means unlimited)
+    if(!config.UseCPPMemManager_ && stats.FreeObjects_ == 0 && config.MaxPages_ != 0 && 
+       stats.PagesInUse_ >= config.MaxPages_ && RemoteFrees.load(std::memory_order_relaxed) == nullptr)
+    {
+        OA_COUNT(FreeListStalls_);
+        OA_COUNT(NoPagesHits_);
 
-            // Go to the next block
-            allocatedBlock += stats.ObjectSize_ + config.HBlockInfo_.size_ + config.PadBytes_ * 2;
+        return nullptr;
+    }
 
-        }
+    try
+    {
+        return Allocate(label);
+    }
+    catch(const OAException& e)
+    {
+        return nullptr;
+    }
+    catch(const std::bad_alloc& e)
+    {
+        return nullptr;
+    }
+}
 
-        // Go to the next page
-        pageWalker = pageWalker->Next;
+/**
+ * @brief Frees a block like Free, but reports a failed debug check instead of throwing it. The block is 
+ *        left alone if a check fails.
+ * 
+ * @param Object - the object to free
+ * @param ErrCode - where to put the error code of a failed check (can be null)
+ * @return whether the block was freed
+ */
+bool ObjectAllocator::TryFree(void *Object, OAException::OA_EXCEPTION *ErrCode) noexcept
+{
+    OA_SAMPLE_LATENCY(FreeLatency_);
+
+    char* freedObject = reinterpret_cast<char*>(Object);
+
+    char* page = nullptr;
+    if(!config.UseCPPMemManager_ && (config.DebugOn_ || config.Reuse_ != OAConfig::rtLIFO))
+        page = ObjectPageLocation(freedObject);
+
+    OAException::OA_EXCEPTION error;
+    if(CheckFree(page, freedObject, &error))
+    {
+        if(ErrCode != nullptr)
+            *ErrCode = error;
 
-        // Set the block to the first block in the new page
-        allocatedBlock = reinterpret_cast<char*>(pageWalker);
-        allocatedBlock += sizeof(GenericObject*) + config.HBlockInfo_.size_ + config.PadBytes_;
+        return false;
     }
 
-    return stats.ObjectsInUse_;
+    ReleaseBlock(page, freedObject);
+
+    return true;
 }
 
 /**
- * @brief Calls the callback fn for each block that is potentially corrupted.
+ * @brief Queues a block freed by a thread other than the owner. The block's Next pointer links it onto the 
+ *        remote free queue with a compare-and-swap, so any number of threads can free at once without a 
+ *        lock. Nothing is checked and the stats don't change until the owner reclaims the queue.
  * 
- * @param fn - callback
- * @return unsigned - Number of corrupted blocks
+ * @param Object - the object to free
  */
-unsigned ObjectAllocator::ValidatePages(VALIDATECALLBACK fn) const
+void ObjectAllocator::FreeRemote(void *Object) noexcept
 {
-    int numCorruptions = 0;
+    GenericObject* block = static_cast<GenericObject*>(Object);
 
-    // This will walk the pages
-    GenericObject* pageWalker = PageList_;
+    PushRemoteFrees(block, block);
+}
 
-    // This will go along the pages block to block
-    const unsigned char* block = reinterpret_cast<const unsigned char*>(PageList_);
+/**
+ * @brief Frees every block on the remote free queue. The whole queue is taken with one exchange, then each 
+ *        block goes through Free, so the debug checks and stats are the same as for a local free. If a block 
+ *        fails a check, the blocks after it are put back on the queue before the exception is passed on.
+ * 
+ * @return unsigned - the number of blocks freed
+ */
+unsigned ObjectAllocator::ReclaimRemoteFrees()
+{
+    GenericObject* block = RemoteFrees.exchange(nullptr, std::memory_order_acquire);
 
-    block += sizeof(GenericObject*) + config.HBlockInfo_.size_ + config.PadBytes_;
+    unsigned numReclaimed = 0;
 
-    // As long as we still have pages
-    while(pageWalker != nullptr)
+    while(block != nullptr)
     {
-        // As long as we are still in the page
-        while(block < reinterpret_cast<unsigned char*>(pageWalker) + stats.PageSize_)
+        // Free links the block onto the free list, so get the next one first
+        GenericObject* next = block->Next;
+
+        try
         {
-            // If the block is corrupted, call the callback
-            if(CheckForPaddingCorruption(block))
+            Free(block);
+        }
+        catch(const OAException& e)
+        {
+            if(next != nullptr)
             {
-                numCorruptions++;
+                GenericObject* last = next;
+                while(last->Next != nullptr)
+                    last = last->Next;
 
-                fn(block, stats.ObjectSize_);
+                PushRemoteFrees(next, last);
             }
 
-            // Go to the next block
-            block += stats.ObjectSize_ + config.HBlockInfo_.size_ + config.PadBytes_ * 2;
+            throw;
+        }
+
+        block = next;
+        numReclaimed++;
+    }
+
+    return numReclaimed;
+}
+
+/**
+ * @brief Pushes a chain of blocks onto the remote free queue. Pushing is safe from any number of threads 
+ *        because the owner only ever takes the whole queue (a pushed block can't be popped and pushed back 
+ *        in the middle of a push).
+ * 
+ * @param first - the first block of the chain
+ * @param last - the last block of the chain (linked from first)
+ */
+void ObjectAllocator::PushRemoteFrees(GenericObject* first, GenericObject* last) noexcept
+{
+    GenericObject* head = RemoteFrees.load(std::memory_order_relaxed);
+
+    do
+    {
+        last->Next = head;
+    } while(!RemoteFrees.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+/**
+ * @brief Frees n blocks at once. The blocks are linked into one chain that is spliced onto the front of the 
+ *        free list, and the stats are updated once for the whole batch. With debugging on, external headers, 
+ *        the CPP manager, a reuse policy other than LIFO, sampled blocks in use or tracing, each block goes 
+ *        through Free so every check is done the same way.
+ * 
+ * @param in - the blocks to free
+ * @param n - the number of blocks
+ */
+void ObjectAllocator::FreeN(void *const *in, size_t n)
+{
+    if(config.UseCPPMemManager_ || config.DebugOn_ || config.HBlockInfo_.type_ == OAConfig::hbExternal || 
+       config.Reuse_ != OAConfig::rtLIFO || !SampledBlocks.empty() || Trace != nullptr)
+    {
+        for(size_t i = 0; i < n; ++i)
+        {
+            Free(in[i]);
+        }
+
+        return;
+    }
+
+    if(n == 0)
+        return;
+
+    // Link the blocks into one chain that ends at the current free list
+    for(size_t i = 0; i < n; ++i)
+    {
+        char* block = static_cast<char*>(in[i]);
+
+        // Reset the header block values
+        AssignHeaderBlockValues(block, false);
+
+        reinterpret_cast<GenericObject*>(block)->Next = (i + 1 < n) ? static_cast<GenericObject*>(in[i + 1]) : FreeList_;
+    }
+    FreeList_ = static_cast<GenericObject*>(in[0]);
+
+    // Update the stats once for the whole batch
+    stats.FreeObjects_ += static_cast<unsigned>(n);
+    stats.Deallocations_ += static_cast<unsigned>(n);
+    stats.ObjectsInUse_ -= static_cast<unsigned>(n);
+}
+
+/**
+ * @brief Calls the callback fn for each block in use by the client. The allocation bitmaps are brought up 
+ *        to date with one pass over the free list (unless they are already kept current), then each page's 
+ *        bitmap is scanned a byte at a time, so free blocks and fully free pages are skipped. It stops as 
+ *        soon as every block in use has been found.
+ * 
+ * @param fn - callback
+ * @return The amount of objects in use.
+ */
+unsigned ObjectAllocator::DumpMemoryInUse(DUMPCALLBACK fn) const
+{
+    if(config.UseCPPMemManager_ || stats.ObjectsInUse_ == 0)
+        return stats.ObjectsInUse_;
+
+    // The bitmaps are only kept current by the reuse policies or without header blocks while debugging is on
+    if(config.Reuse_ == OAConfig::rtLIFO && (!config.DebugOn_ || config.HBlockInfo_.type_ != OAConfig::hbNone))
+        RebuildAllocationBitmaps();
+
+    unsigned remaining = stats.ObjectsInUse_;
+
+    // As long as we still have pages
+    for(GenericObject* pageWalker = PageList_; pageWalker != nullptr; pageWalker = pageWalker->Next)
+    {
+        char* page = reinterpret_cast<char*>(pageWalker);
+        const unsigned char* bitmap = GetPageBitmap(page);
+
+        for(unsigned byte = 0; byte < PageBitmapSize; ++byte)
+        {
+            // Skip 8 free blocks at a time
+            if(bitmap[byte] == 0)
+                continue;
+
+            for(unsigned bit = 0; bit < 8; ++bit)
+            {
+                if((bitmap[byte] & (1 << bit)) == 0)
+                    continue;
+
+                // Call the callback for the block
+                unsigned index = byte * 8 + bit;
+                fn(page + FirstBlockOffset + index * FullBlockSize, stats.ObjectSize_);
+
+                // Every block in use has been found, so the rest of the pages are free
+                if(--remaining == 0)
+                    return stats.ObjectsInUse_;
+            }
+        }
+    }
+
+    return stats.ObjectsInUse_;
+}
+
+/**
+ * @brief Calls the callback fn for each block that is potentially corrupted.
+ * 
+ * @param fn - callback
+ * @return unsigned - Number of corrupted blocks
+ */
+unsigned ObjectAllocator::ValidatePages(VALIDATECALLBACK fn) const
+{
+    int numCorruptions = 0;
+
+    // This will walk the pages
+    GenericObject* pageWalker = PageList_;
+
+    // This will go along the pages block to block
+    const unsigned char* block = reinterpret_cast<const unsigned char*>(PageList_);
+
+    block += FirstBlockOffset;
+
+    // As long as we still have pages
+    while(pageWalker != nullptr)
+    {
+        // As long as we are still in the page (the uncarved blocks haven't been set up, so they're skipped)
+        while(block < reinterpret_cast<unsigned char*>(pageWalker) + stats.PageSize_ && 
+              !IsBlockUncarved(reinterpret_cast<char*>(pageWalker), reinterpret_cast<const char*>(block)))
+        {
+            // If the block is corrupted, call the callback
+            if(CheckForPaddingCorruption(block))
+            {
+                numCorruptions++;
+
+                fn(block, stats.ObjectSize_);
+            }
+
+            // Go to the next block
+            block += FullBlockSize;
+        }
+
+        // Go to the next page
+        pageWalker = pageWalker->Next;
+
+        // Go to the first block in the next page
+        block = reinterpret_cast<unsigned char*>(pageWalker);
+        block += FirstBlockOffset;
+    }
+
+    return numCorruptions;
+}
+
+/**
+ * @brief Checks the padding of the next MaxBlocks blocks, starting where the last step stopped. A step never 
+ *        goes past the last page, the next step starts a new sweep at the first page instead. New pages are 
+ *        added in front of the first page, so they're checked by the next sweep and the current sweep only 
+ *        covers the pages it started with (less any freed in between). A sweep takes at most 
+ *        ValidateStepsPerSweep steps and a page is checked within 2 sweeps of being allocated. Compact 
+ *        reorders the pages, so it ends a sweep in progress early (counted as finished, the pages it didn't 
+ *        get to are checked by the next sweep).
+ * 
+ * @param fn - the callback for each corrupted block
+ * @param MaxBlocks - the most blocks to check
+ * @return unsigned - the number of corrupted blocks found
+ */
+unsigned ObjectAllocator::ValidateStep(VALIDATECALLBACK fn, unsigned MaxBlocks)
+{
+    if(MaxBlocks == 0)
+        return 0;
+
+    unsigned numCorruptions = 0;
+
+    if(ValidatePage == nullptr)
+    {
+        ValidatePage = reinterpret_cast<char*>(PageList_);
+        ValidateBlock = 0;
+    }
+
+    while(ValidatePage != nullptr && MaxBlocks > 0)
+    {
+        const char* block = ValidatePage + FirstBlockOffset + ValidateBlock * FullBlockSize;
+
+        // The uncarved blocks (the rest of the page) haven't been set up, so they're skipped
+        if(ValidateBlock < config.ObjectsPerPage_ && !IsBlockUncarved(ValidatePage, block))
+        {
+            if(CheckForPaddingCorruption(reinterpret_cast<const unsigned char*>(block)))
+            {
+                numCorruptions++;
+
+                fn(block, stats.ObjectSize_);
+            }
+
+            ValidateBlock++;
+            MaxBlocks--;
+
+            continue;
+        }
+
+        // Go to the next page
+        ValidatePage = reinterpret_cast<char*>(reinterpret_cast<GenericObject*>(ValidatePage)->Next);
+        ValidateBlock = 0;
+    }
+
+    // Skip past the end of a finished page now, so the sweep ends with the step that checked its last block
+    if(ValidatePage != nullptr && ValidateBlock == config.ObjectsPerPage_)
+    {
+        ValidatePage = reinterpret_cast<char*>(reinterpret_cast<GenericObject*>(ValidatePage)->Next);
+        ValidateBlock = 0;
+    }
+
+    if(ValidatePage == nullptr)
+        ValidateSweeps++;
+
+    return numCorruptions;
+}
+
+/**
+ * @brief Checks the padding of the next pages until the time is up or the sweep is finished. The clock is 
+ *        read once per page's worth of blocks, so the call can go over by the time it takes to check one page.
+ * 
+ * @param fn - the callback for each corrupted block
+ * @param Microseconds - how long to keep checking
+ * @return unsigned - the number of corrupted blocks found
+ */
+unsigned ObjectAllocator::ValidateFor(VALIDATECALLBACK fn, unsigned Microseconds)
+{
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::microseconds(Microseconds);
+
+    unsigned numCorruptions = 0;
+    unsigned sweeps = ValidateSweeps;
+
+    do
+    {
+        numCorruptions += ValidateStep(fn, config.ObjectsPerPage_);
+    } while(ValidateSweeps == sweeps && std::chrono::steady_clock::now() < end);
+
+    return numCorruptions;
+}
+
+/**
+ * @brief Returns the most steps of MaxBlocks blocks a sweep that starts now can take.
+ * 
+ * @param MaxBlocks - the most blocks each step checks
+ * @return unsigned - the number of steps
+ */
+unsigned ObjectAllocator::ValidateStepsPerSweep(unsigned MaxBlocks) const
+{
+    if(MaxBlocks == 0)
+        return 0;
+
+    unsigned blocks = stats.PagesInUse_ * config.ObjectsPerPage_;
+
+    // An empty heap still takes a step to finish the sweep
+    return blocks == 0 ? 1 : (blocks + MaxBlocks - 1) / MaxBlocks;
+}
+
+/**
+ * @brief Returns the number of sweeps ValidateStep has finished.
+ * 
+ * @return unsigned
+ */
+unsigned ObjectAllocator::GetValidateSweeps() const
+{
+    return ValidateSweeps;
+}
+
+/**
+ * @brief Frees all the pages that have every block on the free list. This takes one pass to count how many 
+ *        free blocks each page has, one pass to take the blocks of the empty pages off the free list and one 
+ *        pass over the pages, so it's linear in the length of the free list plus the number of pages.
+ * 
+ * @return unsigned - Number of pages freed
+ */
+unsigned ObjectAllocator::FreeEmptyPages()
+{
+    if(config.UseCPPMemManager_)
+        return 0;
+
+    if(Trace != nullptr)
+        Trace->RecordFreeEmptyPages();
+
+    // The blocks other threads freed can make more pages empty
+    if(RemoteFrees.load(std::memory_order_relaxed) != nullptr)
+        ReclaimRemoteFrees();
+
+    CountFreeBlocks();
+
+    // Every page kept by Reset is empty, so they're all freed below
+    ResetPages.clear();
+
+    // Take the blocks of the empty pages off the free list
+    GenericObject** link = &FreeList_;
+    while((*link) != nullptr)
+    {
+        PageInfo* info = GetPageInfo(ObjectPageLocation(reinterpret_cast<char*>(*link)));
+
+        if(info->freeCount_ == config.ObjectsPerPage_)
+        {
+            // Skip over the block
+            (*link) = (*link)->Next;
+        }
+        else
+        {
+            link = &(*link)->Next;
+        }
+    }
+
+    unsigned numFreed = 0;
+
+    // Free the empty pages
+    link = &PageList_;
+    while((*link) != nullptr)
+    {
+        char* page = reinterpret_cast<char*>(*link);
+
+        if(GetPageInfo(page)->freeCount_ == config.ObjectsPerPage_)
+        {
+            ReleaseEmptyPage(link);
+
+            numFreed++;
+        }
+        else
+        {
+            link = &(*link)->Next;
+        }
+    }
+
+    // The pages and free list aren't in the order Compact left them in anymore
+    CompactPlanned = false;
+
+    return numFreed;
+}
+
+/**
+ * @brief Takes an empty page off the page list and lets go of it (every one of its blocks is free and none 
+ *        of them are on the free list).
+ * 
+ * @param link - the link to the page (PageList_ or the Next of the page before it)
+ */
+void ObjectAllocator::ReleaseEmptyPage(GenericObject** link)
+{
+    char* page = reinterpret_cast<char*>(*link);
+
+    // Take the page off the page list
+    (*link) = (*link)->Next;
+
+    if(page == FrontierPage)
+    {
+        FrontierPage = nullptr;
+        FrontierBlocks = 0;
+    }
+
+    // Move the validation cursor off the page (freeing the last pages finishes the sweep)
+    if(page == ValidatePage)
+    {
+        ValidatePage = reinterpret_cast<char*>(*link);
+        ValidateBlock = 0;
+
+        if(ValidatePage == nullptr)
+            ValidateSweeps++;
+    }
+
+    if(config.Reuse_ != OAConfig::rtLIFO)
+        UpdatePartialPages(page, config.ObjectsPerPage_, 0);
+
+    UnregisterPage(page);
+    DeletePage(page);
+
+    // Update the stats
+    stats.PagesInUse_--;
+    stats.FreeObjects_ -= config.ObjectsPerPage_;
+}
+
+/**
+ * @brief Counts the free blocks of each page with LIFO reuse, from the free list, the uncarved blocks and 
+ *        the pages kept by Reset. The reuse policies keep the free counts current (and their free list is 
+ *        empty), so there's nothing to count.
+ */
+void ObjectAllocator::CountFreeBlocks()
+{
+    if(config.Reuse_ != OAConfig::rtLIFO)
+        return;
+
+    // Reset the free count of each page
+    for(GenericObject* page = PageList_; page != nullptr; page = page->Next)
+    {
+        GetPageInfo(reinterpret_cast<char*>(page))->freeCount_ = 0;
+    }
+
+    // Count the free blocks of each page (the uncarved blocks are free too)
+    for(GenericObject* block = FreeList_; block != nullptr; block = block->Next)
+    {
+        GetPageInfo(ObjectPageLocation(reinterpret_cast<char*>(block)))->freeCount_++;
+    }
+    if(FrontierBlocks > 0)
+        GetPageInfo(FrontierPage)->freeCount_ += FrontierBlocks;
+    for(char* page : ResetPages)
+        GetPageInfo(page)->freeCount_ = config.ObjectsPerPage_;
+}
+
+/**
+ * @brief Frees every block at once, like an arena. Up to KeepPages pages (the first of the page list: the 
+ *        most recently added, except that Compact moves the pages it packs to the end) are kept and the 
+ *        rest are released. Each kept page is only marked as uncarved, its blocks are set up again 
+ *        when the page is needed (with LIFO reuse, once the other free blocks run out), so this takes time 
+ *        in the number of pages, not blocks. The external header blocks are reset with their pool and the 
+ *        blocks other threads queued to free are dropped (they're freed with everything else).
+ * 
+ * @param KeepPages - the most pages to keep for the next allocations
+ */
+void ObjectAllocator::Reset(unsigned KeepPages)
+{
+    if(config.UseCPPMemManager_)
+        return;
+
+    unsigned keep = (KeepPages < stats.PagesInUse_) ? KeepPages : stats.PagesInUse_;
+
+    // Making room for the reset pages is the only thing that allocates (the partial pages always have room 
+    // for every page), so it's done before anything changes. The header pool does the same in its own 
+    // Reset, so if either one fails, neither pool has changed.
+    try
+    {
+        if(config.Reuse_ == OAConfig::rtLIFO)
+            ResetPages.reserve(keep);
+    }
+    catch(const std::bad_alloc& e)
+    {
+        throw OAException(OAException::E_NO_MEMORY, "Reset: No system memory available.");
+    }
+
+    if(HeaderPool != nullptr)
+        HeaderPool->Reset(HeaderPool->GetStats().PagesInUse_);
+
+    if(Trace != nullptr)
+        Trace->RecordReset(KeepPages);
+
+    RemoteFrees.store(nullptr, std::memory_order_relaxed);
+
+    FreeList_ = nullptr;
+    FrontierPage = nullptr;
+    FrontierBlocks = 0;
+    PartialPages.clear();
+    ResetPages.clear();
+
+    // Start the next validation sweep over
+    ValidatePage = nullptr;
+    ValidateBlock = 0;
+
+    CompactPlanned = false;
+
+    unsigned kept = 0;
+    GenericObject** link = &PageList_;
+    while((*link) != nullptr)
+    {
+        char* page = reinterpret_cast<char*>(*link);
+
+        if(kept < keep)
+        {
+            // Every block is free and will be set up again when it's carved
+            PageInfo* info = GetPageInfo(page);
+            info->uncarved_ = true;
+            info->freeCount_ = config.ObjectsPerPage_;
+
+            memset(GetPageBitmap(page), 0, PageBitmapSize);
+            if(config.SideTableHeaders_)
+                memset(page + SideTableOffset, 0, config.HBlockInfo_.size_ * config.ObjectsPerPage_);
+
+            if(config.Reuse_ != OAConfig::rtLIFO)
+                UpdatePartialPages(page, 0, config.ObjectsPerPage_);
+            else
+                ResetPages.push_back(page);
+
+            kept++;
+            link = &(*link)->Next;
+        }
+        else
+        {
+            // Take the page off the page list
+            (*link) = (*link)->Next;
+
+            UnregisterPage(page);
+            DeletePage(page);
+
+            stats.PagesInUse_--;
+        }
+    }
+
+    // Update the stats
+    stats.Deallocations_ += stats.ObjectsInUse_;
+    stats.ObjectsInUse_ = 0;
+    stats.FreeObjects_ = kept * config.ObjectsPerPage_;
+
+    // None of the sampled blocks are live anymore
+    SampledBlocks.clear();
+    for(OASampledSite& site : Sites)
+    {
+        site.live_ = 0;
+    }
+}
+
+/**
+ * @brief Writes the lists and statistics of a pool kept in a mapped file to the start of the file and 
+ *        flushes the file, so the next allocator to open it gets the pool as it is now. The blocks other 
+ *        threads queued to free are freed first.
+ */
+void ObjectAllocator::SaveMappedFile()
+{
+    if(MappedHeader == nullptr)
+        return;
+
+    if(RemoteFrees.load(std::memory_order_relaxed) != nullptr)
+        ReclaimRemoteFrees();
+
+    MappedHeader->pageList_ = PageList_;
+    MappedHeader->freeList_ = FreeList_;
+    MappedHeader->releasedPages_ = ReleasedPages;
+    MappedHeader->nextReservedPage_ = NextReservedPage;
+    MappedHeader->reservedPages_ = ReservedPages;
+    MappedHeader->frontierPage_ = FrontierPage;
+    MappedHeader->frontierBlocks_ = FrontierBlocks;
+    MappedHeader->stats_ = stats;
+    MappedHeader->saved_ = true;
+
+#ifdef OA_HAS_MMAP
+    if(msync(MappedHeader, MappedHeader->layout_.size_, MS_SYNC) != 0)
+        throw OAException(OAException::E_BAD_MAPPED_FILE, "SaveMappedFile: The mapped file can't be written.");
+#endif
+}
+
+/**
+ * @brief Moves up to MaxMoves blocks in use from the sparsest pages into the fullest pages, freeing each 
+ *        page as soon as it's emptied.
+ * 
+ * @param fn - called with the old block, the new block and the object size for each block moved
+ * @param MaxMoves - the most blocks to move
+ * @return unsigned - the number of blocks moved
+ */
+unsigned ObjectAllocator::Compact(RELOCATECALLBACK fn, unsigned MaxMoves)
+{
+    return MoveBlocks(fn, MaxMoves, 0);
+}
+
+/**
+ * @brief Moves blocks in use from the sparsest pages into the fullest pages until the time is up (it's 
+ *        checked every few blocks, so it can run a little over, and planning the moves isn't cut short), 
+ *        freeing each page as soon as it's emptied.
+ * 
+ * @param fn - called with the old block, the new block and the object size for each block moved
+ * @param Microseconds - how long to move blocks for
+ * @return unsigned - the number of blocks moved
+ */
+unsigned ObjectAllocator::CompactFor(RELOCATECALLBACK fn, unsigned Microseconds)
+{
+    if(Microseconds == 0)
+        return 0;
+
+    return MoveBlocks(fn, UINT_MAX, Microseconds);
+}
+
+/**
+ * @brief Moves the blocks in use of the sparsest page into the free blocks of the fullest page, one block 
+ *        at a time, until the two meet (or the budget runs out). The blocks are all the same size and every 
+ *        page has the same layout, so a move is a copy of the object and its header block. The pages are 
+ *        sorted by PlanCompaction when the pool changed since the last call, otherwise the moves pick up 
+ *        where the last call stopped, so each call only takes time in the number of blocks it moves. The 
+ *        emptied pages are the last of the page list (and with LIFO reuse, their free blocks are the last 
+ *        of the free list), so each one is cut off and freed right away. The blocks other threads queued to 
+ *        free are freed first so they aren't taken for blocks in use.
+ * 
+ * @param fn - called with the old block, the new block and the object size for each block moved
+ * @param MaxMoves - the most blocks to move
+ * @param Microseconds - how long to move blocks for (0 for no limit)
+ * @return unsigned - the number of blocks moved
+ */
+unsigned ObjectAllocator::MoveBlocks(RELOCATECALLBACK fn, unsigned MaxMoves, unsigned Microseconds)
+{
+    if(config.UseCPPMemManager_ || MaxMoves == 0)
+        return 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if(RemoteFrees.load(std::memory_order_relaxed) != nullptr)
+        ReclaimRemoteFrees();
+
+    // Any allocation or free since the last call can change which pages are the fullest
+    if(!CompactPlanned || CompactAllocations != stats.Allocations_ || 
+       CompactDeallocations != stats.Deallocations_ || CompactPagesInUse != stats.PagesInUse_)
+        PlanCompaction();
+
+    // With LIFO reuse, the blocks moved out of the page being emptied (they go on the end of the free list 
+    // once the moves stop, unless the page is freed first)
+    GenericObject* movedHead = nullptr;
+    GenericObject* movedTail = nullptr;
+
+    unsigned moved = 0;
+
+    while(CompactFrom > CompactTo + 1 && moved < MaxMoves)
+    {
+        char* toPage = CompactPages[CompactTo];
+        char* fromPage = CompactPages[CompactFrom - 1];
+
+        // Move on once the fullest page is full
+        if(GetPageInfo(toPage)->freeCount_ == 0)
+        {
+            CompactTo++;
+            CompactToIndex = 0;
+            continue;
+        }
+
+        // The next free block of the fullest page and the next block in use of the sparsest page
+        char* toBlock = toPage + FirstBlockOffset + CompactToIndex * FullBlockSize;
+        while(!IsBlockFree(toPage, toBlock))
+            toBlock = toPage + FirstBlockOffset + (++CompactToIndex) * FullBlockSize;
+
+        char* fromBlock = fromPage + FirstBlockOffset + CompactFromIndex * FullBlockSize;
+        while(IsBlockFree(fromPage, fromBlock))
+            fromBlock = fromPage + FirstBlockOffset + (++CompactFromIndex) * FullBlockSize;
+
+        // The block moved to is the first one on the free list
+        if(config.Reuse_ == OAConfig::rtLIFO)
+        {
+            FreeList_ = FreeList_->Next;
+            if(FreeList_ == nullptr)
+                CompactFreeTail = nullptr;
+        }
+
+        MoveBlock(fromPage, fromBlock, toPage, toBlock);
+        moved++;
+
+        if(config.Reuse_ == OAConfig::rtLIFO)
+        {
+            GenericObject* block = reinterpret_cast<GenericObject*>(fromBlock);
+            block->Next = nullptr;
+
+            if(movedTail != nullptr)
+                movedTail->Next = block;
+            else
+                movedHead = block;
+            movedTail = block;
+        }
+
+        if(fn != nullptr)
+            fn(fromBlock, toBlock, stats.ObjectSize_);
+
+        // Free the sparsest page once it's empty (it's the last page of the page list, after the page that's 
+        // sparsest next)
+        if(GetPageInfo(fromPage)->freeCount_ == config.ObjectsPerPage_)
+        {
+            // Cut its blocks off the end of the free list (they're all that's left of it once every block 
+            // before them has been moved to)
+            if(config.Reuse_ == OAConfig::rtLIFO)
+            {
+                GenericObject* link = CompactLinks[CompactFrom - 1];
+                char* first = reinterpret_cast<char*>(FreeList_);
+                if(first >= fromPage && first < fromPage + stats.PageSize_)
+                    link = nullptr;
+
+                if(link != nullptr)
+                    link->Next = nullptr;
+                else
+                    FreeList_ = nullptr;
+
+                CompactFreeTail = link;
+                movedHead = nullptr;
+                movedTail = nullptr;
+            }
+
+            CompactFrom--;
+            CompactFromIndex = 0;
+
+            ReleaseEmptyPage(&reinterpret_cast<GenericObject*>(CompactPages[CompactFrom - 1])->Next);
+        }
+
+        // Check the time every few blocks
+        if(Microseconds > 0 && moved % 64 == 0 && 
+           std::chrono::steady_clock::now() - start >= std::chrono::microseconds(Microseconds))
+            break;
+    }
+
+    // The blocks moved out of the page that isn't empty yet go on the end of the free list with its others
+    if(movedHead != nullptr)
+    {
+        if(CompactFreeTail != nullptr)
+            CompactFreeTail->Next = movedHead;
+        else
+            FreeList_ = movedHead;
+
+        CompactFreeTail = movedTail;
+    }
+
+    CompactAllocations = stats.Allocations_;
+    CompactDeallocations = stats.Deallocations_;
+    CompactPagesInUse = stats.PagesInUse_;
+
+    return moved;
+}
+
+/**
+ * @brief Plans the moves of Compact: the pages partly in use are sorted from the fewest free blocks to the 
+ *        most and moved to the end of the page list in that order, so the sparsest page is always the last 
+ *        one. With LIFO reuse, the free list is made again from the bitmaps in the order the blocks are 
+ *        moved to (the moves are counted out first to find the pages that are filled and emptied), with 
+ *        the blocks of the pages to empty at the end. The uncarved blocks are carved first so every free 
+ *        block is set up. This takes time in the number of pages and free blocks. The pages kept by Reset 
+ *        are empty, so they aren't part of the plan.
+ */
+void ObjectAllocator::PlanCompaction()
+{
+    CompactPlanned = false;
+
+    // The plan has room for every page
+    try
+    {
+        CompactPages.clear();
+        CompactPages.reserve(stats.PagesInUse_);
+
+        if(config.Reuse_ == OAConfig::rtLIFO)
+        {
+            CompactLinks.clear();
+            CompactLinks.reserve(stats.PagesInUse_);
+        }
+    }
+    catch(const std::bad_alloc& e)
+    {
+        throw OAException(OAException::E_NO_MEMORY, "Compact: No system memory available.");
+    }
+
+    CarveRemainingBlocks();
+    CountFreeBlocks();
+
+    // Take the pages partly in use off the page list (the others keep their order)
+    GenericObject** link = &PageList_;
+    while((*link) != nullptr)
+    {
+        char* page = reinterpret_cast<char*>(*link);
+        PageInfo* info = GetPageInfo(page);
+
+        if(!info->uncarved_ && info->freeCount_ > 0 && info->freeCount_ < config.ObjectsPerPage_)
+        {
+            CompactPages.push_back(page);
+            (*link) = (*link)->Next;
+        }
+        else
+        {
+            link = &(*link)->Next;
+        }
+    }
+
+    // The pages are going to be in a different order, so a sweep in progress could check the pages it already 
+    // checked again (more steps than it promised). It ends here, counted as finished, and the next step 
+    // starts a new sweep.
+    if(!CompactPages.empty() && ValidatePage != nullptr)
+    {
+        ValidatePage = nullptr;
+        ValidateBlock = 0;
+        ValidateSweeps++;
+    }
+
+    std::sort(CompactPages.begin(), CompactPages.end(), [this](const char* left, const char* right)
+    {
+        unsigned leftCount = GetPageInfo(left)->freeCount_;
+        unsigned rightCount = GetPageInfo(right)->freeCount_;
+
+        return (leftCount != rightCount) ? leftCount < rightCount : std::less<const char*>()(left, right);
+    });
+
+    // And put them back on the end, the fullest first
+    GenericObject** end = link;
+    for(char* page : CompactPages)
+    {
+        (*link) = reinterpret_cast<GenericObject*>(page);
+        link = &(*link)->Next;
+    }
+    (*link) = nullptr;
+
+    CompactTo = 0;
+    CompactFrom = CompactPages.size();
+    CompactToIndex = 0;
+    CompactFromIndex = 0;
+
+    // With LIFO reuse, the free list is ordered for the moves (there aren't any without two pages to move 
+    // blocks between)
+    if(config.Reuse_ == OAConfig::rtLIFO && CompactPages.size() > 1)
+    {
+        // Count out the moves to find the pages that are filled (before fillEnd) and emptied (from 
+        // emptyBegin on)
+        size_t fillEnd = 0;
+        size_t emptyBegin = CompactPages.size();
+        size_t to = 0;
+        size_t from = CompactPages.size();
+        unsigned toFree = GetPageInfo(CompactPages[to])->freeCount_;
+        unsigned fromUsed = config.ObjectsPerPage_ - GetPageInfo(CompactPages[from - 1])->freeCount_;
+
+        while(from > to + 1)
+        {
+            if(toFree == 0)
+            {
+                toFree = GetPageInfo(CompactPages[++to])->freeCount_;
+                continue;
+            }
+            if(fromUsed == 0)
+            {
+                fromUsed = config.ObjectsPerPage_ - GetPageInfo(CompactPages[(--from) - 1])->freeCount_;
+                continue;
+            }
+
+            unsigned count = (toFree < fromUsed) ? toFree : fromUsed;
+            toFree -= count;
+            fromUsed -= count;
+
+            fillEnd = to + 1;
+            emptyBegin = from - 1;
+        }
+
+        // The free list doesn't tell which page a block is on, so the blocks are found with the bitmaps
+        RebuildAllocationBitmaps();
+
+        FreeList_ = nullptr;
+        CompactFreeTail = nullptr;
+
+        for(size_t i = 0; i < fillEnd; ++i)
+            ListFreeBlocks(CompactPages[i]);
+
+        // The pages that aren't partly in use are the ones before the plan (skipping the pages kept by Reset, 
+        // they aren't on the free list)
+        for(GenericObject* page = PageList_; page != (*end); page = page->Next)
+        {
+            if(!GetPageInfo(reinterpret_cast<char*>(page))->uncarved_)
+                ListFreeBlocks(reinterpret_cast<char*>(page));
+        }
+
+        for(size_t i = fillEnd; i < emptyBegin; ++i)
+            ListFreeBlocks(CompactPages[i]);
+
+        CompactLinks.assign(CompactPages.size(), nullptr);
+        for(size_t i = emptyBegin; i < CompactPages.size(); ++i)
+        {
+            CompactLinks[i] = CompactFreeTail;
+            ListFreeBlocks(CompactPages[i]);
+        }
+    }
+
+    CompactPlanned = true;
+}
+
+/**
+ * @brief Adds the free blocks of a page to the end of the free list, from the lowest block to the highest 
+ *        (they're found with IsBlockFree, so the bitmaps have to be current).
+ * 
+ * @param page - the page whose free blocks are added
+ */
+void ObjectAllocator::ListFreeBlocks(char* page)
+{
+    if(GetPageInfo(page)->freeCount_ == 0)
+        return;
+
+    for(unsigned i = 0; i < config.ObjectsPerPage_; ++i)
+    {
+        char* block = page + FirstBlockOffset + i * FullBlockSize;
+        if(!IsBlockFree(page, block))
+            continue;
+
+        GenericObject* freeBlock = reinterpret_cast<GenericObject*>(block);
+        freeBlock->Next = nullptr;
+
+        if(CompactFreeTail != nullptr)
+            CompactFreeTail->Next = freeBlock;
+        else
+            FreeList_ = freeBlock;
+        CompactFreeTail = freeBlock;
+    }
+}
+
+/**
+ * @brief Moves a block in use to a free block of another page. The object is copied and the header blocks 
+ *        are swapped, so the new block keeps the allocation number, label and flags and the old block gets 
+ *        the free header block. The free list isn't touched (MoveBlocks keeps it).
+ * 
+ * @param fromPage - the page of the block in use
+ * @param from - the block in use
+ * @param toPage - the page of the free block
+ * @param to - the free block
+ */
+void ObjectAllocator::MoveBlock(char* fromPage, char* from, char* toPage, char* to)
+{
+    memcpy(to, from, stats.ObjectSize_);
+
+    if(config.HBlockInfo_.type_ != OAConfig::hbNone)
+    {
+        char* fromHeader = HeaderBlockLocation(fromPage, from);
+
+        std::swap_ranges(fromHeader, fromHeader + config.HBlockInfo_.size_, HeaderBlockLocation(toPage, to));
+    }
+
+    if(config.Reuse_ != OAConfig::rtLIFO)
+    {
+        TakePageBlock(toPage, to);
+        ReturnPageBlock(fromPage, from);
+    }
+    else
+    {
+        SetBlockAllocated(toPage, to, true);
+        SetBlockAllocated(fromPage, from, false);
+        GetPageInfo(toPage)->freeCount_--;
+        GetPageInfo(fromPage)->freeCount_++;
+    }
+
+    if(config.DebugOn_)
+        memset(from, FREED_PATTERN, stats.ObjectSize_);
+
+    // The sampled site and the trace follow the block
+    if(!SampledBlocks.empty())
+    {
+        std::unordered_map<const void*, unsigned>::iterator sampled = SampledBlocks.find(from);
+        if(sampled != SampledBlocks.end())
+        {
+            unsigned site = sampled->second;
+            SampledBlocks.erase(sampled);
+            SampledBlocks[to] = site;
+        }
+    }
+
+    if(Trace != nullptr)
+        Trace->RecordMove(from, to);
+}
+
+/**
+ * @brief FreeEmptyPages and alignment are both implemented.
+ * 
+ * @return true 
+ */
+bool ObjectAllocator::ImplementedExtraCredit()
+{
+    return true;
+}
+
+/**
+ * @brief Sets the debug state of the OA.
+ * 
+ * @param State 
+ */
+void ObjectAllocator::SetDebugState(bool State)
+{
+    // The allocation bitmaps aren't kept up to date while debugging is off, so catch them up
+    if(State && !config.DebugOn_ && config.HBlockInfo_.type_ == OAConfig::hbNone && config.Reuse_ == OAConfig::rtLIFO)
+        RebuildAllocationBitmaps();
+
+    config.DebugOn_ = State;
+}
+
+/**
+ * @brief Sets how often Allocate and Free are timed for the latency histograms. Timing every call would 
+ *        cost more than the calls themselves, so only 1 of every SampleEvery calls is timed.
+ * 
+ * @param SampleEvery - time 1 of every this many calls (0 turns sampling off)
+ */
+void ObjectAllocator::SetLatencySampling(unsigned SampleEvery)
+{
+    instrumentation.LatencySampleEvery_ = SampleEvery;
+    LatencyCountdown = SampleEvery;
+}
+
+/**
+ * @brief Returns the instrumentation counters (all 0 unless compiled with OA_INSTRUMENT).
+ * 
+ * @return OAInstrumentation 
+ */
+OAInstrumentation ObjectAllocator::GetInstrumentation() const
+{
+    return instrumentation;
+}
+
+/**
+ * @brief Counts down to the next sampled call.
+ * 
+ * @param histogram - the histogram of the call
+ * @return unsigned* - the histogram if this call is timed, otherwise nullptr
+ */
+unsigned* ObjectAllocator::SampleLatency(unsigned* histogram)
+{
+    if(LatencyCountdown == 0 || --LatencyCountdown > 0)
+        return nullptr;
+
+    LatencyCountdown = instrumentation.LatencySampleEvery_;
+
+    return histogram;
+}
+
+/**
+ * @brief Sets how often allocations have their site (label and call stack) recorded. Like a heap profiler, 
+ *        each sample stands for SampleEvery allocations, so the sites still in use can be dumped without 
+ *        paying for external headers on every block. The labels are kept in the label arena.
+ * 
+ * @param SampleEvery - record 1 of every this many allocations (0 turns sampling off)
+ */
+void ObjectAllocator::SetAllocationSampling(unsigned SampleEvery)
+{
+    AllocationSampleEvery = SampleEvery;
+    AllocationCountdown = NextSampleInterval();
+}
+
+/**
+ * @brief Picks how many allocations until the next sample: a random number from 1 to 2 * SampleEvery - 1, 
+ *        so it's SampleEvery on average but doesn't line up with call sites that allocate in a fixed pattern.
+ * 
+ * @return unsigned - the number of allocations (0 if sampling is off)
+ */
+unsigned ObjectAllocator::NextSampleInterval()
+{
+    if(AllocationSampleEvery <= 1)
+        return AllocationSampleEvery;
+
+    // xorshift32
+    SampleRandom ^= SampleRandom << 13;
+    SampleRandom ^= SampleRandom >> 17;
+    SampleRandom ^= SampleRandom << 5;
+
+    return 1 + SampleRandom % (2 * AllocationSampleEvery - 1);
+}
+
+/**
+ * @brief Calls the callback fn for each allocation site recorded by the sampling. Multiplying a site's 
+ *        counts by the sample rate estimates how many objects it allocated and still has in use.
+ * 
+ * @param fn - callback (given the site and the sample rate)
+ * @return unsigned - the number of sites
+ */
+unsigned ObjectAllocator::DumpSampledSites(SITECALLBACK fn) const
+{
+    for(const OASampledSite& site : Sites)
+    {
+        fn(site, AllocationSampleEvery);
+    }
+
+    return static_cast<unsigned>(Sites.size());
+}
+
+/**
+ * @brief Starts recording every Allocate, Free, Reset and FreeEmptyPages to a trace file (replacing the 
+ *        trace being recorded, if any). The blocks in use before the trace starts aren't in it, so their 
+ *        frees aren't recorded either. The batch calls go one block at a time while tracing.
+ * 
+ * @param TraceFile - the file to write the trace to
+ * @return whether the file was created
+ */
+bool ObjectAllocator::StartTrace(const char *TraceFile)
+{
+    StopTrace();
+
+    try
+    {
+        Trace = new TraceRecorder(TraceFile, stats.ObjectSize_);
+    }
+    catch(const std::bad_alloc& e)
+    {
+        return false;
+    }
+
+    if(!Trace->IsOpen())
+    {
+        StopTrace();
+
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Stops recording and closes the trace file.
+ * 
+ * @return whether the whole trace was written (false if there was no trace)
+ */
+bool ObjectAllocator::StopTrace()
+{
+    if(Trace == nullptr)
+        return false;
+
+    bool written = Trace->Close();
+
+    delete Trace;
+    Trace = nullptr;
+
+    return written;
+}
+
+/**
+ * @brief Counts down to the next sampled allocation. Without sampling this is one compare.
+ * 
+ * @param block - the block just allocated
+ * @param label - the label it was allocated with
+ */
+void ObjectAllocator::SampleAllocation(void* block, const char* label)
+{
+    if(AllocationCountdown == 0 || --AllocationCountdown > 0)
+        return;
+
+    AllocationCountdown = NextSampleInterval();
+
+    RecordSample(block, label);
+}
+
+/**
+ * @brief Records a sampled block under the site of its label and call stack (adding the site if it's new). 
+ *        If there isn't memory for the sample, it's skipped (the allocation itself already worked).
+ * 
+ * @param block - the sampled block
+ * @param label - the label it was allocated with
+ */
+void ObjectAllocator::RecordSample(void* block, const char* label)
+{
+    try
+    {
+        OASampledSite sample;
+        sample.label_ = InternLabel(label);
+        sample.depth_ = 0;
+        sample.sampled_ = 0;
+        sample.live_ = 0;
+
+#ifdef OA_HAS_BACKTRACE
+        sample.depth_ = static_cast<unsigned>(backtrace(sample.stack_, SAMPLE_STACK_DEPTH));
+#endif
+
+        // The labels are interned, so the same label always has the same address
+        size_t hash = static_cast<size_t>(14695981039346656037ULL) ^ reinterpret_cast<std::uintptr_t>(sample.label_);
+        for(unsigned i = 0; i < sample.depth_; ++i)
+        {
+            hash = (hash ^ reinterpret_cast<std::uintptr_t>(sample.stack_[i])) * static_cast<size_t>(1099511628211ULL);
+        }
+
+        // Find the site with the same label and stack
+        unsigned siteIndex = static_cast<unsigned>(Sites.size());
+        typedef std::unordered_multimap<size_t, unsigned>::const_iterator SiteIterator;
+        std::pair<SiteIterator, SiteIterator> matches = SiteLookup.equal_range(hash);
+        for(SiteIterator match = matches.first; match != matches.second; ++match)
+        {
+            const OASampledSite& site = Sites[match->second];
+
+            if(site.label_ == sample.label_ && site.depth_ == sample.depth_ && 
+               std::equal(site.stack_, site.stack_ + site.depth_, sample.stack_))
+            {
+                siteIndex = match->second;
+                break;
+            }
+        }
+
+        if(siteIndex == Sites.size())
+        {
+            Sites.push_back(sample);
+            SiteLookup.insert(std::make_pair(hash, siteIndex));
+        }
+
+        SampledBlocks[block] = siteIndex;
+
+        Sites[siteIndex].sampled_++;
+        Sites[siteIndex].live_++;
+    }
+    catch(const std::bad_alloc& e)
+    {
+    }
+    catch(const OAException& e)
+    {
+    }
+}
+
+/**
+ * @brief Takes a freed block out of the sampled blocks (if it was sampled). Nothing is looked up unless 
+ *        some sampled blocks are still in use.
+ * 
+ * @param block - the freed block
+ */
+void ObjectAllocator::ForgetSample(void* block)
+{
+    if(SampledBlocks.empty())
+        return;
+
+    std::unordered_map<const void*, unsigned>::iterator sampled = SampledBlocks.find(block);
+    if(sampled == SampledBlocks.end())
+        return;
+
+    Sites[sampled->second].live_--;
+    SampledBlocks.erase(sampled);
+}
+
+/**
+ * @brief Returns the free list (all blocks that are free).
+ */
+const void* ObjectAllocator::GetFreeList() const
+{
+    return FreeList_;
+}
+
+/**
+ * @brief Returns the page list.
+ */
+const void* ObjectAllocator::GetPageList() const
+{
+    return PageList_;
+}
+
+/**
+ * @brief Returns the configurations of the OA.
+ */
+OAConfig ObjectAllocator::GetConfig() const
+{
+    return config;
+}
+
+/**
+ * @brief Returns the statistics of the OA.
+ */
+OAStats ObjectAllocator::GetStats() const
+{
+    return stats;
+}
+
+// ---------- Private methods -------------
+
+/**
+ * @brief Checks if the object is on one of the pages (anywhere on a page, not just on a block boundary). 
+ *        With the CPP manager there are no pages, so nothing is owned.
+ * 
+ * @param Object - the object to look for
+ * @return whether one of the pages has the object
+ */
+bool ObjectAllocator::OwnsObject(const void *Object) const
+{
+    if(config.UseCPPMemManager_)
+        return false;
+
+    return ObjectPageLocation(const_cast<char*>(static_cast<const char*>(Object))) != nullptr;
+}
+
+/**
+ * @brief Returns the header block of a block, wherever the layout keeps it, so a client dumping the pages 
+ *        can read the headers in the side table too.
+ * 
+ * @param Object - a block on one of the pages
+ * @return const void* - the header block (nullptr without header blocks or if the block isn't on a page)
+ */
+const void* ObjectAllocator::GetHeaderBlock(const void *Object) const
+{
+    if(config.HBlockInfo_.type_ == OAConfig::hbNone || !OwnsObject(Object))
+        return nullptr;
+
+    const char* block = static_cast<const char*>(Object);
+
+    return HeaderBlockLocation(ObjectPageLocation(const_cast<char*>(block)), block);
+}
+
+/**
+ * @brief Pushes a node to a list.
+ * 
+ * @param head - head of the list to push to
+ * @param newNode - the node to push
+ */
+void ObjectAllocator::PushFront(GenericObject** head, char* newNode)
+{
+    // Turn the node to a GenericObject
+    GenericObject* node = reinterpret_cast<GenericObject*>(newNode);
+
+    // Push the node to the front
+    node->Next = (*head);
+    (*head) = node;
+}
+
+/**
+ * @brief Allocates a page and adds it to the page list. With OA_INSTRUMENT, the page and the time it took 
+ *        are counted.
+ */
+void ObjectAllocator::AllocatePage()
+{
+#ifdef OA_INSTRUMENT
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+#endif
+
+    AddPage();
+
+#ifdef OA_INSTRUMENT
+    instrumentation.PagesAllocated_++;
+    instrumentation.AllocatePageNanoseconds_ += static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+#endif
+}
+
+/**
+ * @brief Takes the next reserved page (reserving a new chunk first if there are none left), sets it up and 
+ *        adds it to the page list.
+ */
+void ObjectAllocator::AddPage()
+{
+    if(ReservedPages == 0 && ReleasedPages == nullptr)
+        AllocateChunk();
+
+    // Will be the newly allocated page (a mapped file adds back the pages it let go of first)
+    char* newPage = (ReleasedPages != nullptr) ? reinterpret_cast<char*>(ReleasedPages) : NextReservedPage;
+
+    // Keep the chunk so the memory can be given back once all its pages are deleted
+    PageInfo* info = GetPageInfo(newPage);
+    info->chunk_ = CurrentChunk;
+    info->freeCount_ = 0;
+    info->uncarved_ = false;
+
+    if(config.GuardPages_)
+        ProtectGuardPages(newPage);
+
+    try
+    {
+        ReservePartialPages();
+        RegisterPage(newPage);
+    }
+    catch(const std::bad_alloc& e)
+    {
+        throw OAException(OAException::E_NO_MEMORY, "allocate_new_page: No system memory available.");
+    }
+
+    // Take the page off the released or reserved pages
+    if(ReleasedPages != nullptr)
+    {
+        ReleasedPages = ReleasedPages->Next;
+    }
+    else
+    {
+        NextReservedPage += PageStride;
+        ReservedPages--;
+    }
+
+    // Every block of a new page starts out free (with its header blocks cleared)
+    memset(GetPageBitmap(newPage), 0, PageBitmapSize);
+    if(config.SideTableHeaders_)
+        memset(newPage + SideTableOffset, 0, config.HBlockInfo_.size_ * config.ObjectsPerPage_);
+
+    // Push the newly allocated page to the page list
+    PushFront(&PageList_, newPage);
+
+    stats.PagesInUse_++;
+    stats.FreeObjects_ += config.ObjectsPerPage_;
+
+    if(config.Reuse_ != OAConfig::rtLIFO)
+    {
+        // The page's free blocks are kept in its bitmap instead of on the free list
+        info->freeCount_ = config.ObjectsPerPage_;
+        UpdatePartialPages(newPage, 0, config.ObjectsPerPage_);
+
+        if(!config.LazyCarving_)
+        {
+            FormatPage(newPage);
+
+            return;
+        }
+    }
+
+    if(config.LazyCarving_)
+    {
+        // The blocks of the last page that were never carved go on the free list so there's one frontier
+        CarveRemainingBlocks();
+
+        // Leave the blocks untouched, they're carved off as they get allocated
+        FrontierPage = newPage;
+        FrontierBlocks = config.ObjectsPerPage_;
+
+        return;
+    }
+
+    FormatPage(newPage);
+
+    // Add each block to the free list (the first block ends up last in the page's chain, so the whole page 
+    // is spliced onto the front of the free list)
+    for(unsigned int i = 0; i < config.ObjectsPerPage_; ++i)
+    {
+        PushFront(&FreeList_, newPage + FirstBlockOffset + i * FullBlockSize);
+    }
+}
+
+/**
+ * @brief Makes the guard page after each block of a new page inaccessible, so writing past a block faults. 
+ *        Every guard page is its own mapping, so the system's limit on mappings limits the number of blocks.
+ * 
+ * @param page - the new page
+ */
+void ObjectAllocator::ProtectGuardPages(char* page) const
+{
+#ifdef OA_HAS_MMAP
+    for(unsigned int i = 0; i < config.ObjectsPerPage_; ++i)
+    {
+        if(mprotect(page + GuardOffset + i * FullBlockSize, GuardSize, PROT_NONE) != 0)
+            throw OAException(OAException::E_NO_MEMORY, "allocate_new_page: No system memory available.");
+    }
+#else
+    (void)page;
+#endif
+}
+
+/**
+ * @brief Sets up every block of a new page. With debugging on, every block after the second one has the 
+ *        same bytes as the second one (alignment, header, pad and unallocated patterns), so the second 
+ *        block is copied over each of them with one memcpy instead of setting each pattern separately.
+ * 
+ * @param page - the page to set up
+ */
+void ObjectAllocator::FormatPage(char* page)
+{
+    // The second block can't be copied over the others with guard pages (they're in the copied bytes)
+    unsigned formatted = (config.DebugOn_ && !config.GuardPages_) ? 2 : config.ObjectsPerPage_;
+    if(formatted > config.ObjectsPerPage_)
+        formatted = config.ObjectsPerPage_;
+
+    for(unsigned int i = 0; i < formatted; ++i)
+    {
+        FormatBlock(page, i);
+    }
+
+    if(formatted == config.ObjectsPerPage_)
+        return;
+
+    // Everything from the alignment bytes in front of the second block to the end of its right pad bytes
+    const char* second = page + FirstBlockOffset + FullBlockSize - config.PadBytes_ - InlineHeaderSize - config.InterAlignSize_;
+
+    for(unsigned int i = formatted; i < config.ObjectsPerPage_; ++i)
+    {
+        memcpy(page + (second - page) + (i - 1) * FullBlockSize, second, FullBlockSize);
+    }
+}
+
+/**
+ * @brief Sets up the alignment, header block and pad bytes in front of and after a block of a page (with 
+ *        their patterns if debugging is on).
+ * 
+ * @param page - the page the block is on
+ * @param index - 0 for the first block of the page, 1 for the second, etc.
+ * @return char* - the block
+ */
+char* ObjectAllocator::FormatBlock(char* page, unsigned index)
+{
+    char* block = page + FirstBlockOffset + index * FullBlockSize;
+
+    // Location of the header block (nothing is in front of the block when it's in the side table)
+    char* hbLocation = block - config.PadBytes_ - InlineHeaderSize;
+
+    // Location of the alignment bytes in front of the block (the first block uses the left alignment bytes)
+    unsigned alignSize = (index == 0) ? config.LeftAlignSize_ : config.InterAlignSize_;
+    char* alignLocation = hbLocation - alignSize;
+    if(config.DebugOn_ && !config.GuardPages_)
+    {
+        // Set the alignment pattern in front of the block
+        memset(alignLocation, ALIGN_PATTERN, alignSize);
+    }
+
+    // Set header block values to 0 (the side table was cleared with the page)
+    memset(hbLocation, 0, InlineHeaderSize);
+
+    char* paddingLocation = hbLocation + InlineHeaderSize;
+    if(config.DebugOn_)
+    {
+        // Set padding pattern for the beginning of the data block
+        memset(paddingLocation, PAD_PATTERN, config.PadBytes_);
+    }
+
+    if(config.DebugOn_)
+    {
+        // Set the pattern for the free data block
+        memset(block, UNALLOCATED_PATTERN, stats.ObjectSize_);
+    }
+
+    paddingLocation = block + stats.ObjectSize_;
+    if(config.DebugOn_)
+    {
+        // Set padding pattern for the end of the data block (and the alignment bytes up to the guard page)
+        memset(paddingLocation, PAD_PATTERN, config.PadBytes_ + GuardSlack);
+    }
+
+    return block;
+}
+
+/**
+ * @brief Carves the rest of the frontier page's blocks and puts them on the free list (with LIFO reuse).
+ */
+void ObjectAllocator::CarveRemainingBlocks()
+{
+    while(FrontierBlocks > 0)
+    {
+        char* block = FormatBlock(FrontierPage, config.ObjectsPerPage_ - FrontierBlocks);
+
+        // The reuse policies find the free blocks in the page's bitmap
+        if(config.Reuse_ == OAConfig::rtLIFO)
+            PushFront(&FreeList_, block);
+
+        FrontierBlocks--;
+    }
+
+    FrontierPage = nullptr;
+}
+
+/**
+ * @brief Sets up the next page kept by Reset, if there is one. With lazy carving it becomes the frontier 
+ *        page, otherwise all of its blocks are set up and put on the free list at once.
+ */
+void ObjectAllocator::ReuseResetPage()
+{
+    if(ResetPages.empty())
+        return;
+
+    char* page = ResetPages.back();
+    ResetPages.pop_back();
+
+    GetPageInfo(page)->uncarved_ = false;
+
+    if(config.LazyCarving_)
+    {
+        FrontierPage = page;
+        FrontierBlocks = config.ObjectsPerPage_;
+
+        return;
+    }
+
+    FormatPage(page);
+
+    for(unsigned int i = 0; i < config.ObjectsPerPage_; ++i)
+    {
+        PushFront(&FreeList_, page + FirstBlockOffset + i * FullBlockSize);
+    }
+}
+
+/**
+ * @brief Checks if the given block hasn't been carved off its page yet (it's one of the last blocks of the 
+ *        frontier page, or on a page kept by Reset that hasn't been set up again). Uncarved blocks are 
+ *        free, but their bytes haven't been set up.
+ * 
+ * @param page - the page the block is on
+ * @param block - the block to check
+ * @return whether the block is uncarved
+ */
+bool ObjectAllocator::IsBlockUncarved(const char* page, const char* block) const
+{
+    if(GetPageInfo(page)->uncarved_)
+        return true;
+
+    return FrontierBlocks > 0 && page == FrontierPage && BlockIndex(page, block) >= config.ObjectsPerPage_ - FrontierBlocks;
+}
+
+/**
+ * @brief Returns the next block to allocate with the address ordered or most full page reuse policy. The 
+ *        first of the partial pages is picked (the lowest one, or the one with the fewest free blocks) and 
+ *        its lowest free block is found in its allocation bitmap. An uncarved block is carved first (the 
+ *        uncarved blocks are the last of the page, so the lowest free one is always the next to carve).
+ * 
+ * @param page - set to the page the block is on
+ * @return char* - the block
+ */
+char* ObjectAllocator::NextReusedBlock(char** page)
+{
+    (*page) = PartialPages.front();
+
+    // A page kept by Reset has all of its blocks set up the first time it's picked
+    PageInfo* info = GetPageInfo(*page);
+    if(info->uncarved_)
+    {
+        info->uncarved_ = false;
+        FormatPage(*page);
+    }
+
+    // Find the first byte of the bitmap with a free block (the page has at least one), skipping 8 full 
+    // bytes at a time
+    const unsigned char* bitmap = GetPageBitmap(*page);
+    unsigned byte = 0;
+    for(std::uint64_t word; byte + sizeof(word) <= PageBitmapSize; byte += sizeof(word))
+    {
+        memcpy(&word, bitmap + byte, sizeof(word));
+        if(word != ~static_cast<std::uint64_t>(0))
+            break;
+    }
+    while(bitmap[byte] == 0xFF)
+        byte++;
+
+    // Then the first free block of that byte
+    unsigned bit = 0;
+    while(bitmap[byte] & (1 << bit))
+        bit++;
+
+    unsigned index = byte * 8 + bit;
+    if(IsBlockUncarved(*page, (*page) + FirstBlockOffset + index * FullBlockSize))
+        return FormatBlock(*page, index);
+
+    return (*page) + FirstBlockOffset + index * FullBlockSize;
+}
+
+/**
+ * @brief Marks a block of a page as allocated in its bitmap and updates the page's free count.
+ * 
+ * @param page - the page the block is on
+ * @param block - the block being allocated
+ */
+void ObjectAllocator::TakePageBlock(char* page, char* block)
+{
+    if(IsBlockUncarved(page, block))
+        FrontierBlocks--;
+
+    SetBlockAllocated(page, block, true);
+
+    PageInfo* info = GetPageInfo(page);
+    info->freeCount_--;
+    UpdatePartialPages(page, info->freeCount_ + 1, info->freeCount_);
+}
+
+/**
+ * @brief Marks a block of a page as free in its bitmap and updates the page's free count.
+ * 
+ * @param page - the page the block is on
+ * @param block - the block being freed
+ */
+void ObjectAllocator::ReturnPageBlock(char* page, char* block)
+{
+    SetBlockAllocated(page, block, false);
+
+    PageInfo* info = GetPageInfo(page);
+    info->freeCount_++;
+    UpdatePartialPages(page, info->freeCount_ - 1, info->freeCount_);
+}
+
+/**
+ * @brief Moves a page to where its free count puts it in the partial pages. Pages without free blocks 
+ *        aren't kept. With address ordered reuse the pages are only sorted by their address, so the page 
+ *        only moves when it fills up or gets its first free block.
+ * 
+ * @param page - the page whose free count changed
+ * @param oldFreeCount - the free count it had
+ * @param newFreeCount - the free count it has now
+ */
+void ObjectAllocator::UpdatePartialPages(char* page, unsigned oldFreeCount, unsigned newFreeCount)
+{
+    PageInfo* info = GetPageInfo(page);
+
+    if(oldFreeCount == 0)
+    {
+        if(newFreeCount == 0)
+            return;
+
+        // Add the page at the bottom of the heap (there's always room for it)
+        info->partial_ = static_cast<unsigned>(PartialPages.size());
+        PartialPages.push_back(page);
+        SiftPartialPage(info->partial_);
+
+        return;
+    }
+
+    if(newFreeCount == 0)
+    {
+        // Put the last page of the heap where the page was
+        unsigned position = info->partial_;
+        char* last = PartialPages.back();
+        PartialPages.pop_back();
+
+        if(position < PartialPages.size())
+        {
+            PartialPages[position] = last;
+            GetPageInfo(last)->partial_ = position;
+            SiftPartialPage(position);
+        }
+
+        return;
+    }
+
+    // With address ordered reuse, the free count doesn't change where the page goes
+    if(config.Reuse_ == OAConfig::rtMostFullPage)
+        SiftPartialPage(info->partial_);
+}
+
+/**
+ * @brief Checks if a partial page is picked before another one: the one with fewer free blocks with most 
+ *        full page reuse, otherwise (or if they have as many) the lower one.
+ * 
+ * @param left - a partial page
+ * @param right - another partial page
+ * @return whether left is picked first
+ */
+bool ObjectAllocator::IsPartialPageBefore(const char* left, const char* right) const
+{
+    if(config.Reuse_ == OAConfig::rtMostFullPage)
+    {
+        unsigned leftCount = GetPageInfo(left)->freeCount_;
+        unsigned rightCount = GetPageInfo(right)->freeCount_;
+
+        if(leftCount != rightCount)
+            return leftCount < rightCount;
+    }
+
+    return std::less<const char*>()(left, right);
+}
+
+/**
+ * @brief Moves the partial page at the given position up the heap while it's picked before its parent, 
+ *        otherwise down while one of its children is picked before it.
+ * 
+ * @param position - where the page is in the heap
+ */
+void ObjectAllocator::SiftPartialPage(unsigned position)
+{
+    char* page = PartialPages[position];
+
+    // Up
+    while(position > 0)
+    {
+        unsigned parent = (position - 1) / 2;
+        if(!IsPartialPageBefore(page, PartialPages[parent]))
+            break;
+
+        PartialPages[position] = PartialPages[parent];
+        GetPageInfo(PartialPages[position])->partial_ = position;
+        position = parent;
+    }
+
+    // Down
+    unsigned size = static_cast<unsigned>(PartialPages.size());
+    for(;;)
+    {
+        unsigned child = position * 2 + 1;
+        if(child >= size)
+            break;
+
+        if(child + 1 < size && IsPartialPageBefore(PartialPages[child + 1], PartialPages[child]))
+            child++;
+        if(!IsPartialPageBefore(PartialPages[child], page))
+            break;
+
+        PartialPages[position] = PartialPages[child];
+        GetPageInfo(PartialPages[position])->partial_ = position;
+        position = child;
+    }
+
+    PartialPages[position] = page;
+    GetPageInfo(page)->partial_ = position;
+}
+
+/**
+ * @brief Makes room in the partial pages for one more page than the pages in use, so a page can always be 
+ *        added to them without allocating. The room grows by doubling.
+ */
+void ObjectAllocator::ReservePartialPages()
+{
+    if(config.Reuse_ == OAConfig::rtLIFO || PartialPages.capacity() > stats.PagesInUse_)
+        return;
+
+    PartialPages.reserve(PartialPages.capacity() * 2 > stats.PagesInUse_ + 1 ? PartialPages.capacity() * 2 : stats.PagesInUse_ + 1);
+}
+
+/**
+ * @brief Deletes a page. The memory of its chunk is given back to the system once every page of the chunk 
+ *        has been deleted. The pages of a mapped file are kept in the file to be added again instead.
+ * 
+ * @param page - the page to delete
+ */
+void ObjectAllocator::DeletePage(char* page)
+{
+    // The pages of a mapped file stay in the file to be added again
+    if(MappedHeader != nullptr)
+    {
+        PushFront(&ReleasedPages, page);
+
+        return;
+    }
+
+    ReleaseChunkPages(GetPageInfo(page)->chunk_, 1);
+}
+
+/**
+ * @brief Reserves the next run of pages from the system. With fixed growth it's 1 page, with doubling it's 
+ *        twice as many as the last chunk and with capped growth it's twice as many up to MaxGrowthPages_. 
+ *        It never reserves more pages than MaxPages_ still allows. A chunk that's mapped (huge pages, a 
+ *        NUMA node or guard pages) takes whole huge or system pages and is filled with as many pages as fit 
+ *        (up to the max pages).
+ */
+void ObjectAllocator::AllocateChunk()
+{
+    // A mapped file can't grow past the pages it has room for
+    if(MappedHeader != nullptr)
+        throw OAException(OAException::E_NO_PAGES, "allocate_new_page: memory manager out of logical memory (the mapped file is full)");
+
+    unsigned pages = NextChunkPages;
+
+    // Never reserve more than the max pages allows (0 max pages means unlimited)
+    if(config.MaxPages_ != 0 && pages > config.MaxPages_ - stats.PagesInUse_)
+        pages = config.MaxPages_ - stats.PagesInUse_;
+    if(pages == 0)
+        pages = 1;
+
+    size_t size = ChunkHeaderSize + PageAlignPadding + pages * PageStride;
+    char* allocation = nullptr;
+    bool mapped = false;
+
+#ifdef OA_HAS_MMAP
+    // A mapping takes whole system pages (or huge pages), so the chunk is rounded up to them and the rest 
+    // of the last one is used for more pages (as many as the max pages still allows)
+    if(config.NumaNode_ >= 0 || config.GuardPages_ || config.HugePages_)
+    {
+        size_t unit = config.HugePages_ ? HUGE_PAGE_SIZE : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+        size = (size + unit - 1) / unit * unit;
+        unsigned fit = static_cast<unsigned>((size - ChunkHeaderSize - PageAlignPadding) / PageStride);
+        if(config.MaxPages_ != 0 && fit > config.MaxPages_ - stats.PagesInUse_)
+            fit = config.MaxPages_ - stats.PagesInUse_;
+        if(fit > pages)
+            pages = fit;
+    }
+
+    // The pages have to be mapped (not new) to be bound to a NUMA node before they're touched, or to have 
+    // guard pages
+    if((config.NumaNode_ >= 0 || config.GuardPages_) && !config.HugePages_)
+    {
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if(memory == MAP_FAILED)
+            throw OAException(OAException::E_NO_MEMORY, "allocate_new_page: No system memory available.");
+
+        allocation = static_cast<char*>(memory);
+        mapped = true;
+    }
+
+    if(config.HugePages_)
+    {
+        void* memory = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        // Ask for huge pages outright first (this only works if the system has some set aside)
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if(memory == MAP_FAILED)
+        {
+            // Otherwise map normal pages and ask for them to be backed by transparent huge pages
+            memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if(memory != MAP_FAILED)
+                madvise(memory, size, MADV_HUGEPAGE);
+#endif
+        }
+
+        if(memory == MAP_FAILED)
+            throw OAException(OAException::E_NO_MEMORY, "allocate_new_page: No system memory available.");
+
+        allocation = static_cast<char*>(memory);
+        mapped = true;
+    }
+#endif
+
+    if(allocation == nullptr)
+    {
+        try
+        {
+            allocation = new char[size];
+        }
+        catch(const std::bad_alloc& e)
+        {
+            throw OAException(OAException::E_NO_MEMORY, "allocate_new_page: No system memory available.");
+        }
+    }
+
+    if(mapped && config.NumaNode_ >= 0)
+        BindToNumaNode(allocation, size);
+
+    PageChunk* chunk = reinterpret_cast<PageChunk*>(allocation);
+    chunk->allocation_ = allocation;
+    chunk->size_ = size;
+    chunk->pages_ = pages;
+    chunk->mapped_ = mapped;
+
+    OA_COUNT(ChunksReserved_);
+
+    // The first page goes after the chunk, moved up to the alignment if needed
+    char* firstPage = allocation + ChunkHeaderSize;
+    if(PageAlignPadding > 0)
+    {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(firstPage);
+
+        firstPage += (config.Alignment_ - address % config.Alignment_) % config.Alignment_;
+    }
+
+    // The chunk before this one had no pages left to hand out, so it only goes away with its pages
+    CurrentChunk = chunk;
+    NextReservedPage = firstPage;
+    ReservedPages = pages;
+
+    // Grow the next chunk
+    if((config.Growth_ == OAConfig::gtDoubling && NextChunkPages <= UINT_MAX / 2) || 
+       (config.Growth_ == OAConfig::gtCapped && NextChunkPages < config.MaxGrowthPages_))
+    {
+        NextChunkPages *= 2;
+
+        if(config.Growth_ == OAConfig::gtCapped && NextChunkPages > config.MaxGrowthPages_)
+            NextChunkPages = config.MaxGrowthPages_;
+    }
+}
+
+/**
+ * @brief Binds the memory of a new chunk to the configured NUMA node, so its pages are placed on that node 
+ *        whichever thread touches them first (including the debug patterns set when a page is added). The 
+ *        binding is only a placement hint: if the node doesn't exist or the system doesn't support it, the 
+ *        pages are left wherever the system puts them.
+ * 
+ * @param memory - the start of the chunk (page aligned, from mmap)
+ * @param size - the size of the chunk
+ */
+void ObjectAllocator::BindToNumaNode(void* memory, size_t size) const
+{
+#ifdef OA_HAS_MBIND
+    const size_t bitsPerWord = sizeof(unsigned long) * CHAR_BIT;
+    unsigned long nodeMask[1024 / (sizeof(unsigned long) * CHAR_BIT)] = {};
+
+    unsigned node = static_cast<unsigned>(config.NumaNode_);
+    if(node >= sizeof(nodeMask) * CHAR_BIT)
+        return;
+
+    nodeMask[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+
+    // The kernel reads one less bit than it's told to
+    syscall(SYS_mbind, memory, size, OA_MPOL_BIND, nodeMask, sizeof(nodeMask) * CHAR_BIT + 1, 0);
+#else
+    (void)memory;
+    (void)size;
+#endif
+}
+
+/**
+ * @brief Lets go of some pages of a chunk. Once none of its pages are left, the chunk is given back to the 
+ *        system the same way it was allocated.
+ * 
+ * @param chunk - the chunk the pages were reserved with
+ * @param count - the number of pages to let go of
+ */
+void ObjectAllocator::ReleaseChunkPages(PageChunk* chunk, unsigned count)
+{
+    chunk->pages_ -= count;
+    if(chunk->pages_ > 0)
+        return;
+
+    if(chunk == CurrentChunk)
+    {
+        CurrentChunk = nullptr;
+        NextReservedPage = nullptr;
+        ReservedPages = 0;
+    }
+
+#ifdef OA_HAS_MMAP
+    if(chunk->mapped_)
+    {
+        munmap(chunk->allocation_, chunk->size_);
+
+        return;
+    }
+#endif
+
+    delete [] chunk->allocation_;
+}
+
+/**
+ * @brief Maps the pages from a file. The file starts with a header, followed by one chunk with room for 
+ *        every page the pool can have (the max pages). An empty file gets a new pool with its first page. 
+ *        A file saved by an allocator with the same layout is mapped back at the address it was saved 
+ *        at, so the free list, the page list and the objects (including the pointers between them) are 
+ *        used as they are, without touching the pages. Only the page map and the partial pages are 
+ *        rebuilt, by walking the page list.
+ * 
+ * @param path - the file to keep the pages in
+ */
+void ObjectAllocator::OpenMappedFile(const char* path)
+{
+#ifdef OA_HAS_MMAP
+    // The labels of external header blocks live outside the file
+    if(config.HBlockInfo_.type_ == OAConfig::hbExternal)
+        throw OAException(OAException::E_BAD_MAPPED_FILE, "ObjectAllocator: External header blocks can't be kept in a mapped file.");
+
+    // The file has a fixed size, so it needs a limit on the pages
+    if(config.MaxPages_ == 0)
+        config.MaxPages_ = DEFAULT_MAPPED_FILE_PAGES;
+
+    size_t systemPage = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t headerSize = (sizeof(MappedFileHeader) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+    size_t size = headerSize + ChunkHeaderSize + PageAlignPadding + config.MaxPages_ * PageStride;
+    size = (size + systemPage - 1) / systemPage * systemPage;
+
+    int file = open(path, O_RDWR | O_CREAT, 0644);
+    if(file < 0)
+        throw OAException(OAException::E_BAD_MAPPED_FILE, "ObjectAllocator: The mapped file can't be opened.");
+
+    struct stat status;
+    if(fstat(file, &status) != 0)
+    {
+        close(file);
+        throw OAException(OAException::E_BAD_MAPPED_FILE, "ObjectAllocator: The mapped file can't be opened.");
+    }
+
+    MappedFileHeader saved;
+    bool reopen = status.st_size > 0;
+    if(reopen)
+    {
+        // Every byte of the layouts is set, so they can be compared as memory
+        MappedLayout layout = MappedFileLayout(size);
+
+        if(pread(file, &saved, sizeof(saved), 0) != static_cast<ssize_t>(sizeof(saved)) || saved.magic_ != MAPPED_FILE_MAGIC || 
+           memcmp(&saved.layout_, &layout, sizeof(layout)) != 0)
+        {
+            close(file);
+            throw OAException(OAException::E_BAD_MAPPED_FILE, "ObjectAllocator: The mapped file holds a different pool.");
+        }
+
+        // The lists in the header are from before the pool was last changed
+        if(!saved.saved_)
+        {
+            close(file);
+            throw OAException(OAException::E_BAD_MAPPED_FILE, "ObjectAllocator: The mapped file wasn't saved.");
+        }
+    }
+    else if(ftruncate(file, static_cast<off_t>(size)) != 0)
+    {
+        close(file);
+        throw OAException(OAException::E_NO_MEMORY, "ObjectAllocator: No system memory available.");
+    }
+
+    // A saved pool has to go back at the same address (an older system only takes the address as a hint)
+    int flags = MAP_SHARED;
+#ifdef MAP_FIXED_NOREPLACE
+    if(reopen)
+        flags |= MAP_FIXED_NOREPLACE;
+#endif
+    void* memory = mmap(reopen ? saved.base_ : nullptr, size, PROT_READ | PROT_WRITE, flags, file, 0);
+    close(file);
+
+    if(memory != MAP_FAILED && reopen && memory != saved.base_)
+    {
+        munmap(memory, size);
+        memory = MAP_FAILED;
+    }
+    if(memory == MAP_FAILED && reopen)
+        throw OAException(OAException::E_BAD_MAPPED_FILE, "ObjectAllocator: The mapped file can't be mapped at its address.");
+    if(memory == MAP_FAILED)
+        throw OAException(OAException::E_NO_MEMORY, "ObjectAllocator: No system memory available.");
+
+    char* region = static_cast<char*>(memory);
+    if(config.NumaNode_ >= 0)
+        BindToNumaNode(region, size);
+
+    MappedHeader = reinterpret_cast<MappedFileHeader*>(region);
+    CurrentChunk = reinterpret_cast<PageChunk*>(region + headerSize);
+
+    try
+    {
+        if(reopen)
+        {
+            PageList_ = saved.pageList_;
+            FreeList_ = saved.freeList_;
+            ReleasedPages = saved.releasedPages_;
+            NextReservedPage = saved.nextReservedPage_;
+            ReservedPages = saved.reservedPages_;
+            FrontierPage = saved.frontierPage_;
+            FrontierBlocks = saved.frontierBlocks_;
+            stats = saved.stats_;
+
+            ReservePartialPages();
+
+            for(GenericObject* page = PageList_; page != nullptr; page = page->Next)
+            {
+                char* pageBytes = reinterpret_cast<char*>(page);
+                PageInfo* info = GetPageInfo(pageBytes);
+
+                RegisterPage(pageBytes);
+
+                // The pages with free blocks go back in the partial pages, and with LIFO reuse the pages kept 
+                // by Reset that weren't set up again go back in the reset pages
+                if(config.Reuse_ != OAConfig::rtLIFO)
+                    UpdatePartialPages(pageBytes, 0, info->freeCount_);
+                else if(info->uncarved_)
+                    ResetPages.push_back(pageBytes);
+            }
+        }
+        else
+        {
+            // The whole file is one chunk that's never given back
+            CurrentChunk->allocation_ = region;
+            CurrentChunk->size_ = size;
+            CurrentChunk->pages_ = config.MaxPages_;
+            CurrentChunk->mapped_ = true;
+
+            char* firstPage = region + headerSize + ChunkHeaderSize;
+            if(PageAlignPadding > 0)
+            {
+                std::uintptr_t address = reinterpret_cast<std::uintptr_t>(firstPage);
+
+                firstPage += (config.Alignment_ - address % config.Alignment_) % config.Alignment_;
+            }
+
+            NextReservedPage = firstPage;
+            ReservedPages = config.MaxPages_;
+
+            MappedHeader->magic_ = MAPPED_FILE_MAGIC;
+            MappedLayout layout = MappedFileLayout(size);
+            memcpy(&MappedHeader->layout_, &layout, sizeof(layout));
+            MappedHeader->base_ = region;
+
+            AllocatePage();
         }
+    }
+    catch(const std::bad_alloc& e)
+    {
+        munmap(region, size);
+        MappedHeader = nullptr;
 
-        // Go to the next page
-        pageWalker = pageWalker->Next;
+        throw OAException(OAException::E_NO_MEMORY, "ObjectAllocator: No system memory available.");
+    }
+    catch(const OAException& e)
+    {
+        munmap(region, size);
+        MappedHeader = nullptr;
 
-        // Go to the first block in the next page
-        block = reinterpret_cast<unsigned char*>(pageWalker);
-        block += sizeof(GenericObject*) + config.HBlockInfo_.size_ + config.PadBytes_;
+        throw;
     }
 
-    return numCorruptions;
+    // The lists in the header go stale as soon as the pool changes
+    MappedHeader->saved_ = false;
+#else
+    (void)path;
+
+    throw OAException(OAException::E_BAD_MAPPED_FILE, "ObjectAllocator: Mapped files aren't supported on this system.");
+#endif
 }
 
 /**
- * @brief Did not implement.
+ * @brief Returns the layout of this allocator's pages in a mapped file. Two allocators can share a file 
+ *        if their layouts are the same (the unused bytes are cleared so they can be compared as memory).
  * 
- * @return unsigned 
+ * @param size - the size of the file
+ * @return MappedLayout 
  */
-unsigned ObjectAllocator::FreeEmptyPages()
+ObjectAllocator::MappedLayout ObjectAllocator::MappedFileLayout(size_t size) const
 {
-    return 0;
+    MappedLayout layout;
+    memset(&layout, 0, sizeof(layout));
+
+    layout.size_ = size;
+    layout.objectSize_ = stats.ObjectSize_;
+    layout.pageStride_ = PageStride;
+    layout.headerSize_ = config.HBlockInfo_.size_;
+    layout.objectsPerPage_ = config.ObjectsPerPage_;
+    layout.maxPages_ = config.MaxPages_;
+    layout.padBytes_ = config.PadBytes_;
+    layout.alignment_ = config.Alignment_;
+    layout.headerType_ = config.HBlockInfo_.type_;
+    layout.reuse_ = config.Reuse_;
+    layout.debugOn_ = config.DebugOn_;
+    layout.lazyCarving_ = config.LazyCarving_;
+    layout.sideTableHeaders_ = config.SideTableHeaders_;
+
+    return layout;
 }
 
 /**
- * @brief Did not implement.
+ * @brief Returns the bookkeeping kept past the end of the given page.
  * 
- * @return true 
- * @return false 
+ * @param page - the page to get the info of
+ * @return PageInfo* 
  */
-bool ObjectAllocator::ImplementedExtraCredit()
+ObjectAllocator::PageInfo* ObjectAllocator::GetPageInfo(const char* page) const
 {
-    return false;
+    return reinterpret_cast<PageInfo*>(const_cast<char*>(page) + PageInfoOffset);
 }
 
 /**
- * @brief Sets the debug state of the OA.
+ * @brief Returns the allocation bitmap of the given page (right after its page info).
  * 
- * @param State 
+ * @param page - the page to get the bitmap of
+ * @return unsigned char* 
  */
-void ObjectAllocator::SetDebugState(bool State)
+unsigned char* ObjectAllocator::GetPageBitmap(const char* page) const
 {
-    config.DebugOn_ = State;
+    return reinterpret_cast<unsigned char*>(GetPageInfo(page) + 1);
 }
 
 /**
- * @brief Returns the free list (all blocks that are free).
+ * @brief Looks up the page map and returns the address of which page contains the given Object. This 
+ *        takes the same time no matter how many pages there are.
+ * 
+ * @param Object - the object to find the page of
+ * @return char* - the page, or nullptr if the object isn't on any page
  */
-const void* ObjectAllocator::GetFreeList() const
+char* ObjectAllocator::ObjectPageLocation(char* Object) const
 {
-    return FreeList_;
-}
+    // Find the bucket the object falls in
+    std::unordered_map<std::uintptr_t, PageMapBucket>::const_iterator bucket = PageMap.find(reinterpret_cast<std::uintptr_t>(Object) >> PageMapShift);
 
-/**
- * @brief Returns the page list.
- */
-const void* ObjectAllocator::GetPageList() const
-{
-    return PageList_;
+    if(bucket == PageMap.end())
+    {
+        return nullptr;
+    }
+
+    // Check each of the pages overlapping the bucket
+    for(char* page : bucket->second.pages)
+    {
+        if(page != nullptr && Object >= page && Object < page + stats.PageSize_)
+        {
+            return page;
+        }
+    }
+
+    return nullptr;
 }
 
 /**
- * @brief Returns the configurations of the OA.
+ * @brief Adds the given page to every bucket of the page map it overlaps (one or two buckets).
+ * 
+ * @param page - the page to add
  */
-OAConfig ObjectAllocator::GetConfig() const
+void ObjectAllocator::RegisterPage(char* page)
 {
-    return config;
+    std::uintptr_t first = reinterpret_cast<std::uintptr_t>(page) >> PageMapShift;
+    std::uintptr_t last = (reinterpret_cast<std::uintptr_t>(page) + stats.PageSize_ - 1) >> PageMapShift;
+
+    for(std::uintptr_t key = first; key <= last; ++key)
+    {
+        // Creates an empty bucket if there isn't one yet
+        PageMapBucket& bucket = PageMap[key];
+
+        // Put the page in the first unused slot
+        for(char*& slot : bucket.pages)
+        {
+            if(slot == nullptr)
+            {
+                slot = page;
+                break;
+            }
+        }
+    }
 }
 
 /**
- * @brief Returns the statistics of the OA.
+ * @brief Removes the given page from every bucket of the page map it overlaps. Buckets that end up 
+ *        empty are erased.
+ * 
+ * @param page - the page to remove
  */
-OAStats ObjectAllocator::GetStats() const
+void ObjectAllocator::UnregisterPage(char* page)
 {
-    return stats;
-}
+    std::uintptr_t first = reinterpret_cast<std::uintptr_t>(page) >> PageMapShift;
+    std::uintptr_t last = (reinterpret_cast<std::uintptr_t>(page) + stats.PageSize_ - 1) >> PageMapShift;
 
-// ---------- Private methods -------------
+    for(std::uintptr_t key = first; key <= last; ++key)
+    {
+        std::unordered_map<std::uintptr_t, PageMapBucket>::iterator bucket = PageMap.find(key);
+
+        if(bucket == PageMap.end())
+            continue;
+
+        bool empty = true;
+
+        // Clear the page's slot
+        for(char*& slot : bucket->second.pages)
+        {
+            if(slot == page)
+                slot = nullptr;
+
+            if(slot != nullptr)
+                empty = false;
+        }
+
+        if(empty)
+            PageMap.erase(bucket);
+    }
+}
 
 /**
- * @brief Pushes a node to a list.
+ * @brief Returns the index of the given block within its page.
  * 
- * @param head - head of the list to push to
- * @param newNode - the node to push
+ * @param page - the page the block is on
+ * @param block - the block to get the index of
+ * @return unsigned - 0 for the first block of the page, 1 for the second, etc.
  */
-void ObjectAllocator::PushFront(GenericObject** head, char* newNode)
+unsigned ObjectAllocator::BlockIndex(const char* page, const char* block) const
 {
-    // Turn the node to a GenericObject
-    GenericObject* node = reinterpret_cast<GenericObject*>(newNode);
+    const char* firstBlockLocation = page + FirstBlockOffset;
 
-    // Push the node to the front
-    node->Next = (*head);
-    (*head) = node;
+    return static_cast<unsigned>(static_cast<size_t>(block - firstBlockLocation) / FullBlockSize);
 }
 
 /**
- * @brief Allocates a page and adds it to the page list.
+ * @brief Checks if the given block is free. The basic and extended header blocks have a flag byte and 
+ *        external header blocks are only allocated while the block is in use. Without header blocks, the 
+ *        page's allocation bitmap is checked instead. Either way, this doesn't walk the free list.
+ * 
+ * @param page - the page the block is on
+ * @param block - the block to check
+ * @return whether the block is free
  */
-void ObjectAllocator::AllocatePage()
+bool ObjectAllocator::IsBlockFree(const char* page, char* block) const
 {
-    char* newPage; // Will be the newly allocated page
+    // The header of an uncarved block hasn't been set up yet
+    if(IsBlockUncarved(page, block))
+        return true;
 
-    try
-    {
-        newPage = new char[stats.PageSize_];
-    }
-    catch(const std::bad_alloc& e)
+    if(config.HBlockInfo_.type_ == config.hbBasic || config.HBlockInfo_.type_ == config.hbExtended)
     {
-        throw OAException(OAException::E_NO_MEMORY, "allocate_new_page: No system memory available.");
-    }
-
-    // Location of the header block
-    char* hbLocation = newPage + sizeof(GenericObject*);
-    // Set header block values to 0
-    memset(hbLocation, 0, config.HBlockInfo_.size_);
+        // Get the location of the header block flag byte (the last byte of the header)
+        const char* flag = HeaderBlockLocation(page, block) + config.HBlockInfo_.size_ - 1;
 
-    char* paddingLocation = newPage + config.HBlockInfo_.size_ + sizeof(GenericObject*);
-    if(config.DebugOn_)
-    {
-        // Set pad pattern for the start of the first block
-        memset(paddingLocation, PAD_PATTERN, config.PadBytes_);
+        return ((*flag) & 1) == 0;
     }
-
-    // Push the newly allocated page to the page list
-    PushFront(&PageList_, newPage);
-
-    stats.PagesInUse_++;
-    stats.FreeObjects_ += config.ObjectsPerPage_;
-
-    // Set the first block one PageList forward
-    char* block = paddingLocation + config.PadBytes_;
-    if(config.DebugOn_)
+    else if(config.HBlockInfo_.type_ == config.hbExternal)
     {
-        // Set the unallocated pattern the first block
-        memset(block, UNALLOCATED_PATTERN, stats.ObjectSize_);
-    }
+        // Get the location of the external header block structure
+        MemBlockInfo **externalHeaderBlock = reinterpret_cast<MemBlockInfo**>(HeaderBlockLocation(page, block));
 
-    paddingLocation = block + stats.ObjectSize_;
-    if(config.DebugOn_)
-    {
-        // Set pad pattern for the end of the first block
-        memset(paddingLocation, PAD_PATTERN, config.PadBytes_);
+        return (*externalHeaderBlock) == nullptr;
     }
 
-    // Set the free list to the first block
-    FreeList_ = reinterpret_cast<GenericObject*>(block);
-    FreeList_->Next = nullptr;
-
-    for(unsigned int i = 0; i < config.ObjectsPerPage_ - 1; ++i)
-    {
-        // Location of the header block
-        char* hbLocation = paddingLocation + config.PadBytes_;
-        // Set header block values to 0
-        memset(hbLocation, 0, config.HBlockInfo_.size_);
-
-        paddingLocation = paddingLocation + config.PadBytes_ + config.HBlockInfo_.size_;
-        if(config.DebugOn_)
-        {
-            // Set padding pattern for the beginning of the data block
-            memset(paddingLocation, PAD_PATTERN, config.PadBytes_);
-        }
-
-        block = paddingLocation + config.PadBytes_;
-        if(config.DebugOn_)
-        {
-            // Set the pattern for the free data block
-            memset(block, UNALLOCATED_PATTERN, stats.ObjectSize_);
-        }
-
-        paddingLocation = block + stats.ObjectSize_;
-        if(config.DebugOn_)
-        {
-            // Set padding pattern for the end of the data block
-            memset(paddingLocation, PAD_PATTERN, config.PadBytes_);
-        }
+    // Get the bit of the block in the allocation bitmap
+    const unsigned char* bitmap = GetPageBitmap(page);
+    unsigned index = BlockIndex(page, block);
 
-        // Add the data block to the free list
-        PushFront(&FreeList_, block);
-    }
+    return (bitmap[index / 8] & (1 << (index % 8))) == 0;
 }
 
 /**
- * @brief Walks through the given list and check if one of its nodes is the given object.
+ * @brief Returns the header block of the given block: right in front of its left pad bytes, or with side 
+ *        table headers, the entry for its index in its page's side table.
  * 
- * @param list - the list to walk.
- * @param object - the object to compare for.
- * @return - whether it found the object.
+ * @param page - the page the block is on (only needed with side table headers)
+ * @param block - the block
+ * @return char* - the start of the header block
  */
-bool ObjectAllocator::IsObjectInList(GenericObject* list, char* object) const
+char* ObjectAllocator::HeaderBlockLocation(const char* page, const char* block) const
 {
-    // Walk the list
-    while(list != nullptr)
-    {
-        // If it finds the object, return true
-        if(reinterpret_cast<char*>(list) == object)
-        {
-            return true;
-        }
-
-        list = list->Next;
-    }
+    if(config.SideTableHeaders_)
+        return const_cast<char*>(page) + SideTableOffset + BlockIndex(page, block) * config.HBlockInfo_.size_;
 
-    return false;
+    return const_cast<char*>(block) - config.PadBytes_ - config.HBlockInfo_.size_;
 }
 
 /**
- * @brief Walks the page list and returns the address of which page contains the given Object
+ * @brief Marks the given block as allocated or free in its page's allocation bitmap.
  * 
- * @param Object - the object to find the page of
- * @return char** 
+ * @param page - the page the block is on
+ * @param block - the block to mark
+ * @param allocated - true if the block is being allocated, false if it's being freed
  */
-char* ObjectAllocator::ObjectPageLocation(char* Object)
+void ObjectAllocator::SetBlockAllocated(char* page, const char* block, bool allocated) const
 {
-    GenericObject* walker = PageList_;
+    unsigned char* bitmap = GetPageBitmap(page);
+    unsigned index = BlockIndex(page, block);
+    unsigned char bit = static_cast<unsigned char>(1 << (index % 8));
+
+    // Set the bit if allocating, clear it if freeing
+    bitmap[index / 8] = static_cast<unsigned char>(allocated ? bitmap[index / 8] | bit : bitmap[index / 8] & ~bit);
+}
 
-    while(walker != nullptr)
+/**
+ * @brief Rebuilds every page's allocation bitmap from the free list. The bitmaps are only updated while 
+ *        debugging is on without header blocks, so this is done when it gets turned back on and before 
+ *        dumping the blocks in use. The bitmaps live in the pages, so this doesn't change the OA itself.
+ */
+void ObjectAllocator::RebuildAllocationBitmaps() const
+{
+    // Start with every block marked as allocated (the bits past the last block of the page stay clear), 
+    // except on the pages kept by Reset that haven't been set up again (they're all free)
+    unsigned char lastByte = static_cast<unsigned char>(0xFF >> ((8 - config.ObjectsPerPage_ % 8) % 8));
+    for(GenericObject* page = PageList_; page != nullptr; page = page->Next)
     {
-        char* page = reinterpret_cast<char*>(walker);
+        unsigned char* bitmap = GetPageBitmap(reinterpret_cast<char*>(page));
 
-        if(Object >= page && Object <= page + stats.PageSize_)
+        if(GetPageInfo(reinterpret_cast<char*>(page))->uncarved_)
         {
-            return page;
+            memset(bitmap, 0, PageBitmapSize);
+            continue;
         }
 
-        walker = walker->Next;
+        memset(bitmap, 0xFF, PageBitmapSize - 1);
+        bitmap[PageBitmapSize - 1] = lastByte;
     }
 
-    return nullptr;
+    // Then clear the blocks that are on the free list
+    for(GenericObject* block = FreeList_; block != nullptr; block = block->Next)
+    {
+        char* freeBlock = reinterpret_cast<char*>(block);
+
+        SetBlockAllocated(ObjectPageLocation(freeBlock), freeBlock, false);
+    }
+
+    // And the blocks that haven't been carved yet
+    for(unsigned i = config.ObjectsPerPage_ - FrontierBlocks; i < config.ObjectsPerPage_; ++i)
+    {
+        SetBlockAllocated(FrontierPage, FrontierPage + FirstBlockOffset + i * FullBlockSize, false);
+    }
 }
 
 /**
@@ -555,10 +3180,13 @@ void ObjectAllocator::AssignHeaderBlockValues(char* object, bool alloc, const ch
     if(config.HBlockInfo_.type_ == config.hbNone)
         return;
 
+    // Find the header block (the page is only needed when it's in the side table)
+    char* hbLocation = HeaderBlockLocation(config.SideTableHeaders_ ? ObjectPageLocation(object) : nullptr, object);
+
     if(config.HBlockInfo_.type_ == config.hbBasic || config.HBlockInfo_.type_ == config.hbExtended)
     {
-        // Get the location of the header block flag byte
-        char* flag = object - config.PadBytes_ - 1;
+        // Get the location of the header block flag byte (the last byte of the header)
+        char* flag = hbLocation + config.HBlockInfo_.size_ - 1;
         // Set the flag if allocating, clear it if freeing
         alloc ? (*flag) |= 1 : (*flag) &= ~1;
 
@@ -580,7 +3208,7 @@ void ObjectAllocator::AssignHeaderBlockValues(char* object, bool alloc, const ch
     else if(config.HBlockInfo_.type_ == config.hbExternal)
     {
         // Get the location of the external header block structure
-        MemBlockInfo **externalHeaderBlock = reinterpret_cast<MemBlockInfo**>(object - config.PadBytes_ - config.HBlockInfo_.size_);
+        MemBlockInfo **externalHeaderBlock = reinterpret_cast<MemBlockInfo**>(hbLocation);
 
         // Allocate or free the header block
         if(alloc)
@@ -604,33 +3232,25 @@ void ObjectAllocator::AllocateExternalHeaderBlock(MemBlockInfo** externalHeaderB
 {
     try
     {
-        // Allocate the external header block
-        (*externalHeaderBlock) = new MemBlockInfo;
+        // Take the external header block from the header pool
+        (*externalHeaderBlock) = static_cast<MemBlockInfo*>(HeaderPool->Allocate());
     }
-    catch(const std::bad_alloc& e)
+    catch(const OAException& e)
     {
         throw OAException(OAException::E_NO_MEMORY, "assign_header_block: No system memory available.");
     }
 
-    if(label != nullptr)
+    try
     {
-        try
-        {
-            // Allocate memory for the label
-            (*externalHeaderBlock)->label = new char[strlen(label) + 1];
-        }
-        catch(const std::exception& e)
-        {
-            throw OAException(OAException::E_NO_MEMORY, "assign_header_block: No system memory available.");
-        }
-        
-        // Copy the label
-        strncpy((*externalHeaderBlock)->label, label, strlen(label) + 1);
+        // Share the copy of the label with every other block that has the same label
+        (*externalHeaderBlock)->label = InternLabel(label);
     }
-    else
+    catch(const OAException& e)
     {
-        // Set the label to null otherwise it doesn't clean up the label
-        (*externalHeaderBlock)->label = nullptr;
+        HeaderPool->Free(*externalHeaderBlock);
+        (*externalHeaderBlock) = nullptr;
+
+        throw;
     }
 
     // Set the header block values
@@ -645,37 +3265,213 @@ void ObjectAllocator::AllocateExternalHeaderBlock(MemBlockInfo** externalHeaderB
  */
 void ObjectAllocator::FreeExternalHeaderBlock(MemBlockInfo** externalHeaderBlock)
 {
-    // Free the label
-    if((*externalHeaderBlock)->label != nullptr)
+    // The label stays in the arena for the next block with the same label
+    (*externalHeaderBlock)->label = nullptr;
+    
+    // Give the header block back to the header pool
+    HeaderPool->Free(*externalHeaderBlock);
+
+    (*externalHeaderBlock) = nullptr;
+}
+
+/**
+ * @brief Returns the arena copy of the given label, copying it into the arena the first time it's seen. 
+ *        Labels are usually call-site names, so there are few of them and they are kept until the 
+ *        allocator is destroyed.
+ * 
+ * @param label - the label to look up (can be nullptr)
+ * @return char* - the shared copy of the label (nullptr if label is nullptr)
+ */
+char* ObjectAllocator::InternLabel(const char* label)
+{
+    if(label == nullptr)
+        return nullptr;
+
+    // If the label was seen before, share its copy
+    std::unordered_set<const char*, LabelHash, LabelEqual>::const_iterator found = Labels.find(label);
+    if(found != Labels.end())
+    {
+        return const_cast<char*>(*found);
+    }
+
+    size_t length = strlen(label) + 1;
+
+    // If the label doesn't fit in the current chunk, start a new one
+    if(LabelArena == nullptr || LabelArenaUsed + length > LabelArenaSize)
     {
-        delete [] (*externalHeaderBlock)->label;
+        size_t chunkSize = sizeof(char*) + (length > LABEL_ARENA_CHUNK_SIZE ? length : LABEL_ARENA_CHUNK_SIZE);
+        char* chunk;
 
-        (*externalHeaderBlock)->label = nullptr;
+        try
+        {
+            chunk = new char[chunkSize];
+        }
+        catch(const std::bad_alloc& e)
+        {
+            throw OAException(OAException::E_NO_MEMORY, "intern_label: No system memory available.");
+        }
+
+        // Link the new chunk to the previous one so they can all be deleted
+        memcpy(chunk, &LabelArena, sizeof(char*));
+
+        LabelArena = chunk;
+        LabelArenaUsed = sizeof(char*);
+        LabelArenaSize = chunkSize;
     }
-    
-    // Free the header block
-    delete (*externalHeaderBlock);
 
-    (*externalHeaderBlock) = nullptr;
+    // Copy the label into the arena
+    char* copy = LabelArena + LabelArenaUsed;
+    memcpy(copy, label, length);
+
+    try
+    {
+        Labels.insert(copy);
+    }
+    catch(const std::bad_alloc& e)
+    {
+        throw OAException(OAException::E_NO_MEMORY, "intern_label: No system memory available.");
+    }
+
+    LabelArenaUsed += length;
+
+    return copy;
+}
+
+/**
+ * @brief Hashes a label by its characters (FNV-1a).
+ * 
+ * @param label - the label to hash
+ * @return size_t - the hash
+ */
+size_t ObjectAllocator::LabelHash::operator()(const char* label) const
+{
+    size_t hash = static_cast<size_t>(14695981039346656037ULL);
+
+    for(; *label != '\0'; ++label)
+    {
+        hash ^= static_cast<unsigned char>(*label);
+        hash *= static_cast<size_t>(1099511628211ULL);
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Compares two labels by their characters.
+ * 
+ * @return whether the labels are the same
+ */
+bool ObjectAllocator::LabelEqual::operator()(const char* left, const char* right) const
+{
+    return strcmp(left, right) == 0;
 }
 
 /**
  * @brief Checks if the given block is on a bad boundary. For example, if a block of memory starts at
  *        0x04 and the client is trying to free 0x05.
  * 
+ * @param page - the page the block is on (nullptr if it isn't on any page)
  * @param block 
+ * @return whether the block is on a bad boundary
  */
-void ObjectAllocator::CheckForBadBoundary(char* const block)
+bool ObjectAllocator::CheckForBadBoundary(const char* page, char* const block) const
 {
+    // A block that isn't on any page can't be on a boundary either
+    if(page == nullptr)
+        return true;
+
     // Get the location of where the first block would be
-    char* firstBlockLocation = ObjectPageLocation(block) + config.HBlockInfo_.size_ + config.PadBytes_ + sizeof(GenericObject*);
+    const char* firstBlockLocation = page + FirstBlockOffset;
 
     // If the client is trying to free an invalid pointer (a pointer not on a boundary)
-    if((block - firstBlockLocation) % FullBlockSize != 0)
+    return block < firstBlockLocation || (block - firstBlockLocation) % FullBlockSize != 0;
+}
+
+/**
+ * @brief Does the debug checks of a block being freed (nothing is checked with debugging off or the CPP 
+ *        manager): the boundary, a double free and the pad bytes, in that order.
+ * 
+ * @param page - the page the block is on (nullptr if it isn't on any page)
+ * @param block - the block being freed
+ * @param error - where to put the code of the failed check
+ * @return whether a check failed
+ */
+bool ObjectAllocator::CheckFree(const char* page, char* block, OAException::OA_EXCEPTION* error) const
+{
+    if(config.UseCPPMemManager_ || !config.DebugOn_)
+        return false;
+
+    if(CheckForBadBoundary(page, block))
+    {
+        *error = OAException::E_BAD_BOUNDARY;
+        return true;
+    }
+
+    // If the client is trying to double free
+    if(IsBlockFree(page, block))
+    {
+        *error = OAException::E_MULTIPLE_FREE;
+        return true;
+    }
+
+    // The comparison with PAD_PATTERN only works if this is also an unsigned char*
+    if((config.PadBytes_ > 0 || GuardSlack > 0) && CheckForPaddingCorruption(reinterpret_cast<const unsigned char*>(block)))
+    {
+        *error = OAException::E_CORRUPTED_BLOCK;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Returns a freed block to where it came from (delete with the CPP manager, its page with a reuse 
+ *        policy other than LIFO, otherwise the free list) and updates the stats.
+ * 
+ * @param page - the page the block is on (only needed with debugging on or a reuse policy)
+ * @param block - the block being freed
+ */
+void ObjectAllocator::ReleaseBlock(char* page, char* block)
+{
+    if(Trace != nullptr)
+        Trace->RecordFree(block);
+
+    if(config.UseCPPMemManager_)
     {
-        // Throw a bad boundary exception
-        throw OAException(OAException::E_BAD_BOUNDARY, "validate_object: Object not on a boundary.");
+        // Delete with the CPP manager if it's on
+        stats.Deallocations_++;
+        stats.ObjectsInUse_--;
+
+        ForgetSample(block);
+
+        delete [] block;
+
+        return;
     }
+
+    // Mark the block as free in the allocation bitmap
+    if(config.DebugOn_ && config.HBlockInfo_.type_ == OAConfig::hbNone && config.Reuse_ == OAConfig::rtLIFO)
+        SetBlockAllocated(page, block, false);
+
+    // Reset the header block values
+    AssignHeaderBlockValues(block, false);
+
+    // Set the memory back to the freed pattern
+    if(config.DebugOn_)
+        memset(block, FREED_PATTERN, stats.ObjectSize_);
+
+    // Put the block back on its page or the free list
+    if(config.Reuse_ != OAConfig::rtLIFO)
+        ReturnPageBlock(page, block);
+    else
+        PushFront(&FreeList_, block);
+
+    // Update the stats
+    stats.FreeObjects_++;
+    stats.Deallocations_++;
+    stats.ObjectsInUse_--;
+
+    ForgetSample(block);
 }
 
 /**
@@ -690,17 +3486,9 @@ bool ObjectAllocator::CheckForPaddingCorruption(const unsigned char* object) con
     const unsigned char* leftPadding = object - config.PadBytes_;
     const unsigned char* rightPadding = object + stats.ObjectSize_;
 
-    // Go through each pad byte and check if it has been changed
-    for (unsigned int i = 0; i < config.PadBytes_; i++)
-    {
-        // If it has been changed, throw a corruption exception
-        if(leftPadding[i] != PAD_PATTERN || rightPadding[i] != PAD_PATTERN)
-        {
-            return true;
-        }
-    }
-
-    return false;
+    // Check if any of the pad bytes have been changed (a word or more at a time). With guard pages, the 
+    // alignment bytes up to the guard page are checked with the right pad bytes.
+    return !IsPattern(leftPadding, config.PadBytes_, PAD_PATTERN) || !IsPattern(rightPadding, config.PadBytes_ + GuardSlack, PAD_PATTERN);
 }
 
 /**
@@ -714,9 +3502,9 @@ char* ObjectAllocator::AllocateWithCPPManager()
     stats.Allocations_++;
     stats.ObjectsInUse_++;
 
-    if(stats.Allocations_ > stats.MostObjects_)
+    if(stats.ObjectsInUse_ > stats.MostObjects_)
     {
-        stats.MostObjects_ = stats.Allocations_;
+        stats.MostObjects_ = stats.ObjectsInUse_;
     }
 
     char* cppAllocation;
@@ -15,10 +15,27 @@
 //---------------------------------------------------------------------------
 
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
 
 // If the client doesn't specify these:
 static const int DEFAULT_OBJECTS_PER_PAGE = 4;  
 static const int DEFAULT_MAX_PAGES = 3;
+static const int DEFAULT_MAX_GROWTH_PAGES = 64;
+
+// Number of pages a mapped file has room for if the client doesn't limit the pages
+static const unsigned DEFAULT_MAPPED_FILE_PAGES = 1024;
+
+// Size of the pages the system backs huge page allocations with
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Size of each chunk of the arena that external header labels are copied into
+static const size_t LABEL_ARENA_CHUNK_SIZE = 4096;
 
 /*!
   Exception class
@@ -35,14 +52,16 @@ class OAException
       E_NO_PAGES,       //!< out of logical memory (max pages has been reached)
       E_BAD_BOUNDARY,   //!< block address is on a page, but not on any block-boundary
       E_MULTIPLE_FREE,  //!< block has already been freed
-      E_CORRUPTED_BLOCK //!< block has been corrupted (pad bytes have been overwritten)
+      E_CORRUPTED_BLOCK, //!< block has been corrupted (pad bytes have been overwritten)
+      E_BAD_MAPPED_FILE, //!< the mapped file can't hold the pool (or holds a different one)
+      E_BAD_CONFIG       //!< the configuration can't be used for the object size
     };
 
     /*!
       Constructor
 
       \param ErrCode
-        One of the 5 error codes listed above
+        One of the 7 error codes listed above
 
       \param Message
         A message returned by the what method.
@@ -59,7 +78,7 @@ class OAException
       Retrieves the error code
 
       \return
-        One of the 5 error codes.
+        One of the 7 error codes.
     */
     OA_EXCEPTION code() const { 
       return error_code_; 
@@ -75,7 +94,7 @@ class OAException
       return message_.c_str();
     }
   private:  
-    OA_EXCEPTION error_code_; //!< The error code (one of the 5)
+    OA_EXCEPTION error_code_; //!< The error code (one of the 7)
     std::string message_;     //!< The formatted string for the user.
 };
 
@@ -93,6 +112,20 @@ struct OAConfig
   */
   enum HBLOCK_TYPE{hbNone, hbBasic, hbExtended, hbExternal};
 
+  /*!
+    How many pages are reserved from the system at once (the pages are still handed out one at a time)
+  */
+  enum GROWTH_TYPE{gtFixed, gtDoubling, gtCapped};
+
+  /*!
+    Which free block is handed out next: the last one freed (LIFO), the lowest free block of the lowest 
+    page with one (address ordered) or the lowest free block of the page with the fewest free blocks. 
+    Only LIFO links the free blocks through the blocks themselves, so it needs objects at least as large 
+    as a pointer. The others keep one bit per block in the page, so objects smaller than a pointer are 
+    packed at their own size.
+  */
+  enum REUSE_TYPE{rtLIFO, rtAddressOrdered, rtMostFullPage};
+
   /*!
     POD that stores the information related to the header blocks.
   */
@@ -147,6 +180,37 @@ struct OAConfig
 
     \param Alignment
       The number of bytes to align on.
+
+    \param Growth
+      How many pages to reserve each time the reserved pages run out: 1 (fixed), twice as many as 
+      last time (doubling) or twice as many up to MaxGrowthPages (capped).
+
+    \param MaxGrowthPages
+      The most pages reserved at once with capped growth.
+
+    \param HugePages
+      Reserve the pages with mmap on huge pages (rounded up to whole huge pages) instead of new.
+
+    \param LazyCarving
+      Leave the blocks of a new page untouched and carve them off one at a time as they are allocated.
+
+    \param Reuse
+      Which free block is handed out next. The address ordered and most full page policies keep the 
+      free blocks of each page in its allocation bitmap instead of on the free list.
+
+    \param NumaNode
+      The NUMA node to bind the pages to (the pages are reserved with mmap and bound before they're 
+      touched). A value of -1 means the pages go wherever the system puts them.
+
+    \param SideTableHeaders
+      Keep the header blocks in an array past the end of each page (one per block, in block order) 
+      instead of in front of each block, so the objects are packed closer together.
+
+    \param GuardPages
+      End each block on a system page followed by an inaccessible guard page, so writing past the end of 
+      the block faults right away (the pages are reserved with mmap and huge pages aren't used). Writing 
+      into the right pad bytes or the alignment bytes between them and the guard page doesn't fault, so 
+      with debugging on they're checked when freeing (as right pad bytes) like without guard pages.
   */
   OAConfig(bool UseCPPMemManager = false,
            unsigned ObjectsPerPage = DEFAULT_OBJECTS_PER_PAGE, 
@@ -154,13 +218,29 @@ struct OAConfig
            bool DebugOn = false, 
            unsigned PadBytes = 0,
            const HeaderBlockInfo &HBInfo = HeaderBlockInfo(),
-           unsigned Alignment = 0) : UseCPPMemManager_(UseCPPMemManager),
+           unsigned Alignment = 0,
+           GROWTH_TYPE Growth = gtFixed,
+           unsigned MaxGrowthPages = DEFAULT_MAX_GROWTH_PAGES,
+           bool HugePages = false,
+           bool LazyCarving = false,
+           REUSE_TYPE Reuse = rtLIFO,
+           int NumaNode = -1,
+           bool SideTableHeaders = false,
+           bool GuardPages = false) : UseCPPMemManager_(UseCPPMemManager),
                                      ObjectsPerPage_(ObjectsPerPage), 
                                      MaxPages_(MaxPages), 
                                      DebugOn_(DebugOn), 
                                      PadBytes_(PadBytes),
                                      HBlockInfo_(HBInfo),
-                                     Alignment_(Alignment)
+                                     Alignment_(Alignment),
+                                     Growth_(Growth),
+                                     MaxGrowthPages_(MaxGrowthPages),
+                                     HugePages_(HugePages),
+                                     LazyCarving_(LazyCarving),
+                                     Reuse_(Reuse),
+                                     NumaNode_(NumaNode),
+                                     SideTableHeaders_(SideTableHeaders),
+                                     GuardPages_(GuardPages)
   {
     HBlockInfo_ = HBInfo;
     LeftAlignSize_ = 0;  
@@ -176,6 +256,14 @@ struct OAConfig
   unsigned Alignment_;         //!< address alignment of each block
   unsigned LeftAlignSize_;     //!< number of alignment bytes required to align first block
   unsigned InterAlignSize_;    //!< number of alignment bytes required between remaining blocks
+  GROWTH_TYPE Growth_;         //!< how many pages are reserved from the system at once
+  unsigned MaxGrowthPages_;    //!< the most pages reserved at once with capped growth
+  bool HugePages_;             //!< reserve the pages with mmap on huge pages instead of new
+  bool LazyCarving_;           //!< carve the blocks of a new page as they are allocated instead of all at once
+  REUSE_TYPE Reuse_;           //!< which free block is handed out next (not LIFO for objects smaller than a pointer)
+  int NumaNode_;               //!< the NUMA node the pages are bound to (-1=any)
+  bool SideTableHeaders_;      //!< keep the header blocks in an array past each page instead of in front of each block
+  bool GuardPages_;            //!< put an inaccessible system page right after each block
 };
 
 
@@ -200,6 +288,47 @@ struct OAStats
   unsigned Deallocations_; //!< total requests to free memory
 };
 
+// Number of buckets of the latency histograms (bucket i counts latencies from 2^i to 2^(i+1) - 1 ns)
+static const unsigned LATENCY_BUCKETS = 32;
+
+/*!
+  POD that holds the ObjectAllocator instrumentation counters. They are only counted when the OA is 
+  compiled with OA_INSTRUMENT defined (otherwise they stay 0 and cost nothing). The counters belong to 
+  one OA, which is only used by one thread at a time, so they're plain counters (no atomics).
+*/
+struct OAInstrumentation
+{
+  /*!
+    Constructor
+  */
+  OAInstrumentation() : PagesAllocated_(0), ChunksReserved_(0), NoPagesHits_(0), FreeListStalls_(0),
+                        AllocatePageNanoseconds_(0), LatencySampleEvery_(0), AllocateLatency_(), FreeLatency_() {};
+
+  unsigned PagesAllocated_;                    //!< pages added by AllocatePage (the page growth events)
+  unsigned ChunksReserved_;                    //!< runs of pages reserved from the system
+  unsigned NoPagesHits_;                       //!< allocations that failed with E_NO_PAGES
+  unsigned FreeListStalls_;                    //!< allocations that found no free block and had to add a page
+  unsigned long long AllocatePageNanoseconds_; //!< total time spent in AllocatePage
+  unsigned LatencySampleEvery_;                //!< 1 of every this many calls is timed (0 = no sampling)
+  unsigned AllocateLatency_[LATENCY_BUCKETS];  //!< histogram of the sampled Allocate latencies
+  unsigned FreeLatency_[LATENCY_BUCKETS];      //!< histogram of the sampled Free latencies
+};
+
+// Number of return addresses kept for each sampled allocation site
+static const unsigned SAMPLE_STACK_DEPTH = 8;
+
+/*!
+  POD that holds an allocation site seen by the allocation sampling (a label and a call stack)
+*/
+struct OASampledSite
+{
+  const char *label_;                //!< the label given to Allocate (nullptr if none)
+  void *stack_[SAMPLE_STACK_DEPTH];  //!< the return addresses of the calls leading to Allocate (innermost first)
+  unsigned depth_;                   //!< the number of return addresses captured (0 where stacks can't be captured)
+  unsigned sampled_;                 //!< the number of allocations sampled at the site
+  unsigned live_;                    //!< the number of sampled allocations not freed yet
+};
+
 /*!
   This allows us to easily treat raw objects as nodes in a linked list
 */
@@ -214,10 +343,12 @@ struct GenericObject
 struct MemBlockInfo
 {
   bool in_use;        //!< Is the block free or in use?
-  char *label;        //!< A dynamically allocated NUL-terminated string
+  char *label;        //!< A NUL-terminated string (shared by every block with the same label)
   unsigned alloc_num; //!< The allocation number (count) of this block
 };
 
+class TraceRecorder;
+
 /*!
   This class represents a custom memory manager
 */
@@ -227,6 +358,8 @@ class ObjectAllocator
       // Defined by the client (pointer to a block, size of block)
     typedef void (*DUMPCALLBACK)(const void *, size_t);     //!< Callback function when dumping memory leaks
     typedef void (*VALIDATECALLBACK)(const void *, size_t); //!< Callback function when validating blocks
+    typedef void (*SITECALLBACK)(const OASampledSite &, unsigned); //!< Callback function when dumping sampled sites
+    typedef void (*RELOCATECALLBACK)(void *, void *, size_t); //!< Callback function when a block is moved (old block, new block, size)
 
       // Predefined values for memory signatures
     static const unsigned char UNALLOCATED_PATTERN = 0xAA; //!< New memory never given to the client
@@ -235,11 +368,14 @@ class ObjectAllocator
     static const unsigned char PAD_PATTERN =         0xDD; //!< Pad signature to detect buffer over/under flow
     static const unsigned char ALIGN_PATTERN =       0xEE; //!< For the alignment bytes
 
-      // Creates the ObjectManager per the specified values
-      // Throws an exception if the construction fails. (Memory allocation problem)
-    ObjectAllocator(size_t ObjectSize, const OAConfig& config);
+      // Creates the ObjectManager per the specified values. With a MappedFile, the pages are kept in the 
+      // file: a file saved by an earlier allocator with the same configuration is reopened with its 
+      // objects and free blocks as they were, any other empty file gets a new pool.
+      // Throws an exception if the construction fails. (Memory allocation problem, bad mapped file or 
+      // LIFO reuse for objects smaller than a pointer)
+    ObjectAllocator(size_t ObjectSize, const OAConfig& config, const char *MappedFile = 0);
 
-      // Destroys the ObjectManager (never throws)
+      // Destroys the ObjectManager (never throws). A mapped file is saved and keeps its pages.
     ~ObjectAllocator();
 
       // Take an object from the free list and give it to the client (simulates new)
@@ -250,15 +386,67 @@ class ObjectAllocator
       // Throws an exception if the the object can't be freed. (Invalid object)
     void Free(void *Object);
 
+      // Same as Allocate, but returns nullptr instead of throwing when out of pages or system memory
+    void *TryAllocate(const char *label = 0) noexcept;
+
+      // Same as Free, but returns false and sets ErrCode (if given) instead of throwing when a check fails
+    bool TryFree(void *Object, OAException::OA_EXCEPTION *ErrCode = 0) noexcept;
+
+      // Returns an object from a thread other than the one using the allocator (safe to call from any 
+      // thread at any time). The object is queued and only freed when the owner reclaims the queue.
+      // The objects must be at least as large as a pointer (the queue is linked through them).
+    void FreeRemote(void *Object) noexcept;
+
+      // Frees every object queued by FreeRemote (done by Allocate when the free list runs dry)
+      // Throws an exception if one of the objects can't be freed. (Invalid object)
+    unsigned ReclaimRemoteFrees();
+
+      // Takes n objects from the free list at once and puts them in out (simulates n calls to new)
+      // Throws an exception if the objects can't be allocated. (Memory allocation problem)
+      // Nothing is allocated if the batch doesn't fit in the remaining pages.
+    void AllocateN(void **out, size_t n, const char *label = 0);
+
+      // Returns n objects to the free list at once (simulates n calls to delete)
+      // Throws an exception if one of the objects can't be freed. (Invalid object)
+    void FreeN(void *const *in, size_t n);
+
       // Calls the callback fn for each block still in use
     unsigned DumpMemoryInUse(DUMPCALLBACK fn) const;
 
       // Calls the callback fn for each block that is potentially corrupted
     unsigned ValidatePages(VALIDATECALLBACK fn) const;
 
+      // Incremental validation: each call checks the next slice of the pages, picking up where the last 
+      // call stopped and wrapping around to the first page once every page has been checked (one sweep).
+    unsigned ValidateStep(VALIDATECALLBACK fn, unsigned MaxBlocks);      // checks up to MaxBlocks blocks
+    unsigned ValidateFor(VALIDATECALLBACK fn, unsigned Microseconds);    // checks pages until the time is up
+    unsigned ValidateStepsPerSweep(unsigned MaxBlocks) const;            // the most steps a sweep can take
+    unsigned GetValidateSweeps() const;                                  // returns the number of sweeps done
+
       // Frees all empty pages (extra credit)
     unsigned FreeEmptyPages();
 
+      // Frees every block at once (without calling Free for each), keeps up to KeepPages pages and releases 
+      // the rest. The kept pages are set up again as they're needed. Does nothing with the CPP manager.
+      // Throws an exception (before anything is freed) if there's no memory to keep the pages. (E_NO_MEMORY)
+    void Reset(unsigned KeepPages = 1);
+
+      // Moves blocks in use from the sparsest pages into the free blocks of the fullest pages and frees the 
+      // pages this empties (the pages kept by Reset are left alone). fn is called with the old and new address 
+      // of each block moved, and must update every pointer to it. Returns the number of blocks moved (0 once 
+      // the pages can't be packed any tighter). The first call after the pool changes plans the moves, which 
+      // takes time in the number of pages and free blocks; the calls after it pick up where the last one 
+      // stopped and only take time in the number of blocks they move.
+      // Throws an exception if there's no memory for the plan. (E_NO_MEMORY)
+    unsigned Compact(RELOCATECALLBACK fn, unsigned MaxMoves);      // moves up to MaxMoves blocks
+    unsigned CompactFor(RELOCATECALLBACK fn, unsigned Microseconds); // moves blocks until the time is up
+
+      // Writes the state of a pool kept in a mapped file to the file and flushes it, so the file can be 
+      // reopened even if the allocator is never destroyed. Changing the pool after saving it makes the 
+      // file stale again until the next save. Does nothing without a mapped file.
+      // Throws an exception if the file can't be written. (Bad mapped file)
+    void SaveMappedFile();
+
       // Returns true if FreeEmptyPages and alignments are implemented
     static bool ImplementedExtraCredit();
 
@@ -268,6 +456,20 @@ class ObjectAllocator
     const void *GetPageList() const;  // returns a pointer to the internal page list
     OAConfig GetConfig() const;       // returns the configuration parameters
     OAStats GetStats() const;         // returns the statistics for the allocator
+    bool OwnsObject(const void *Object) const;  // checks if the object is on one of the pages
+    const void *GetHeaderBlock(const void *Object) const;  // returns the header block of a block (inline or side table)
+
+      // Instrumentation (only counted when compiled with OA_INSTRUMENT)
+    void SetLatencySampling(unsigned SampleEvery);   // time 1 of every SampleEvery calls (0=off)
+    OAInstrumentation GetInstrumentation() const;    // returns the instrumentation counters
+
+      // Allocation site profiling (each sample stands for SampleEvery allocations)
+    void SetAllocationSampling(unsigned SampleEvery);   // record the site of 1 in SampleEvery allocations on average (0=off)
+    unsigned DumpSampledSites(SITECALLBACK fn) const;   // calls fn for each site (with the sample rate), returns the number of sites
+
+      // Allocation tracing (every Allocate, Free, Reset and FreeEmptyPages is recorded for the replay tool)
+    bool StartTrace(const char *TraceFile);   // starts recording to the file (false if it can't be created)
+    bool StopTrace();                         // stops recording (false if some of the trace couldn't be written)
 
       // Prevent copy construction and assignment
     ObjectAllocator(const ObjectAllocator &oa) = delete;            //!< Do not implement!
@@ -277,14 +479,118 @@ class ObjectAllocator
     // Pushes a node to a list.
     void PushFront(GenericObject** head, char* newNode);
 
-    // Allocates a page and adds it to the page list.
+    // Allocates a page (from the reserved pages) and adds it to the page list.
     void AllocatePage();
 
-    // Walks through the given list and check if one of its nodes is the given object.
-    bool IsObjectInList(GenericObject* list, char* object) const;
+    // Takes the next reserved page, sets it up and adds it to the page list.
+    void AddPage();
+
+    // Sets up the header, padding and alignment bytes of a block of a page and returns the block.
+    char* FormatBlock(char* page, unsigned index);
+
+    // Sets up every block of a new page.
+    void FormatPage(char* page);
+
+    // Puts the rest of the uncarved blocks on the free list.
+    void CarveRemainingBlocks();
+
+    // Sets up the next page kept by Reset so its blocks can be allocated (with LIFO reuse).
+    void ReuseResetPage();
+
+    // Makes the guard page after each block of a new page inaccessible.
+    void ProtectGuardPages(char* page) const;
+
+    // Maps the pages from the given file, reopening the pool saved in it or creating a new one.
+    void OpenMappedFile(const char* path);
+
+    // Checks if the given block hasn't been carved off its page yet.
+    bool IsBlockUncarved(const char* page, const char* block) const;
+
+    // Returns the lowest free block of the page picked by the reuse policy (carving it if needed).
+    char* NextReusedBlock(char** page);
+
+    // Marks a block of a page as allocated (address ordered and most full page reuse).
+    void TakePageBlock(char* page, char* block);
+
+    // Marks a block of a page as free (address ordered and most full page reuse).
+    void ReturnPageBlock(char* page, char* block);
+
+    // Moves a page to where its new free count puts it in the partial pages (never allocates).
+    void UpdatePartialPages(char* page, unsigned oldFreeCount, unsigned newFreeCount);
+
+    // Checks if a partial page is picked before another one (fewer free blocks for most full page, then 
+    // the lower address).
+    bool IsPartialPageBefore(const char* left, const char* right) const;
+
+    // Moves the partial page at the given position up or down the heap to where it belongs.
+    void SiftPartialPage(unsigned position);
+
+    // Makes room in the partial pages for one more page than the pages in use (the only part that allocates).
+    void ReservePartialPages();
+
+    // Deletes a page. The memory goes back to the system once every page reserved with it is deleted.
+    void DeletePage(char* page);
+
+    /*!
+      A run of pages reserved from the system at once. It's kept at the start of the memory, in front
+      of the pages.
+    */
+    struct PageChunk
+    {
+      char* allocation_;  //!< what new or mmap returned
+      size_t size_;       //!< the number of bytes allocated
+      unsigned pages_;    //!< the number of pages of the chunk that haven't been deleted yet
+      bool mapped_;       //!< true if the memory came from mmap (false for new)
+    };
+
+    // Reserves the next run of pages from the system (the number depends on the growth policy).
+    void AllocateChunk();
 
-    // Walks the page list and returns the address of which page contains the given Object
-    char* ObjectPageLocation(char* Object);
+    // Lets go of the given number of pages of a chunk, giving the chunk back to the system if none are left.
+    void ReleaseChunkPages(PageChunk* chunk, unsigned count);
+
+    /*!
+      Bookkeeping kept past the end of each page (it isn't counted in stats.PageSize_). The page's
+      allocation bitmap comes right after it.
+    */
+    struct PageInfo
+    {
+      PageChunk* chunk_;   //!< the chunk the page was reserved with
+      unsigned freeCount_; //!< number of the page's free blocks (kept current by the address ordered and most 
+                           //!< full page policies, only counted by FreeEmptyPages with LIFO reuse)
+      unsigned partial_;   //!< where the page is in the partial pages (while it has free blocks)
+      bool uncarved_;      //!< none of the page's blocks have been set up since Reset (they're all free)
+    };
+
+    // Returns the bookkeeping kept past the end of the given page.
+    PageInfo* GetPageInfo(const char* page) const;
+
+    // Returns the allocation bitmap of the given page.
+    unsigned char* GetPageBitmap(const char* page) const;
+
+    // Looks up the page map and returns the address of which page contains the given Object
+    char* ObjectPageLocation(char* Object) const;
+
+    // Adds the given page to every bucket of the page map it overlaps.
+    void RegisterPage(char* page);
+
+    // Removes the given page from every bucket of the page map it overlaps.
+    void UnregisterPage(char* page);
+
+    // Returns the index of the given block within its page.
+    unsigned BlockIndex(const char* page, const char* block) const;
+
+    // Returns the header block of the given block, in front of it or in its page's side table.
+    char* HeaderBlockLocation(const char* page, const char* block) const;
+
+    // Checks if the given block is free, using the header flag or the page's allocation bitmap.
+    bool IsBlockFree(const char* page, char* block) const;
+
+    // Marks the given block as allocated or free in its page's allocation bitmap.
+    void SetBlockAllocated(char* page, const char* block, bool allocated) const;
+
+    // Rebuilds every page's allocation bitmap from the free list.
+    void RebuildAllocationBitmaps() const;
 
     // Assigns the values to the header block of the given object depending on the header block type.
     void AssignHeaderBlockValues(char* block, bool alloc, const char* label = "");\
@@ -292,10 +598,102 @@ class ObjectAllocator
     void AllocateExternalHeaderBlock(MemBlockInfo** externalHeaderBlock, const char* label = "");
     // Frees the external header block.
     void FreeExternalHeaderBlock(MemBlockInfo** externalHeaderBlock);
+    // Returns the arena copy of the given label, copying it into the arena the first time it's seen.
+    char* InternLabel(const char* label);
+
+    /*!
+      Hashes a label by its characters
+    */
+    struct LabelHash
+    {
+      size_t operator()(const char* label) const; //!< FNV-1a hash of the label
+    };
+
+    /*!
+      Compares labels by their characters
+    */
+    struct LabelEqual
+    {
+      bool operator()(const char* left, const char* right) const; //!< true if the labels are the same
+    };
 
     // Checks if the given block is on a bad boundary. For example, if a block of memory starts at 
     // 0x04 and the client is trying to free 0x05.
-    void CheckForBadBoundary(char* const block);
+    bool CheckForBadBoundary(const char* page, char* const block) const;
+
+    // Does the debug checks of a block being freed, returns true and sets error if one fails.
+    bool CheckFree(const char* page, char* block, OAException::OA_EXCEPTION* error) const;
+
+    // Returns a freed block to its page or the free list and updates the stats (the checks are done).
+    void ReleaseBlock(char* page, char* block);
+
+    // Counts the free blocks of each page (with LIFO reuse, the other policies keep the counts current).
+    void CountFreeBlocks();
+
+    // Moves blocks in use from the sparsest pages to the fullest (Microseconds of 0 means no time limit).
+    unsigned MoveBlocks(RELOCATECALLBACK fn, unsigned MaxMoves, unsigned Microseconds);
+
+    // Moves a block in use to a free block of another page (its object bytes and header block).
+    void MoveBlock(char* fromPage, char* from, char* toPage, char* to);
+
+    // Sorts the pages partly in use for Compact and orders the page list and free list by its plan.
+    void PlanCompaction();
+
+    // Adds the free blocks of a page to the end of the free list (CompactFreeTail is its last block).
+    void ListFreeBlocks(char* page);
+
+    // Takes the empty page link points to off the page list and lets go of it.
+    void ReleaseEmptyPage(GenericObject** link);
+
+    /*!
+      The configuration a mapped file's pages were laid out with. A file is only reopened by an allocator 
+      that lays out its pages the same way.
+    */
+    struct MappedLayout
+    {
+      size_t size_;             //!< the size of the file
+      size_t objectSize_;       //!< the size of each object
+      size_t pageStride_;       //!< bytes from one page to the next
+      size_t headerSize_;       //!< the size of the header blocks
+      unsigned objectsPerPage_; //!< number of blocks on each page
+      unsigned maxPages_;       //!< number of pages the file has room for
+      unsigned padBytes_;       //!< number of pad bytes on each side of a block
+      unsigned alignment_;      //!< the alignment of the blocks
+      int headerType_;          //!< the kind of header blocks
+      int reuse_;               //!< the reuse policy (how the free blocks are kept)
+      bool debugOn_;            //!< whether the blocks have the debug patterns
+      bool lazyCarving_;        //!< whether the blocks are carved as they're allocated
+      bool sideTableHeaders_;   //!< whether the header blocks are in the side tables
+    };
+
+    /*!
+      Kept at the start of a mapped file, in front of its pages. The lists point into the file, so it's 
+      always mapped at the same address.
+    */
+    struct MappedFileHeader
+    {
+      std::uint64_t magic_;          //!< marks the file as holding a pool
+      MappedLayout layout_;          //!< how the pages are laid out
+      char* base_;                   //!< the address the file is mapped at
+      bool saved_;                   //!< the state below matches the pages (false while the pool is in use)
+      GenericObject* pageList_;      //!< the page list
+      GenericObject* freeList_;      //!< the free list
+      GenericObject* releasedPages_; //!< the pages let go of by FreeEmptyPages and Reset
+      char* nextReservedPage_;       //!< the next page never used yet
+      unsigned reservedPages_;       //!< the number of pages never used yet
+      char* frontierPage_;           //!< the page being carved with lazy carving
+      unsigned frontierBlocks_;      //!< the number of blocks of the frontier page not carved yet
+      OAStats stats_;                //!< the statistics
+    };
+
+    // Returns the layout of this allocator's pages in a mapped file of the given size.
+    MappedLayout MappedFileLayout(size_t size) const;
+
+    // Binds the memory of a new chunk to the configured NUMA node (before it's touched).
+    void BindToNumaNode(void* memory, size_t size) const;
+
+    // Pushes a chain of blocks (first to last, already linked) onto the remote free queue.
+    void PushRemoteFrees(GenericObject* first, GenericObject* last) noexcept;
 
     // Checks for corruption for an object. In other words, checks if the pad bytes have been changed.
     bool CheckForPaddingCorruption(const unsigned char* object) const;
@@ -312,8 +710,172 @@ class ObjectAllocator
     OAConfig config;
     OAStats stats;
 
-    // this is the full size of each data block, including object size, padding size * 2 (one for each side), and header block size 
+    // this is the full size of each data block, including object size, padding size * 2 (one for each side), header block size
+    // and the inter-block alignment bytes
     size_t FullBlockSize;
+
+    // the offset from the start of a page to its first data block
+    size_t FirstBlockOffset;
+
+    // number of bytes kept past the end of each page (stats.PageSize_) for the page info, allocation bitmap 
+    // and side table
+    size_t PageTailSize;
+
+    // number of header block bytes in front of each block (0 when they're in the side table)
+    size_t InlineHeaderSize;
+
+    // with guard pages, the size of a system page (0 without guard pages) and the offset from the start of 
+    // a page to the guard page after its first block
+    size_t GuardSize;
+    size_t GuardOffset;
+
+    // with guard pages and debugging on, the alignment bytes between a block's right pad bytes and its guard 
+    // page (they can be written to without faulting, so they're checked with the right pad bytes)
+    size_t GuardSlack;
+
+    // the offset from the start of a page to its side table of header blocks
+    size_t SideTableOffset;
+
+    // the offset from the start of a page to its page info
+    size_t PageInfoOffset;
+
+    // number of bytes of the page tail used by the allocation bitmap
+    size_t PageBitmapSize;
+
+    // extra bytes allocated with each chunk to move its pages up to the alignment (0 when new is already aligned enough)
+    size_t PageAlignPadding;
+
+    // bytes from the start of one page of a chunk to the next (the page and its tail, rounded up to the alignment)
+    size_t PageStride;
+
+    // bytes kept for the PageChunk at the start of each chunk (rounded up so the pages stay aligned)
+    size_t ChunkHeaderSize;
+
+    // the header at the start of the mapped file (nullptr without a mapped file)
+    MappedFileHeader* MappedHeader;
+    // with a mapped file, the pages let go of by FreeEmptyPages and Reset (they stay in the file and are 
+    // added again before the pages never used yet)
+    GenericObject* ReleasedPages;
+
+    // the chunk pages are being handed out from (nullptr before the first chunk)
+    PageChunk* CurrentChunk;
+    // the next page of the current chunk to hand out and how many are left to hand out
+    char* NextReservedPage;
+    unsigned ReservedPages;
+
+    // the number of pages the next chunk will reserve (before being limited by MaxPages_)
+    unsigned NextChunkPages;
+
+    // the instrumentation counters (only counted with OA_INSTRUMENT)
+    OAInstrumentation instrumentation;
+
+    // the number of calls left until the next one is timed
+    unsigned LatencyCountdown;
+
+    // Returns the histogram to add the latency of this call to (nullptr if it isn't sampled).
+    unsigned* SampleLatency(unsigned* histogram);
+
+    // 1 of every this many allocations has its site recorded (0 = no sampling)
+    unsigned AllocationSampleEvery;
+    // the number of allocations left until the next one is sampled
+    unsigned AllocationCountdown;
+    // the state of the random number generator that spaces out the samples
+    std::uint32_t SampleRandom;
+
+    // Returns the number of allocations until the next sample (SampleEvery on average).
+    unsigned NextSampleInterval();
+
+    // every site seen by the sampling
+    std::vector<OASampledSite> Sites;
+    // finds the sites with the same hash of their label and stack
+    std::unordered_multimap<size_t, unsigned> SiteLookup;
+    // the site of each sampled block still in use
+    std::unordered_map<const void*, unsigned> SampledBlocks;
+
+    // Counts down to the next sampled allocation and records its site.
+    void SampleAllocation(void* block, const char* label);
+
+    // Records the block and its label and stack in the site table.
+    void RecordSample(void* block, const char* label);
+
+    // Takes a freed block out of the sampled blocks.
+    void ForgetSample(void* block);
+
+    // records the calls to a trace file (nullptr when not tracing)
+    TraceRecorder* Trace;
+
+    // with lazy carving, the page whose blocks are still being carved off (nullptr if none) and how many 
+    // of its blocks haven't been carved yet (they are the last ones of the page and count as free)
+    char* FrontierPage;
+    unsigned FrontierBlocks;
+
+    // the page and block the next validation step starts at (nullptr to start a new sweep at the first 
+    // page) and the number of sweeps finished
+    char* ValidatePage;
+    unsigned ValidateBlock;
+    unsigned ValidateSweeps;
+
+    // the blocks freed by other threads, waiting for the owner to reclaim them (pushed by any thread with a 
+    // compare-and-swap, taken all at once by the owner with an exchange, so there's no ABA problem)
+    std::atomic<GenericObject*> RemoteFrees;
+
+    // with address ordered or most full page reuse, the pages that have free blocks in a binary min-heap by 
+    // the order they're picked in (the free count for most full page, then the address). There's room for 
+    // every page in use, so freeing a block never allocates.
+    std::vector<char*> PartialPages;
+
+    // with LIFO reuse, the pages kept by Reset that haven't been set up again yet (the last one is next)
+    std::vector<char*> ResetPages;
+
+    // Compact's plan: the pages partly in use from the fullest to the sparsest (they're also the end of the 
+    // page list, in the same order), the next page to fill, one past the next page to empty and the next 
+    // block of each to look at. It's kept between calls while the pool doesn't change.
+    std::vector<char*> CompactPages;
+    size_t CompactTo;
+    size_t CompactFrom;
+    unsigned CompactToIndex;
+    unsigned CompactFromIndex;
+
+    // with LIFO reuse, Compact lists the free blocks by their page: the pages to fill in the order they're 
+    // filled, then the other pages, then the pages to empty (the sparsest one last). So the blocks moved to 
+    // are taken off the front, and an emptied page's blocks are cut off the end after the block kept for it 
+    // (nullptr if its blocks start the free list). The last block of the free list is kept too.
+    std::vector<GenericObject*> CompactLinks;
+    GenericObject* CompactFreeTail;
+
+    // whether there's a plan and the stats it's for (the pool changed if they don't match)
+    bool CompactPlanned;
+    unsigned CompactAllocations;
+    unsigned CompactDeallocations;
+    unsigned CompactPagesInUse;
+
+    /*!
+      The pages overlapping one bucket of the page map. A bucket is at least as large as a page, so
+      no more than 3 pages can overlap it (the end of one, one whole page and the start of another).
+    */
+    struct PageMapBucket
+    {
+      char* pages[3]; //!< the overlapping pages (nullptr for unused slots)
+    };
+
+    // maps an address shifted right by PageMapShift to the pages overlapping that bucket, so the page 
+    // owning a pointer can be found without walking the page list
+    std::unordered_map<std::uintptr_t, PageMapBucket> PageMap;
+
+    // log2 of the page map bucket size (the page size rounded up to a power of 2)
+    unsigned PageMapShift;
+
+    // where the external header blocks come from (nullptr unless using external headers)
+    ObjectAllocator* HeaderPool;
+
+    // the arena copies of every label seen, looked up by their characters
+    std::unordered_set<const char*, LabelHash, LabelEqual> Labels;
+
+    // the current chunk of the label arena (it starts with a pointer to the previous chunk)
+    char* LabelArena;
+    // bytes used and total size of the current chunk
+    size_t LabelArenaUsed;
+    size_t LabelArenaSize;
 };
 
 #endif
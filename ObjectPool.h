@@ -0,0 +1,386 @@
+/**
+ * @file ObjectPool.h
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief This is a typed, compile-time configured version of the Object Allocator (OA) for release builds.
+ *        The object size, header blocks, padding and alignment come from a policy, so every offset in the
+ *        block layout is a constant and the debug branches of the OA don't exist. The pages have the same
+ *        layout as the OA's pages. Objects are constructed and destroyed in place with emplace/destroy.
+ * @date 10-14-2026
+ */
+
+//---------------------------------------------------------------------------
+#ifndef OBJECTPOOLH
+#define OBJECTPOOLH
+//---------------------------------------------------------------------------
+
+#include "ObjectAllocator.h"
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+/*!
+  The compile-time configuration of an ObjectPool. These are the same as the OAConfig values, except
+  there is no debugging and no external headers (labels need the OA).
+*/
+template <unsigned ObjectsPerPage = DEFAULT_OBJECTS_PER_PAGE,
+          unsigned MaxPages = DEFAULT_MAX_PAGES,
+          OAConfig::HBLOCK_TYPE HeaderType = OAConfig::hbNone,
+          unsigned PadBytes = 0,
+          unsigned Alignment = 0,
+          unsigned HeaderAdditional = 0>
+struct PoolPolicy
+{
+  static constexpr unsigned ObjectsPerPage_ = ObjectsPerPage;          //!< number of objects on each page
+  static constexpr unsigned MaxPages_ = MaxPages;                      //!< maximum number of pages (0=unlimited)
+  static constexpr OAConfig::HBLOCK_TYPE HeaderType_ = HeaderType;     //!< which of the header types to use
+  static constexpr unsigned PadBytes_ = PadBytes;                      //!< size of the left/right padding for each block
+  static constexpr unsigned Alignment_ = Alignment;                    //!< address alignment of each block (0=none)
+  static constexpr unsigned HeaderAdditional_ = HeaderAdditional;      //!< user-defined bytes of extended headers
+};
+
+/*!
+  This class is a pool of T objects whose block layout is fixed at compile time
+*/
+template <typename T, typename Policy = PoolPolicy<> >
+class ObjectPool
+{
+    static_assert(Policy::ObjectsPerPage_ > 0, "a page needs at least one object");
+    static_assert(Policy::HeaderType_ != OAConfig::hbExternal, "external headers need the ObjectAllocator");
+
+  public:
+      // Creates the pool and allocates the first page
+      // Throws an exception if the construction fails. (Memory allocation problem)
+    ObjectPool();
+
+      // Deletes every page (objects still in use are not destroyed)
+    ~ObjectPool();
+
+      // Takes a block from the free list and constructs a T in it with the given arguments
+      // Throws an exception if the block can't be allocated (or whatever the constructor throws)
+    template <typename... Args>
+    T *emplace(Args&&... args);
+
+      // Destroys the object and returns its block to the free list
+    void destroy(T *object);
+
+      // Takes a block from the free list without constructing anything (simulates new)
+      // Throws an exception if the block can't be allocated. (Memory allocation problem)
+    void *Allocate();
+
+      // Returns a block to the free list without destroying anything (simulates delete)
+    void Free(void *Object);
+
+      // Testing/Debugging/Statistic methods
+    const void *GetFreeList() const;  // returns a pointer to the internal free list
+    const void *GetPageList() const;  // returns a pointer to the internal page list
+    OAConfig GetConfig() const;       // returns the configuration parameters (as an OAConfig)
+    OAStats GetStats() const;         // returns the statistics for the pool
+
+      // Prevent copy construction and assignment
+    ObjectPool(const ObjectPool &pool) = delete;            //!< Do not implement!
+    ObjectPool &operator=(const ObjectPool &pool) = delete; //!< Do not implement!
+
+  private:
+    // Returns the larger of the two values.
+    static constexpr size_t Max(size_t a, size_t b) { return a > b ? a : b; }
+    // Returns the number of bytes needed to move the given size up to the alignment.
+    static constexpr size_t AlignBytes(size_t size, size_t alignment) { return (alignment - size % alignment) % alignment; }
+
+    // the object size (a free block has to hold the free list pointer)
+    static constexpr size_t ObjectSize = Max(sizeof(T), sizeof(GenericObject*));
+
+    // the size of the header blocks
+    static constexpr size_t HeaderSize = Policy::HeaderType_ == OAConfig::hbBasic ? OAConfig::BASIC_HEADER_SIZE :
+                                         Policy::HeaderType_ == OAConfig::hbExtended ? sizeof(unsigned int) + sizeof(unsigned short) + sizeof(char) + Policy::HeaderAdditional_ :
+                                         0;
+
+    // the alignment of each block (at least what's needed for T and the free list pointer)
+    static constexpr size_t Alignment = Max(Max(Policy::Alignment_, alignof(T)), alignof(GenericObject*));
+
+    // number of alignment bytes required to align first block and between the remaining blocks
+    static constexpr size_t LeftAlignSize = AlignBytes(sizeof(GenericObject*) + HeaderSize + Policy::PadBytes_, Alignment);
+    static constexpr size_t InterAlignSize = AlignBytes(ObjectSize + Policy::PadBytes_ * 2 + HeaderSize, Alignment);
+
+    // the full size of each block, the offset to the first block and the size of a page
+    static constexpr size_t FullBlockSize = ObjectSize + Policy::PadBytes_ * 2 + HeaderSize + InterAlignSize;
+    static constexpr size_t FirstBlockOffset = sizeof(GenericObject*) + LeftAlignSize + HeaderSize + Policy::PadBytes_;
+    static constexpr size_t PageSize = sizeof(GenericObject*) + LeftAlignSize + FullBlockSize * Policy::ObjectsPerPage_ - InterAlignSize;
+
+    // pages that need more alignment than new gives are over-allocated, and the real allocation is kept after the page
+    static constexpr size_t PageAlignPadding = alignof(std::max_align_t) % Alignment != 0 ? Alignment - 1 : 0;
+    static constexpr size_t AllocationOffset = PageSize + AlignBytes(PageSize, alignof(char*));
+
+    // Allocates a page and adds its blocks to the free list.
+    void AllocatePage();
+
+    // Sets the header block values of a block that is being allocated or freed.
+    void AssignHeaderBlockValues(char *block, bool alloc);
+
+  private:
+    GenericObject *PageList_; //!< the beginning of the list of pages
+    GenericObject *FreeList_; //!< the beginning of the list of objects
+    OAStats stats;            //!< the statistics for the pool
+};
+
+/**
+ * @brief Creates the pool and allocates the first page.
+ */
+template <typename T, typename Policy>
+ObjectPool<T, Policy>::ObjectPool() : PageList_(nullptr), FreeList_(nullptr)
+{
+    stats.ObjectSize_ = ObjectSize;
+    stats.PageSize_ = PageSize;
+
+    AllocatePage();
+}
+
+/**
+ * @brief Deletes every page. Objects still in use are not destroyed.
+ */
+template <typename T, typename Policy>
+ObjectPool<T, Policy>::~ObjectPool()
+{
+    while(PageList_ != nullptr)
+    {
+        char* page = reinterpret_cast<char*>(PageList_);
+        PageList_ = PageList_->Next;
+
+        char* allocation;
+        memcpy(&allocation, page + AllocationOffset, sizeof(char*));
+
+        delete [] allocation;
+    }
+}
+
+/**
+ * @brief Takes a block from the free list and constructs a T in it with the given arguments. If the
+ *        constructor throws, the block goes back on the free list.
+ *
+ * @param args - the arguments for T's constructor
+ * @return T* - the constructed object
+ */
+template <typename T, typename Policy>
+template <typename... Args>
+T* ObjectPool<T, Policy>::emplace(Args&&... args)
+{
+    void* block = Allocate();
+
+    try
+    {
+        return new (block) T(std::forward<Args>(args)...);
+    }
+    catch(...)
+    {
+        Free(block);
+
+        throw;
+    }
+}
+
+/**
+ * @brief Destroys the object and returns its block to the free list.
+ *
+ * @param object - the object to destroy (nullptr does nothing)
+ */
+template <typename T, typename Policy>
+void ObjectPool<T, Policy>::destroy(T *object)
+{
+    if(object == nullptr)
+        return;
+
+    object->~T();
+
+    Free(object);
+}
+
+/**
+ * @brief Takes a block from the free list without constructing anything.
+ *
+ * @return void* - the allocated block
+ */
+template <typename T, typename Policy>
+void* ObjectPool<T, Policy>::Allocate()
+{
+    // If we are out of free objects
+    if(FreeList_ == nullptr)
+    {
+        // If we have another available page (0 max pages means unlimited)
+        if(Policy::MaxPages_ == 0 || stats.PagesInUse_ < Policy::MaxPages_)
+        {
+            AllocatePage();
+        }
+        else
+        {
+            throw OAException(OAException::E_NO_PAGES, "Allocate: memory manager out of logical memory (max pages has been reached)");
+        }
+    }
+
+    // Update the stats
+    stats.FreeObjects_--;
+    stats.Allocations_++;
+    stats.ObjectsInUse_++;
+
+    if(stats.ObjectsInUse_ > stats.MostObjects_)
+    {
+        stats.MostObjects_ = stats.ObjectsInUse_;
+    }
+
+    // Take the first block on the free list
+    char* block = reinterpret_cast<char*>(FreeList_);
+    FreeList_ = FreeList_->Next;
+
+    AssignHeaderBlockValues(block, true);
+
+    return block;
+}
+
+/**
+ * @brief Returns a block to the free list without destroying anything.
+ *
+ * @param Object - the block to free
+ */
+template <typename T, typename Policy>
+void ObjectPool<T, Policy>::Free(void *Object)
+{
+    char* block = static_cast<char*>(Object);
+
+    AssignHeaderBlockValues(block, false);
+
+    // Put the block back on the free list
+    GenericObject* node = reinterpret_cast<GenericObject*>(block);
+    node->Next = FreeList_;
+    FreeList_ = node;
+
+    // Update the stats
+    stats.FreeObjects_++;
+    stats.Deallocations_++;
+    stats.ObjectsInUse_--;
+}
+
+/**
+ * @brief Returns the free list.
+ */
+template <typename T, typename Policy>
+const void* ObjectPool<T, Policy>::GetFreeList() const
+{
+    return FreeList_;
+}
+
+/**
+ * @brief Returns the page list.
+ */
+template <typename T, typename Policy>
+const void* ObjectPool<T, Policy>::GetPageList() const
+{
+    return PageList_;
+}
+
+/**
+ * @brief Returns the policy of the pool as an OAConfig, with the alignment sizes that were computed.
+ */
+template <typename T, typename Policy>
+OAConfig ObjectPool<T, Policy>::GetConfig() const
+{
+    OAConfig config(false, Policy::ObjectsPerPage_, Policy::MaxPages_, false, Policy::PadBytes_,
+                    OAConfig::HeaderBlockInfo(Policy::HeaderType_, Policy::HeaderAdditional_), static_cast<unsigned>(Alignment));
+
+    config.LeftAlignSize_ = static_cast<unsigned>(LeftAlignSize);
+    config.InterAlignSize_ = static_cast<unsigned>(InterAlignSize);
+
+    return config;
+}
+
+/**
+ * @brief Returns the statistics of the pool.
+ */
+template <typename T, typename Policy>
+OAStats ObjectPool<T, Policy>::GetStats() const
+{
+    return stats;
+}
+
+// ---------- Private methods -------------
+
+/**
+ * @brief Allocates a page and adds its blocks to the free list. The header blocks are zeroed and the rest of
+ *        the page is left alone, since there is no debugging.
+ */
+template <typename T, typename Policy>
+void ObjectPool<T, Policy>::AllocatePage()
+{
+    char* allocation;
+
+    try
+    {
+        allocation = new char[AllocationOffset + sizeof(char*) + PageAlignPadding];
+    }
+    catch(const std::bad_alloc& e)
+    {
+        throw OAException(OAException::E_NO_MEMORY, "allocate_new_page: No system memory available.");
+    }
+
+    // Move the page up to the alignment if needed
+    char* page = allocation + (PageAlignPadding > 0 ? AlignBytes(reinterpret_cast<std::uintptr_t>(allocation), Alignment) : 0);
+
+    // Keep the real allocation so the page can be deleted
+    memcpy(page + AllocationOffset, &allocation, sizeof(char*));
+
+    // Push the page to the page list
+    GenericObject* pageNode = reinterpret_cast<GenericObject*>(page);
+    pageNode->Next = PageList_;
+    PageList_ = pageNode;
+
+    // Push each block to the free list (the last block ends up first)
+    char* block = page + FirstBlockOffset;
+    for(unsigned i = 0; i < Policy::ObjectsPerPage_; ++i, block += FullBlockSize)
+    {
+        if(HeaderSize > 0)
+        {
+            memset(block - Policy::PadBytes_ - HeaderSize, 0, HeaderSize);
+        }
+
+        GenericObject* node = reinterpret_cast<GenericObject*>(block);
+        node->Next = FreeList_;
+        FreeList_ = node;
+    }
+
+    stats.PagesInUse_++;
+    stats.FreeObjects_ += Policy::ObjectsPerPage_;
+}
+
+/**
+ * @brief Sets the header block values of a block the same way the OA does. The header type is a constant,
+ *        so this compiles down to nothing without header blocks.
+ *
+ * @param block - the block being allocated or freed
+ * @param alloc - true if allocating, false if freeing
+ */
+template <typename T, typename Policy>
+void ObjectPool<T, Policy>::AssignHeaderBlockValues(char *block, bool alloc)
+{
+    if(HeaderSize == 0)
+        return;
+
+    // Set the flag if allocating, clear it if freeing
+    char* flag = block - Policy::PadBytes_ - 1;
+    alloc ? (*flag) |= 1 : (*flag) &= ~1;
+
+    // Set the 4-byte alloc# if allocating, clear it if freeing
+    unsigned allocNum = alloc ? stats.Allocations_ : 0;
+    memcpy(flag - sizeof(unsigned), &allocNum, sizeof(unsigned));
+
+    // Increase the 2-byte reuse number if allocating
+    if(Policy::HeaderType_ == OAConfig::hbExtended && alloc)
+    {
+        char* reuseLocation = flag - sizeof(unsigned) - sizeof(unsigned short);
+        unsigned short reuse;
+
+        memcpy(&reuse, reuseLocation, sizeof(unsigned short));
+        reuse++;
+        memcpy(reuseLocation, &reuse, sizeof(unsigned short));
+    }
+}
+
+#endif
@@ -0,0 +1,325 @@
+/**
+ * @file PoolAllocators.h
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief These adapters let standard containers get their memory from an Object Allocator (OA). Requests
+ *        that fit in one of the OA's blocks (no larger than its object size and no more aligned than its
+ *        blocks) go to the OA, everything else goes to a fallback. PoolAllocator<T> is a classic allocator
+ *        (the fallback is std::allocator) and PoolMemoryResource is a std::pmr::memory_resource (the
+ *        fallback is an upstream resource, only with C++17). For node-based containers, make the OA's
+ *        object size the size of the container's nodes, not just the size of T.
+ * @date 10-14-2026
+ */
+
+//---------------------------------------------------------------------------
+#ifndef POOLALLOCATORSH
+#define POOLALLOCATORSH
+//---------------------------------------------------------------------------
+
+#include "ObjectAllocator.h"
+#include <cstddef>
+#include <memory>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define OA_HAS_PMR
+#endif
+#endif
+
+/**
+ * @brief Returns the alignment every block of the given OA is guaranteed to have. The pages are aligned to
+ *        the fundamental alignment (or the OA's alignment if it's larger), so the blocks are aligned to the
+ *        largest power of 2 that divides the page alignment, the offset of the first block and the distance
+ *        between blocks.
+ *
+ * @param pool - the object allocator
+ * @return size_t - the alignment of the blocks
+ */
+inline size_t PoolBlockAlignment(const ObjectAllocator& pool)
+{
+    OAConfig config = pool.GetConfig();
+
+    // new has the fundamental alignment
+    if(config.UseCPPMemManager_)
+        return alignof(std::max_align_t);
+
+    size_t pageAlignment = alignof(std::max_align_t);
+    if(config.Alignment_ > pageAlignment && (config.Alignment_ & (config.Alignment_ - 1)) == 0)
+        pageAlignment = config.Alignment_;
+
+    // The header blocks in a side table aren't in front of the blocks
+    size_t header = config.SideTableHeaders_ ? 0 : config.HBlockInfo_.size_;
+
+    size_t firstBlock = sizeof(GenericObject*) + config.LeftAlignSize_ + header + config.PadBytes_;
+    size_t fullBlock = pool.GetStats().ObjectSize_ + config.PadBytes_ * 2 + header + config.InterAlignSize_;
+
+    // The lowest bit set in any of them
+    size_t bits = pageAlignment | firstBlock | fullBlock;
+
+    return bits & (~bits + 1);
+}
+
+/*!
+  A classic allocator that takes single objects that fit from an ObjectAllocator
+*/
+template <typename T>
+class PoolAllocator
+{
+  public:
+    typedef T value_type; //!< the type of object allocated
+
+      // Allocates from the given pool (the pool must outlive the allocator and its copies)
+    explicit PoolAllocator(ObjectAllocator& pool) noexcept;
+
+      // Allocates from the same pool as the other allocator (for containers rebinding to their nodes)
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept;
+
+      // Takes a block from the pool for a single object that fits, otherwise uses std::allocator
+      // Throws an exception if the memory can't be allocated. (Memory allocation problem)
+    T *allocate(size_t n);
+
+      // Returns the memory to wherever allocate got it from
+    void deallocate(T *p, size_t n);
+
+      // Returns the pool the allocator takes its blocks from
+    ObjectAllocator *GetPool() const noexcept;
+
+  private:
+    template <typename U>
+    friend class PoolAllocator;
+
+    // Checks if n objects go to the pool (one object that fits in a block).
+    bool UsePool(size_t n) const noexcept;
+
+    ObjectAllocator *Pool; //!< where the blocks come from
+    size_t ObjectSize;     //!< the size of the pool's blocks
+    size_t Alignment;      //!< the alignment of the pool's blocks
+};
+
+/**
+ * @brief Creates an allocator for the given pool.
+ *
+ * @param pool - the object allocator to take blocks from
+ */
+template <typename T>
+PoolAllocator<T>::PoolAllocator(ObjectAllocator& pool) noexcept : Pool(&pool), ObjectSize(pool.GetStats().ObjectSize_),
+                                                                  Alignment(PoolBlockAlignment(pool))
+{
+}
+
+/**
+ * @brief Creates an allocator for the same pool as another one.
+ *
+ * @param other - the allocator to share the pool with
+ */
+template <typename T>
+template <typename U>
+PoolAllocator<T>::PoolAllocator(const PoolAllocator<U>& other) noexcept : Pool(other.Pool), ObjectSize(other.ObjectSize),
+                                                                          Alignment(other.Alignment)
+{
+}
+
+/**
+ * @brief Allocates memory for n objects. A single object that fits in a block comes from the pool.
+ *
+ * @param n - the number of objects
+ * @return T* - the memory
+ */
+template <typename T>
+T* PoolAllocator<T>::allocate(size_t n)
+{
+    if(UsePool(n))
+        return static_cast<T*>(Pool->Allocate());
+
+    return std::allocator<T>().allocate(n);
+}
+
+/**
+ * @brief Frees memory for n objects, to the pool if allocate took it from there.
+ *
+ * @param p - the memory
+ * @param n - the number of objects (the same as allocate was given)
+ */
+template <typename T>
+void PoolAllocator<T>::deallocate(T *p, size_t n)
+{
+    if(UsePool(n))
+    {
+        Pool->Free(p);
+
+        return;
+    }
+
+    std::allocator<T>().deallocate(p, n);
+}
+
+/**
+ * @brief Returns the pool the allocator takes its blocks from.
+ *
+ * @return ObjectAllocator*
+ */
+template <typename T>
+ObjectAllocator* PoolAllocator<T>::GetPool() const noexcept
+{
+    return Pool;
+}
+
+/**
+ * @brief Checks if n objects go to the pool.
+ *
+ * @param n - the number of objects
+ * @return whether it's one object that fits in a block
+ */
+template <typename T>
+bool PoolAllocator<T>::UsePool(size_t n) const noexcept
+{
+    return n == 1 && sizeof(T) <= ObjectSize && alignof(T) <= Alignment;
+}
+
+/**
+ * @brief Allocators are equal if they use the same pool (memory from one can be freed by the other).
+ */
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>& left, const PoolAllocator<U>& right) noexcept
+{
+    return left.GetPool() == right.GetPool();
+}
+
+/**
+ * @brief Allocators are different if they use different pools.
+ */
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>& left, const PoolAllocator<U>& right) noexcept
+{
+    return !(left == right);
+}
+
+#ifdef OA_HAS_PMR
+
+/*!
+  A memory resource that takes requests that fit from an ObjectAllocator
+*/
+class PoolMemoryResource : public std::pmr::memory_resource
+{
+  public:
+      // Allocates from the given pool, anything that doesn't fit goes to upstream (both must outlive it)
+    explicit PoolMemoryResource(ObjectAllocator& pool, std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) noexcept;
+
+      // Returns the pool the resource takes its blocks from
+    ObjectAllocator *GetPool() const noexcept;
+
+      // Returns the resource used for requests that don't fit in a block
+    std::pmr::memory_resource *GetUpstream() const noexcept;
+
+  protected:
+      // Takes a block from the pool if the request fits, otherwise uses upstream
+    void *do_allocate(size_t bytes, size_t alignment) override;
+
+      // Returns the memory to wherever do_allocate got it from
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+      // Resources are equal only if they're the same resource
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+  private:
+    // Checks if a request goes to the pool (it fits in a block).
+    bool UsePool(size_t bytes, size_t alignment) const noexcept;
+
+    ObjectAllocator *Pool;                 //!< where the blocks come from
+    std::pmr::memory_resource *Upstream;   //!< where everything else comes from
+    size_t ObjectSize;                     //!< the size of the pool's blocks
+    size_t Alignment;                      //!< the alignment of the pool's blocks
+};
+
+/**
+ * @brief Creates a resource for the given pool.
+ *
+ * @param pool - the object allocator to take blocks from
+ * @param upstream - the resource for requests that don't fit in a block
+ */
+inline PoolMemoryResource::PoolMemoryResource(ObjectAllocator& pool, std::pmr::memory_resource *upstream) noexcept
+    : Pool(&pool), Upstream(upstream), ObjectSize(pool.GetStats().ObjectSize_), Alignment(PoolBlockAlignment(pool))
+{
+}
+
+/**
+ * @brief Returns the pool the resource takes its blocks from.
+ *
+ * @return ObjectAllocator*
+ */
+inline ObjectAllocator* PoolMemoryResource::GetPool() const noexcept
+{
+    return Pool;
+}
+
+/**
+ * @brief Returns the resource used for requests that don't fit in a block.
+ *
+ * @return std::pmr::memory_resource*
+ */
+inline std::pmr::memory_resource* PoolMemoryResource::GetUpstream() const noexcept
+{
+    return Upstream;
+}
+
+/**
+ * @brief Allocates memory, from the pool if it fits in a block.
+ *
+ * @param bytes - the number of bytes needed
+ * @param alignment - the alignment needed
+ * @return void* - the memory
+ */
+inline void* PoolMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+    if(UsePool(bytes, alignment))
+        return Pool->Allocate();
+
+    return Upstream->allocate(bytes, alignment);
+}
+
+/**
+ * @brief Frees memory, to the pool if do_allocate took it from there.
+ *
+ * @param p - the memory
+ * @param bytes - the number of bytes (the same as do_allocate was given)
+ * @param alignment - the alignment (the same as do_allocate was given)
+ */
+inline void PoolMemoryResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    if(UsePool(bytes, alignment))
+    {
+        Pool->Free(p);
+
+        return;
+    }
+
+    Upstream->deallocate(p, bytes, alignment);
+}
+
+/**
+ * @brief Memory from a pool resource can only be freed by the same resource.
+ *
+ * @param other - the resource to compare with
+ * @return whether they're the same resource
+ */
+inline bool PoolMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+/**
+ * @brief Checks if a request goes to the pool.
+ *
+ * @param bytes - the number of bytes
+ * @param alignment - the alignment
+ * @return whether it fits in a block
+ */
+inline bool PoolMemoryResource::UsePool(size_t bytes, size_t alignment) const noexcept
+{
+    return bytes <= ObjectSize && alignment <= Alignment;
+}
+
+#endif
+
+#endif
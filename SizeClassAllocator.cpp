@@ -0,0 +1,297 @@
+/**
+ * @file SizeClassAllocator.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief This is a general purpose front-end for the Object Allocator (OA). It owns one OA per size class
+ *        and sends each allocation to the smallest class that fits, found with a lookup table indexed by
+ *        the size. Frees find the class that owns the block through a map of every page of every class,
+ *        so the caller doesn't pass the size back. Sizes larger than the largest class go to new/delete.
+ * @date 10-14-2026
+ */
+
+#include "SizeClassAllocator.h"
+#include <algorithm>
+
+/**
+ * @brief Returns the size classes used if the client doesn't specify them.
+ * 
+ * @return std::vector<size_t> - 8 to 256 bytes, about 25% to 50% apart
+ */
+std::vector<size_t> SizeClassAllocator::DefaultSizeClasses()
+{
+    static const size_t sizes[] = { 8, 16, 24, 32, 48, 64, 80, 96, 128, 160, 192, 256 };
+
+    return std::vector<size_t>(sizes, sizes + sizeof(sizes) / sizeof(sizes[0]));
+}
+
+/**
+ * @brief Creates an object allocator for each size class and the lookup table that picks one for each size.
+ * 
+ * @param SizeClasses - the object size of each size class (in any order)
+ * @param config - the configuration settings every size class uses (a class smaller than a pointer uses 
+ *                 address ordered reuse instead of LIFO)
+ */
+SizeClassAllocator::SizeClassAllocator(const std::vector<size_t>& SizeClasses, const OAConfig& config) : Sizes(SizeClasses), OwnerShift(0)
+{
+    // Sort the classes, drop the duplicates and the empty class
+    std::sort(Sizes.begin(), Sizes.end());
+    Sizes.erase(std::unique(Sizes.begin(), Sizes.end()), Sizes.end());
+    Sizes.erase(std::remove(Sizes.begin(), Sizes.end(), static_cast<size_t>(0)), Sizes.end());
+
+    try
+    {
+        for(size_t size : Sizes)
+        {
+            // A class smaller than a pointer can't use LIFO reuse, it keeps its free blocks in the page bitmaps
+            OAConfig classConfig = config;
+            if(size < sizeof(GenericObject*) && classConfig.Reuse_ == OAConfig::rtLIFO)
+                classConfig.Reuse_ = OAConfig::rtAddressOrdered;
+
+            Classes.push_back(nullptr);
+            Classes.back() = new ObjectAllocator(size, classConfig);
+        }
+    }
+    catch(const std::bad_alloc& e)
+    {
+        for(ObjectAllocator* sizeClass : Classes)
+            delete sizeClass;
+
+        throw OAException(OAException::E_NO_MEMORY, "SizeClassAllocator: No system memory available.");
+    }
+    catch(const OAException& e)
+    {
+        for(ObjectAllocator* sizeClass : Classes)
+            delete sizeClass;
+
+        throw;
+    }
+
+    if(Sizes.empty())
+        return;
+
+    // Point every multiple of the granule at the smallest class that fits it (the multiple past the largest 
+    // class gets the largest class)
+    Lookup.resize((Sizes.back() + SIZE_CLASS_GRANULE - 1) / SIZE_CLASS_GRANULE + 1);
+    unsigned sizeClass = 0;
+    for(size_t i = 0; i < Lookup.size(); ++i)
+    {
+        while(sizeClass + 1 < Sizes.size() && Sizes[sizeClass] < i * SIZE_CLASS_GRANULE)
+            sizeClass++;
+
+        Lookup[i] = sizeClass;
+    }
+
+    // Make the owner map buckets the largest power of 2 no larger than the smallest page
+    size_t smallestPage = Classes[0]->GetStats().PageSize_;
+    for(ObjectAllocator* oa : Classes)
+        smallestPage = std::min(smallestPage, oa->GetStats().PageSize_);
+
+    while((static_cast<size_t>(2) << OwnerShift) <= smallestPage)
+        OwnerShift++;
+
+    // Each class already has its first page
+    for(unsigned i = 0; i < Classes.size(); ++i)
+        RegisterPages(i);
+}
+
+/**
+ * @brief Destroys every size class (along with its pages).
+ */
+SizeClassAllocator::~SizeClassAllocator()
+{
+    for(ObjectAllocator* sizeClass : Classes)
+        delete sizeClass;
+}
+
+/**
+ * @brief Allocates a block from the smallest size class that fits. The class is found with one look up (and 
+ *        a step past any smaller class in the same granule). If the allocation makes the class add a page, 
+ *        the page is added to the owner map.
+ * 
+ * @param Size - the number of bytes needed
+ * @param label - the label to assign an external block
+ * @return void* - The allocated block
+ */
+void* SizeClassAllocator::Allocate(size_t Size, const char *label)
+{
+    // Past the largest class, by-pass the size classes
+    if(Sizes.empty() || Size > Sizes.back())
+    {
+        try
+        {
+            return new char[Size];
+        }
+        catch(const std::bad_alloc& e)
+        {
+            throw OAException(OAException::E_NO_MEMORY, "allocate: No system memory available.");
+        }
+    }
+
+    // The entry for the granule multiple at or below the size is the smallest class that could fit, step 
+    // past the classes between that multiple and the size
+    unsigned sizeClass = Lookup[Size / SIZE_CLASS_GRANULE];
+    while(Sizes[sizeClass] < Size)
+        sizeClass++;
+
+    ObjectAllocator* oa = Classes[sizeClass];
+
+    unsigned pages = oa->GetStats().PagesInUse_;
+    void* block = oa->Allocate(label);
+
+    // A new page goes on the front of the page list
+    if(oa->GetStats().PagesInUse_ != pages)
+        RegisterPage(static_cast<const char*>(oa->GetPageList()), sizeClass);
+
+    return block;
+}
+
+/**
+ * @brief Frees a block back to the size class that owns it. If no class owns it, it was too large for the 
+ *        size classes so it's deleted instead.
+ * 
+ * @param Object - the object to free
+ */
+void SizeClassAllocator::Free(void *Object)
+{
+    unsigned sizeClass = OwningClass(static_cast<const char*>(Object));
+
+    if(sizeClass == Classes.size())
+    {
+        delete [] static_cast<char*>(Object);
+
+        return;
+    }
+
+    Classes[sizeClass]->Free(Object);
+}
+
+/**
+ * @brief Frees all empty pages of every size class, then rebuilds the owner map from the pages left.
+ * 
+ * @return unsigned - Number of pages freed
+ */
+unsigned SizeClassAllocator::FreeEmptyPages()
+{
+    unsigned numFreed = 0;
+
+    for(ObjectAllocator* sizeClass : Classes)
+        numFreed += sizeClass->FreeEmptyPages();
+
+    if(numFreed > 0)
+    {
+        Owners.clear();
+
+        for(unsigned i = 0; i < Classes.size(); ++i)
+            RegisterPages(i);
+    }
+
+    return numFreed;
+}
+
+/**
+ * @brief Returns the number of size classes.
+ * 
+ * @return size_t 
+ */
+size_t SizeClassAllocator::GetClassCount() const
+{
+    return Sizes.size();
+}
+
+/**
+ * @brief Returns the object size of a size class.
+ * 
+ * @param index - the size class (0 is the smallest)
+ * @return size_t 
+ */
+size_t SizeClassAllocator::GetClassSize(size_t index) const
+{
+    return Sizes[index];
+}
+
+/**
+ * @brief Returns the statistics of a size class.
+ * 
+ * @param index - the size class (0 is the smallest)
+ * @return OAStats 
+ */
+OAStats SizeClassAllocator::GetClassStats(size_t index) const
+{
+    return Classes[index]->GetStats();
+}
+
+/**
+ * @brief Adds a page to every bucket of the owner map it overlaps.
+ * 
+ * @param page - the page to add
+ * @param sizeClass - the size class the page belongs to
+ */
+void SizeClassAllocator::RegisterPage(const char *page, unsigned sizeClass)
+{
+    // The CPP manager doesn't have pages
+    if(page == nullptr)
+        return;
+
+    size_t pageSize = Classes[sizeClass]->GetStats().PageSize_;
+    std::uintptr_t first = reinterpret_cast<std::uintptr_t>(page) >> OwnerShift;
+    std::uintptr_t last = (reinterpret_cast<std::uintptr_t>(page) + pageSize - 1) >> OwnerShift;
+
+    try
+    {
+        for(std::uintptr_t key = first; key <= last; ++key)
+        {
+            // Creates an empty bucket if there isn't one yet
+            OwnerBucket& bucket = Owners[key];
+
+            // Put the page in the first unused slot
+            for(PageOwner& owner : bucket.owners)
+            {
+                if(owner.page_ == nullptr)
+                {
+                    owner.page_ = page;
+                    owner.size_ = pageSize;
+                    owner.class_ = sizeClass;
+                    break;
+                }
+            }
+        }
+    }
+    catch(const std::bad_alloc& e)
+    {
+        throw OAException(OAException::E_NO_MEMORY, "allocate: No system memory available.");
+    }
+}
+
+/**
+ * @brief Adds every page of a size class to the owner map.
+ * 
+ * @param sizeClass - the size class
+ */
+void SizeClassAllocator::RegisterPages(unsigned sizeClass)
+{
+    const GenericObject* page = static_cast<const GenericObject*>(Classes[sizeClass]->GetPageList());
+
+    for(; page != nullptr; page = page->Next)
+        RegisterPage(reinterpret_cast<const char*>(page), sizeClass);
+}
+
+/**
+ * @brief Looks up the owner map for the size class whose page contains the given object.
+ * 
+ * @param Object - the object to find the owner of
+ * @return unsigned - the size class (the number of classes if no class owns it)
+ */
+unsigned SizeClassAllocator::OwningClass(const char *Object) const
+{
+    std::unordered_map<std::uintptr_t, OwnerBucket>::const_iterator bucket = Owners.find(reinterpret_cast<std::uintptr_t>(Object) >> OwnerShift);
+
+    if(bucket != Owners.end())
+    {
+        for(const PageOwner& owner : bucket->second.owners)
+        {
+            if(owner.page_ != nullptr && Object >= owner.page_ && Object < owner.page_ + owner.size_)
+                return owner.class_;
+        }
+    }
+
+    return static_cast<unsigned>(Classes.size());
+}
@@ -0,0 +1,104 @@
+/**
+ * @file SizeClassAllocator.h
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief This is a general purpose front-end for the Object Allocator (OA). It owns one OA per size class
+ *        and sends each allocation to the smallest class that fits, found with a lookup table indexed by
+ *        the size. Frees find the class that owns the block through a map of every page of every class,
+ *        so the caller doesn't pass the size back. Sizes larger than the largest class go to new/delete.
+ * @date 10-14-2026
+ */
+
+//---------------------------------------------------------------------------
+#ifndef SIZECLASSALLOCATORH
+#define SIZECLASSALLOCATORH
+//---------------------------------------------------------------------------
+
+#include "ObjectAllocator.h"
+#include <vector>
+
+// The lookup table has an entry for every multiple of this many bytes
+static const size_t SIZE_CLASS_GRANULE = 8;
+
+/*!
+  This class routes allocations of any size to one ObjectAllocator per size class
+*/
+class SizeClassAllocator
+{
+  public:
+      // The size classes used if the client doesn't specify them (8 to 256 bytes).
+    static std::vector<size_t> DefaultSizeClasses();
+
+      // Creates an ObjectAllocator for each size class (sorted, duplicates and 0 are dropped), all with the
+      // same configuration (except that classes smaller than a pointer use address ordered reuse instead of
+      // LIFO). Throws an exception if the construction fails. (Memory allocation problem)
+    SizeClassAllocator(const std::vector<size_t>& SizeClasses = DefaultSizeClasses(),
+                       const OAConfig& config = OAConfig(false, DEFAULT_OBJECTS_PER_PAGE, 0));
+
+      // Destroys every size class (never throws)
+    ~SizeClassAllocator();
+
+      // Takes an object from the smallest size class that fits (new is used past the largest class)
+      // Throws an exception if the object can't be allocated. (Memory allocation problem)
+    void *Allocate(size_t Size, const char *label = 0);
+
+      // Returns an object to the size class that owns it (delete if it wasn't from any class)
+      // Throws an exception if the the object can't be freed. (Invalid object)
+    void Free(void *Object);
+
+      // Frees all empty pages of every size class
+    unsigned FreeEmptyPages();
+
+      // Testing/Debugging/Statistic methods
+    size_t GetClassCount() const;                 // returns the number of size classes
+    size_t GetClassSize(size_t index) const;      // returns the object size of a size class
+    OAStats GetClassStats(size_t index) const;    // returns the statistics of a size class
+
+      // Prevent copy construction and assignment
+    SizeClassAllocator(const SizeClassAllocator &sca) = delete;            //!< Do not implement!
+    SizeClassAllocator &operator=(const SizeClassAllocator &sca) = delete; //!< Do not implement!
+
+  private:
+    /*!
+      A page of one of the size classes
+    */
+    struct PageOwner
+    {
+      const char *page_; //!< the start of the page (nullptr for an unused slot)
+      size_t size_;      //!< the size of the page
+      unsigned class_;   //!< the size class the page belongs to
+    };
+
+    /*!
+      The pages overlapping one bucket of the owner map. A bucket is no larger than the smallest page,
+      so no more than 2 pages can overlap it (the end of one and the start of another).
+    */
+    struct OwnerBucket
+    {
+      PageOwner owners[2]; //!< the overlapping pages
+    };
+
+    // Adds a page of the given size class to every bucket of the owner map it overlaps.
+    void RegisterPage(const char *page, unsigned sizeClass);
+
+    // Adds every page of the given size class to the owner map.
+    void RegisterPages(unsigned sizeClass);
+
+    // Returns the size class owning the given object (or the number of classes if none does).
+    unsigned OwningClass(const char *Object) const;
+
+  private:
+    std::vector<size_t> Sizes;             //!< the object size of each size class (smallest first)
+    std::vector<ObjectAllocator*> Classes; //!< the allocator of each size class
+
+    // the index of the smallest size class fitting each multiple of SIZE_CLASS_GRANULE bytes, up to the
+    // first multiple at or past the largest class
+    std::vector<unsigned> Lookup;
+
+    // maps an address shifted right by OwnerShift to the pages overlapping that bucket
+    std::unordered_map<std::uintptr_t, OwnerBucket> Owners;
+
+    // log2 of the owner map bucket size (the smallest page size rounded down to a power of 2)
+    unsigned OwnerShift;
+};
+
+#endif
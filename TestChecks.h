@@ -0,0 +1,65 @@
+/**
+ * @file TestChecks.h
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief What the test programs (the *test targets of the Makefile) share. Each check that fails prints one
+ *        line and is counted, and the program returns 1 if any did. Also the callbacks and the debug
+ *        configuration several of them use. Each test program is one translation unit that includes it.
+ * @date 10-15-2026
+ */
+
+//---------------------------------------------------------------------------
+#ifndef TESTCHECKSH
+#define TESTCHECKSH
+//---------------------------------------------------------------------------
+
+#include "ObjectAllocator.h"
+#include <cstdio>
+
+/*!
+  Returns the number of checks that failed so far
+*/
+inline int& Failures()
+{
+  static int failures = 0;
+
+  return failures;
+}
+
+/*!
+  Prints a check that failed and counts it
+*/
+inline void Fail(const char* name, const char* what)
+{
+  std::printf("FAIL %s: %s\n", name, what);
+  Failures()++;
+}
+
+/*!
+  A validation callback for pools that aren't expected to be corrupted (the count returned is checked)
+*/
+inline void NoCorruption(const void*, size_t)
+{
+}
+
+/*!
+  Prints that every check passed (if they did) and returns the exit code of the test program
+*/
+inline int Finish(const char* checks)
+{
+  if(Failures() == 0)
+    std::printf("all %s checks passed\n", checks);
+
+  return Failures() == 0 ? 0 : 1;
+}
+
+/*!
+  Returns a debug configuration with pad bytes and basic headers
+*/
+inline OAConfig DebugConfig(unsigned objectsPerPage, unsigned padBytes, bool lazy = false,
+                            OAConfig::REUSE_TYPE reuse = OAConfig::rtLIFO, int numaNode = -1)
+{
+  return OAConfig(false, objectsPerPage, 0, true, padBytes, OAConfig::HeaderBlockInfo(OAConfig::hbBasic), 0,
+                  OAConfig::gtFixed, DEFAULT_MAX_GROWTH_PAGES, false, lazy, reuse, numaNode);
+}
+
+#endif
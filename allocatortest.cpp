@@ -0,0 +1,1492 @@
+/**
+ * @file allocatortest.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Checks the behavior of the Object Allocator's page and block management that the driver's outputs
+ *        don't cover. Prints one line for each check that fails and returns 1 if any did.
+ *
+ *        Lazy carving: the blocks of a new page aren't touched until they're carved, they're carved from the
+ *        lowest up and before any freed block is reused (with LIFO reuse).
+ *
+ *        Reuse policies: address ordered reuse hands out the free blocks from the lowest address up, most
+ *        full page reuse hands out the lowest free block of the page with the fewest free blocks. Objects
+ *        smaller than a pointer are rejected with LIFO reuse and packed at their own size with the others.
+ *
+ *        ValidateStep: while blocks are allocated, freed and corrupted and pages are added and freed between
+ *        the steps, each sweep takes no more steps than ValidateStepsPerSweep promised when it started, and
+ *        every corrupted block is reported within 2 sweeps.
+ *
+ *        Freeing with address ordered or most full page reuse never allocates (operator new is counted).
+ *
+ *        Reset: the requested number of pages (the newest) is kept and handed out again before any page is
+ *        added, and a Reset that runs out of memory (operator new fails on demand) changes nothing.
+ *
+ *        TryAllocate: a pool at its max pages returns nullptr without throwing (and changes nothing) until
+ *        a block is freed, or queued with FreeRemote. With external header blocks, every allocation that
+ *        runs out of memory (operator new fails at each call in turn) returns nullptr and leaves the pool
+ *        whole, and the next one works.
+ *
+ *        Compact: the blocks are moved (with their contents) and reported to the relocation callback, the
+ *        pages are packed until at most one is partly in use and each call only frees the pages it emptied
+ *        (never a page that was already empty), including when the pool changes between calls. A validation
+ *        sweep in progress keeps its promise across Compact.
+ *
+ *        Growth: the pages come in chunks of 1 page with fixed growth, doubling with doubling growth and
+ *        doubling up to MaxGrowthPages with capped growth, never past the max pages. A chunk mapped on
+ *        system pages (a NUMA node) or huge pages is filled with as many pages as fit, still never past the
+ *        max pages. Huge pages work whether the system has some set aside or not (MAP_HUGETLB fails and
+ *        the chunk falls back to normal pages).
+ *
+ *        Guard pages: each block ends (after its right pad bytes and the bytes that keep the next object
+ *        aligned) at an inaccessible system page, the blocks are where the first block offset and
+ *        PoolBlockAlignment say they are, and the guard pages stay inaccessible (and the blocks accessible)
+ *        across Allocate, Free, FreeEmptyPages and Reset.
+ *
+ *        Usage: allocatortest.exe
+ * @date 10-15-2026
+ */
+
+#include "ObjectAllocator.h"
+#include "PoolAllocators.h"
+#include "PRNG.h"
+#include "TestChecks.h"
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+// The pages bound to a NUMA node are mapped, so they start out as zeros
+#define TEST_MAPPED_PAGES
+#include <unistd.h>
+#endif
+
+namespace
+{
+  unsigned long NewCalls = 0; //!< calls to operator new so far
+  long NewFailsIn = -1;       //!< calls to operator new left before the one that fails (-1 for none)
+  std::size_t LargestNew = 0; //!< the most bytes asked of operator new at once since it was last cleared
+}
+
+/*!
+  Counts the allocations and fails them on demand, so the checks can tell when the allocator allocates
+*/
+void* operator new(std::size_t size)
+{
+  NewCalls++;
+  if(size > LargestNew)
+    LargestNew = size;
+
+  // Only the one call fails (the exception thrown for it can still allocate its message)
+  if(NewFailsIn == 0)
+  {
+    NewFailsIn = -1;
+    throw std::bad_alloc();
+  }
+  if(NewFailsIn > 0)
+    NewFailsIn--;
+
+  void* memory = std::malloc(size > 0 ? size : 1);
+  if(memory == nullptr)
+    throw std::bad_alloc();
+
+  return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
+
+namespace
+{
+  const size_t OBJECT_SIZE = 48;  //!< size of the objects of every pool
+  const unsigned PER_PAGE = 8;    //!< objects on each page of every pool
+  const unsigned PAD_BYTES = 4;   //!< pad bytes of the debug pools
+
+  void NoDump(const void*, size_t)
+  {
+  }
+
+  std::vector<const void*> Reported; //!< the blocks reported corrupted since the list was last cleared
+
+  void ReportCorruption(const void* block, size_t)
+  {
+    Reported.push_back(block);
+  }
+
+  std::vector<const void*> Dumped; //!< the blocks dumped since the list was last cleared
+
+  void CollectBlock(const void* block, size_t)
+  {
+    Dumped.push_back(block);
+  }
+
+  std::vector<char*> Handles; //!< where each object compacted is (the object holds its index)
+  unsigned Moves = 0;         //!< blocks reported moved
+  bool BadMove = false;       //!< whether a move didn't match the handles
+
+  void Relocate(void* from, void* to, size_t size)
+  {
+    unsigned id;
+    memcpy(&id, to, sizeof(id));
+
+    if(size != OBJECT_SIZE || id >= Handles.size() || Handles[id] != from)
+      BadMove = true;
+    else
+      Handles[id] = static_cast<char*>(to);
+
+    Moves++;
+  }
+
+  /*!
+    Returns the distance from the start of one block to the next
+  */
+  size_t BlockStride(const ObjectAllocator& oa)
+  {
+    OAConfig config = oa.GetConfig();
+    size_t header = config.SideTableHeaders_ ? 0 : config.HBlockInfo_.size_;
+
+    return oa.GetStats().ObjectSize_ + config.PadBytes_ * 2 + header + config.InterAlignSize_;
+  }
+
+  /*!
+    Returns the first block of a page
+  */
+  const char* FirstBlock(const ObjectAllocator& oa, const void* page)
+  {
+    OAConfig config = oa.GetConfig();
+    size_t header = config.SideTableHeaders_ ? 0 : config.HBlockInfo_.size_;
+
+    return static_cast<const char*>(page) + sizeof(void*) + config.LeftAlignSize_ + header + config.PadBytes_;
+  }
+
+  /*!
+    Returns the pages of the page list (the newest first)
+  */
+  std::vector<const char*> Pages(const ObjectAllocator& oa)
+  {
+    std::vector<const char*> pages;
+    for(const GenericObject* page = static_cast<const GenericObject*>(oa.GetPageList()); page != nullptr; page = page->Next)
+      pages.push_back(reinterpret_cast<const char*>(page));
+
+    return pages;
+  }
+
+  /*!
+    Returns the given block of a page
+  */
+  char* BlockOf(const ObjectAllocator& oa, const char* page, unsigned index)
+  {
+    return const_cast<char*>(FirstBlock(oa, page) + index * BlockStride(oa));
+  }
+
+  /*!
+    Returns the index of a block within its page
+  */
+  unsigned BlockIndexOf(const ObjectAllocator& oa, const char* page, const char* block)
+  {
+    return static_cast<unsigned>((block - FirstBlock(oa, page)) / static_cast<std::ptrdiff_t>(BlockStride(oa)));
+  }
+
+  /*!
+    Allocates every block of the given number of pages
+  */
+  std::vector<char*> Fill(ObjectAllocator& oa, unsigned pages)
+  {
+    std::vector<char*> blocks;
+    for(unsigned i = 0; i < pages * PER_PAGE; ++i)
+      blocks.push_back(static_cast<char*>(oa.Allocate()));
+
+    return blocks;
+  }
+
+  /*!
+    Checks if every byte of a block, its header block and its pad bytes is 0 (it was never written)
+  */
+  bool IsUntouched(const ObjectAllocator& oa, const char* block)
+  {
+    OAConfig config = oa.GetConfig();
+    const char* start = block - config.PadBytes_ - config.HBlockInfo_.size_;
+    size_t size = config.HBlockInfo_.size_ + config.PadBytes_ * 2 + oa.GetStats().ObjectSize_;
+
+    for(size_t i = 0; i < size; ++i)
+    {
+      if(start[i] != 0)
+        return false;
+    }
+
+    return true;
+  }
+
+  /*!
+    Checks that the blocks of a page from the given one on haven't been touched
+  */
+  void CheckUntouched(const char* name, const ObjectAllocator& oa, const char* page, unsigned from)
+  {
+#ifdef TEST_MAPPED_PAGES
+    for(unsigned i = from; i < PER_PAGE; ++i)
+    {
+      if(!IsUntouched(oa, FirstBlock(oa, page) + i * BlockStride(oa)))
+      {
+        Fail(name, "a block was touched before it was carved");
+        return;
+      }
+    }
+#else
+    (void)name;
+    (void)oa;
+    (void)page;
+    (void)from;
+#endif
+  }
+
+  /*!
+    Carves a lazy LIFO page block by block and checks the order and that the rest isn't touched
+  */
+  void LazyCarving()
+  {
+    const char* name = "lazy carving";
+
+#ifdef TEST_MAPPED_PAGES
+    ObjectAllocator oa(OBJECT_SIZE, DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtLIFO, 0));
+#else
+    ObjectAllocator oa(OBJECT_SIZE, DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtLIFO));
+#endif
+
+    const char* page = static_cast<const char*>(oa.GetPageList());
+    const char* first = FirstBlock(oa, page);
+    size_t stride = BlockStride(oa);
+
+    if(oa.GetFreeList() != nullptr || oa.GetStats().FreeObjects_ != PER_PAGE)
+      Fail(name, "a new page's blocks were put on the free list");
+    CheckUntouched(name, oa, page, 0);
+
+    // A freed block isn't reused before the uncarved blocks
+    std::vector<char*> blocks;
+    blocks.push_back(static_cast<char*>(oa.Allocate()));
+    blocks.push_back(static_cast<char*>(oa.Allocate()));
+    oa.Free(blocks[0]);
+    blocks[0] = static_cast<char*>(oa.Allocate());
+    if(blocks[0] != first + 2 * stride)
+      Fail(name, "a freed block was reused before the uncarved blocks");
+
+    // The blocks are carved from the lowest up, and the ones after them aren't touched
+    for(unsigned i = 3; i < PER_PAGE; ++i)
+    {
+      CheckUntouched(name, oa, page, i);
+
+      blocks.push_back(static_cast<char*>(oa.Allocate()));
+      if(blocks.back() != first + i * stride)
+        Fail(name, "the blocks weren't carved from the lowest up");
+      if(static_cast<unsigned char>(blocks.back()[-1]) != ObjectAllocator::PAD_PATTERN)
+        Fail(name, "a carved block wasn't set up");
+
+      // The uncarved blocks are skipped when validating and dumping
+      if(oa.ValidatePages(NoCorruption) != 0)
+        Fail(name, "the pages are corrupted");
+      if(oa.DumpMemoryInUse(NoDump) != i)
+        Fail(name, "the blocks in use weren't all dumped");
+    }
+
+    // Once the page is carved, the freed block is reused
+    blocks.push_back(static_cast<char*>(oa.Allocate()));
+    if(blocks.back() != first || oa.GetStats().PagesInUse_ != 1)
+      Fail(name, "the freed block wasn't reused once the page was carved");
+
+    // The next page is carved the same way
+    blocks.push_back(static_cast<char*>(oa.Allocate()));
+    const char* second = static_cast<const char*>(oa.GetPageList());
+    if(oa.GetStats().PagesInUse_ != 2 || blocks.back() != FirstBlock(oa, second))
+      Fail(name, "the second page wasn't carved from its first block");
+    CheckUntouched(name, oa, second, 1);
+
+    for(char* block : blocks)
+      oa.Free(block);
+
+    if(oa.ValidatePages(NoCorruption) != 0 || oa.GetStats().ObjectsInUse_ != 0)
+      Fail(name, "the blocks didn't all go back");
+  }
+
+  /*!
+    Carves a lazy address ordered page and checks the lowest free block is always next
+  */
+  void LazyAddressOrdered()
+  {
+    const char* name = "lazy address ordered";
+
+    ObjectAllocator oa(OBJECT_SIZE, DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtAddressOrdered));
+
+    const char* first = FirstBlock(oa, oa.GetPageList());
+    size_t stride = BlockStride(oa);
+
+    char* a = static_cast<char*>(oa.Allocate());
+    char* b = static_cast<char*>(oa.Allocate());
+    char* c = static_cast<char*>(oa.Allocate());
+    if(a != first || b != first + stride || c != first + 2 * stride)
+      Fail(name, "the blocks weren't carved from the lowest up");
+
+    // The lowest free block comes before the uncarved ones
+    oa.Free(b);
+    if(oa.Allocate() != b)
+      Fail(name, "the lowest free block wasn't reused first");
+    if(oa.Allocate() != first + 3 * stride)
+      Fail(name, "the next uncarved block wasn't carved");
+
+    if(oa.ValidatePages(NoCorruption) != 0 || oa.DumpMemoryInUse(NoDump) != 4)
+      Fail(name, "the pages don't match the blocks in use");
+  }
+
+  /*!
+    Frees blocks all over the pages and checks they're handed out again from the lowest address up
+  */
+  void AddressOrdered()
+  {
+    const char* name = "address ordered";
+
+    ObjectAllocator oa(OBJECT_SIZE, DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtAddressOrdered));
+    std::vector<char*> blocks = Fill(oa, 4);
+
+    // Free every block whose number is a multiple of 3 or 5 (in the order they were allocated)
+    std::vector<char*> freed;
+    for(size_t i = 0; i < blocks.size(); ++i)
+    {
+      if(i % 3 == 0 || i % 5 == 0)
+      {
+        oa.Free(blocks[i]);
+        freed.push_back(blocks[i]);
+      }
+    }
+
+    std::sort(freed.begin(), freed.end(), std::less<char*>());
+    for(char* expected : freed)
+    {
+      if(oa.Allocate() != expected)
+      {
+        Fail(name, "the free blocks weren't handed out from the lowest address up");
+        break;
+      }
+    }
+
+    if(oa.GetStats().PagesInUse_ != 4 || oa.GetStats().FreeObjects_ != 0)
+      Fail(name, "a page was added while there were free blocks");
+    if(oa.ValidatePages(NoCorruption) != 0)
+      Fail(name, "the pages are corrupted");
+  }
+
+  /*!
+    Leaves pages with different numbers of free blocks and checks the fullest page is filled first
+  */
+  void MostFullPage()
+  {
+    const char* name = "most full page";
+
+    ObjectAllocator oa(OBJECT_SIZE, DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtMostFullPage));
+    Fill(oa, 4);
+
+    // Free 3 blocks of the first page, 1 of the second, 2 of the third and none of the fourth (the
+    // highest blocks first, so the order they're freed in doesn't decide)
+    std::vector<const char*> pages = Pages(oa);
+    const unsigned counts[] = { 3, 1, 2, 0 };
+    for(unsigned p = 0; p < 4; ++p)
+    {
+      for(unsigned i = 0; i < counts[p]; ++i)
+        oa.Free(BlockOf(oa, pages[p], PER_PAGE - 1 - i * 2));
+    }
+
+    // The page with 1 free block, then 2, then 3, each from its lowest free block up
+    const unsigned order[] = { 1, 2, 0 };
+    for(unsigned p : order)
+    {
+      for(unsigned i = counts[p]; i > 0; --i)
+      {
+        if(oa.Allocate() != BlockOf(oa, pages[p], PER_PAGE - 1 - (i - 1) * 2))
+        {
+          Fail(name, "the lowest free block of the fullest page wasn't picked");
+          return;
+        }
+      }
+    }
+
+    // Pages with as many free blocks are picked by their address
+    const char* low = std::min(pages[0], pages[3], std::less<const char*>());
+    const char* high = (low == pages[0]) ? pages[3] : pages[0];
+    oa.Free(BlockOf(oa, high, 0));
+    oa.Free(BlockOf(oa, low, 5));
+    if(oa.Allocate() != BlockOf(oa, low, 5))
+      Fail(name, "the lower of two pages with as many free blocks wasn't picked");
+    oa.Free(BlockOf(oa, low, 2));
+    oa.Free(BlockOf(oa, low, 6));
+    if(oa.Allocate() != BlockOf(oa, high, 0))
+      Fail(name, "the page with fewer free blocks wasn't picked");
+
+    if(oa.ValidatePages(NoCorruption) != 0)
+      Fail(name, "the pages are corrupted");
+  }
+
+  /*!
+    Checks that objects smaller than a pointer can't use LIFO reuse and are packed with the other policies
+  */
+  void SmallObjects()
+  {
+    const char* name = "small objects";
+    const size_t size = sizeof(void*) / 2;
+
+    try
+    {
+      ObjectAllocator oa(size, OAConfig(false, PER_PAGE, 0));
+      Fail(name, "LIFO reuse was accepted for objects smaller than a pointer");
+    }
+    catch(const OAException& e)
+    {
+      if(e.code() != OAException::E_BAD_CONFIG)
+        Fail(name, "LIFO reuse was rejected with the wrong error");
+    }
+
+    // The CPP manager has no free list
+    ObjectAllocator cpp(size, OAConfig(true, PER_PAGE, 0));
+    cpp.Free(cpp.Allocate());
+
+    const OAConfig::REUSE_TYPE policies[] = { OAConfig::rtAddressOrdered, OAConfig::rtMostFullPage };
+    for(OAConfig::REUSE_TYPE reuse : policies)
+    {
+      ObjectAllocator oa(size, OAConfig(false, PER_PAGE, 0, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtFixed,
+                                        DEFAULT_MAX_GROWTH_PAGES, false, false, reuse));
+      if(oa.GetConfig().Reuse_ != reuse)
+        Fail(name, "the reuse policy was changed");
+
+      // The blocks of the first page are handed out next to each other, and a freed block comes back
+      std::vector<char*> blocks = Fill(oa, 2);
+      for(unsigned i = 1; i < PER_PAGE; ++i)
+      {
+        if(blocks[i] != blocks[i - 1] + size)
+        {
+          Fail(name, "the objects aren't packed at their own size");
+          break;
+        }
+      }
+
+      oa.Free(blocks[3]);
+      if(oa.Allocate() != blocks[3])
+        Fail(name, "a freed block wasn't handed out again");
+
+      for(char* block : blocks)
+        oa.Free(block);
+      if(oa.GetStats().ObjectsInUse_ != 0 || oa.GetStats().FreeObjects_ != 2 * PER_PAGE)
+        Fail(name, "the blocks didn't all go back");
+    }
+  }
+
+  /*!
+    A block whose pad bytes were overwritten
+  */
+  struct CorruptedBlock
+  {
+    char* block_;      //!< the block
+    unsigned sweeps_;  //!< the sweeps finished when it was corrupted
+    bool reported_;    //!< whether a step reported it since
+  };
+
+  /*!
+    Takes validation steps while the pool changes between them and checks every sweep keeps its promise
+  */
+  void ValidateSteps()
+  {
+    const char* name = "validate step";
+    const unsigned MAX_BLOCKS = 5;
+
+    ObjectAllocator oa(OBJECT_SIZE, DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtLIFO));
+    std::vector<char*> live = Fill(oa, 6);
+    std::vector<CorruptedBlock> corrupted;
+
+    Digipen::Utils::srand(7, 11);
+
+    unsigned sweeps = oa.GetValidateSweeps();
+    unsigned limit = oa.ValidateStepsPerSweep(MAX_BLOCKS);
+    unsigned steps = 0;
+
+    for(unsigned iteration = 0; iteration < 2000 && Failures() == 0; ++iteration)
+    {
+      // A new sweep starts with this step (a step or freeing the last pages finished the last one)
+      if(oa.GetValidateSweeps() != sweeps)
+      {
+        sweeps = oa.GetValidateSweeps();
+        limit = oa.ValidateStepsPerSweep(MAX_BLOCKS);
+        steps = 0;
+      }
+
+      Reported.clear();
+      oa.ValidateStep(ReportCorruption, MAX_BLOCKS);
+      steps++;
+
+      for(const void* block : Reported)
+      {
+        std::vector<CorruptedBlock>::iterator c = std::find_if(corrupted.begin(), corrupted.end(), 
+                                                               [block](const CorruptedBlock& c) { return c.block_ == block; });
+        if(c != corrupted.end())
+          c->reported_ = true;
+        else
+          Fail(name, "a block that isn't corrupted was reported");
+      }
+
+      if(oa.GetValidateSweeps() == sweeps && steps >= limit)
+        Fail(name, "a sweep took more steps than promised");
+
+      for(const CorruptedBlock& c : corrupted)
+      {
+        if(!c.reported_ && oa.GetValidateSweeps() >= c.sweeps_ + 2)
+          Fail(name, "a corrupted block wasn't reported within 2 sweeps");
+      }
+
+      // Change the pool before the next step
+      switch(Digipen::Utils::Random(0, 9))
+      {
+        case 0:
+        case 1:
+        case 2:
+        {
+          // Allocate a few blocks (adding pages in front of the page list once the free ones run out)
+          int count = Digipen::Utils::Random(1, static_cast<int>(PER_PAGE) * 2);
+          for(int i = 0; i < count; ++i)
+            live.push_back(static_cast<char*>(oa.Allocate()));
+          break;
+        }
+        case 3:
+        case 4:
+        case 5:
+        {
+          // Free a few blocks that aren't corrupted
+          int count = Digipen::Utils::Random(1, static_cast<int>(PER_PAGE) * 2);
+          for(int i = 0; i < count && !live.empty(); ++i)
+          {
+            size_t index = static_cast<size_t>(Digipen::Utils::Random(0, static_cast<int>(live.size()) - 1));
+            oa.Free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+          }
+          break;
+        }
+        case 6:
+          oa.FreeEmptyPages();
+          break;
+        case 7:
+        {
+          // Corrupt the left pad bytes of a block in use (the newest ones are often on the newest page)
+          if(live.empty() || corrupted.size() >= 20)
+            break;
+
+          size_t index = (Digipen::Utils::Random(0, 1) == 0) ? live.size() - 1 
+                                                              : static_cast<size_t>(Digipen::Utils::Random(0, static_cast<int>(live.size()) - 1));
+          CorruptedBlock c = { live[index], oa.GetValidateSweeps(), false };
+          c.block_[-1] = 0;
+          corrupted.push_back(c);
+
+          // It stays in use
+          live[index] = live.back();
+          live.pop_back();
+          break;
+        }
+        default:
+          break;
+      }
+    }
+
+    if(oa.GetValidateSweeps() < 10)
+      Fail(name, "too few sweeps were finished to check anything");
+
+    // Fix the corrupted blocks and free everything
+    for(const CorruptedBlock& c : corrupted)
+    {
+      c.block_[-1] = static_cast<char>(ObjectAllocator::PAD_PATTERN);
+      oa.Free(c.block_);
+    }
+    for(char* block : live)
+      oa.Free(block);
+
+    if(oa.ValidatePages(NoCorruption) != 0 || oa.GetStats().ObjectsInUse_ != 0)
+      Fail(name, "the blocks didn't all go back");
+  }
+
+  /*!
+    Fills many pages, then frees blocks so each page gets its first free block, and checks nothing is allocated
+  */
+  void FreeWithoutAllocating(const char* name, const OAConfig& config)
+  {
+    const unsigned PAGES = 40;
+
+    ObjectAllocator oa(OBJECT_SIZE, config);
+    std::vector<char*> blocks = Fill(oa, PAGES);
+
+    unsigned long calls = NewCalls;
+
+    // The first free block of each page adds the page to the partial pages, with Free, TryFree and FreeN
+    for(unsigned p = 0; p < PAGES; ++p)
+    {
+      char* block = blocks[p * PER_PAGE];
+
+      if(p % 3 == 0)
+        oa.Free(block);
+      else if(p % 3 == 1)
+        oa.TryFree(block);
+      else
+        oa.FreeN(reinterpret_cast<void* const*>(&block), 1);
+    }
+
+    // Then the rest of the blocks, so the pages move around the partial pages and empty out
+    for(unsigned p = 0; p < PAGES; ++p)
+    {
+      oa.FreeN(reinterpret_cast<void* const*>(&blocks[p * PER_PAGE + 1]), PER_PAGE / 2 - 1);
+      for(unsigned i = PER_PAGE / 2; i < PER_PAGE; ++i)
+        oa.Free(blocks[p * PER_PAGE + i]);
+    }
+
+    if(NewCalls != calls)
+      Fail(name, "freeing allocated memory");
+    if(oa.GetStats().ObjectsInUse_ != 0 || oa.GetStats().FreeObjects_ != PAGES * PER_PAGE)
+      Fail(name, "the blocks didn't all go back");
+
+    // The blocks are all handed out again without adding pages
+    Fill(oa, PAGES);
+    if(oa.GetStats().PagesInUse_ != PAGES)
+      Fail(name, "pages were added while there were free blocks");
+  }
+
+  /*!
+    Checks if two sets of statistics are the same
+  */
+  bool SameStats(const OAStats& left, const OAStats& right)
+  {
+    return left.ObjectSize_ == right.ObjectSize_ && left.PageSize_ == right.PageSize_ && 
+           left.FreeObjects_ == right.FreeObjects_ && left.ObjectsInUse_ == right.ObjectsInUse_ && 
+           left.PagesInUse_ == right.PagesInUse_ && left.MostObjects_ == right.MostObjects_ && 
+           left.Allocations_ == right.Allocations_ && left.Deallocations_ == right.Deallocations_;
+  }
+
+  /*!
+    Checks if a block is on one of the given pages
+  */
+  bool IsOnPages(const ObjectAllocator& oa, const std::vector<const char*>& pages, const char* block)
+  {
+    for(const char* page : pages)
+    {
+      if(block >= page && block < page + oa.GetStats().PageSize_)
+        return true;
+    }
+
+    return false;
+  }
+
+  /*!
+    Resets a pool with blocks in use and checks the newest pages are kept and handed out again first
+  */
+  void ResetKeepsPages(const char* name, const OAConfig& config)
+  {
+    ObjectAllocator oa(OBJECT_SIZE, config);
+    std::vector<char*> blocks = Fill(oa, 5);
+    for(size_t i = 0; i < blocks.size(); i += 3)
+      oa.Free(blocks[i]);
+
+    OAStats before = oa.GetStats();
+    std::vector<const char*> pages = Pages(oa);
+    pages.resize(3);
+
+    oa.Reset(3);
+
+    OAStats after = oa.GetStats();
+    if(after.PagesInUse_ != 3 || Pages(oa) != pages)
+      Fail(name, "the newest pages weren't the ones kept");
+    if(after.ObjectsInUse_ != 0 || after.FreeObjects_ != 3 * PER_PAGE || 
+       after.Deallocations_ != before.Deallocations_ + before.ObjectsInUse_)
+      Fail(name, "the stats weren't reset");
+    if(oa.ValidatePages(NoCorruption) != 0 || oa.DumpMemoryInUse(NoDump) != 0)
+      Fail(name, "the kept pages aren't empty");
+
+    // Every block of the kept pages is handed out before a page is added
+    std::vector<char*> again = Fill(oa, 3);
+    for(char* block : again)
+    {
+      if(!IsOnPages(oa, pages, block))
+      {
+        Fail(name, "a block didn't come from the kept pages");
+        break;
+      }
+    }
+    std::sort(again.begin(), again.end(), std::less<char*>());
+    if(std::unique(again.begin(), again.end()) != again.end())
+      Fail(name, "a block was handed out twice");
+    if(oa.GetStats().PagesInUse_ != 3)
+      Fail(name, "a page was added while the kept pages had free blocks");
+
+    oa.Allocate();
+    if(oa.GetStats().PagesInUse_ != 4)
+      Fail(name, "a page wasn't added once the kept pages were full");
+    if(oa.ValidatePages(NoCorruption) != 0)
+      Fail(name, "the pages are corrupted");
+
+    // Keeping more pages than there are keeps them all, keeping none frees them all
+    oa.Reset(10);
+    if(oa.GetStats().PagesInUse_ != 4 || oa.GetStats().FreeObjects_ != 4 * PER_PAGE)
+      Fail(name, "the pages weren't all kept");
+    oa.Reset(0);
+    if(oa.GetStats().PagesInUse_ != 0 || oa.GetPageList() != nullptr || oa.GetStats().FreeObjects_ != 0)
+      Fail(name, "the pages weren't all freed");
+    oa.Allocate();
+    if(oa.GetStats().PagesInUse_ != 1 || oa.GetStats().ObjectsInUse_ != 1)
+      Fail(name, "a page wasn't added after every page was freed");
+  }
+
+  /*!
+    Makes operator new fail during Reset and checks the pool didn't change (or that Reset didn't need memory)
+  */
+  void ResetOutOfMemory(const char* name, const OAConfig& config, long failsIn, bool needsMemory)
+  {
+    ObjectAllocator oa(OBJECT_SIZE, config);
+    std::vector<char*> blocks = Fill(oa, 4);
+    std::vector<char*> live;
+    for(size_t i = 0; i < blocks.size(); ++i)
+    {
+      if(i % 4 == 1)
+        oa.Free(blocks[i]);
+      else
+        live.push_back(blocks[i]);
+    }
+
+    OAStats before = oa.GetStats();
+    const void* freeList = oa.GetFreeList();
+    std::vector<const char*> pages = Pages(oa);
+
+    bool failed = false;
+    NewFailsIn = failsIn;
+    try
+    {
+      oa.Reset(4);
+    }
+    catch(const OAException& e)
+    {
+      failed = true;
+
+      if(e.code() != OAException::E_NO_MEMORY)
+        Fail(name, "Reset threw the wrong error");
+    }
+    NewFailsIn = -1;
+
+    if(!needsMemory)
+    {
+      if(failed)
+        Fail(name, "Reset needed memory");
+      return;
+    }
+
+    if(!failed)
+    {
+      Fail(name, "Reset didn't run out of memory");
+      return;
+    }
+
+    if(!SameStats(oa.GetStats(), before))
+      Fail(name, "the stats changed");
+    if(oa.GetFreeList() != freeList || Pages(oa) != pages)
+      Fail(name, "the free list or page list changed");
+    if(oa.DumpMemoryInUse(NoDump) != live.size() || oa.ValidatePages(NoCorruption) != 0)
+      Fail(name, "the blocks in use changed");
+
+    // The blocks in use can still be freed, and the free blocks allocated
+    for(char* block : live)
+      oa.Free(block);
+    Fill(oa, 4);
+    if(oa.GetStats().PagesInUse_ != 4 || oa.GetStats().ObjectsInUse_ != 4 * PER_PAGE)
+      Fail(name, "the pool doesn't work after the failed Reset");
+  }
+
+  /*!
+    Fills a pool to its max pages and checks TryAllocate returns nullptr until a block is freed
+  */
+  void TryAllocateMaxPages(const char* name, const OAConfig& config)
+  {
+    ObjectAllocator oa(OBJECT_SIZE, config);
+    std::vector<char*> blocks = Fill(oa, config.MaxPages_);
+
+    OAStats before = oa.GetStats();
+    for(unsigned i = 0; i < 3; ++i)
+    {
+      if(oa.TryAllocate("full") != nullptr)
+        Fail(name, "TryAllocate went past the max pages");
+    }
+    if(!SameStats(oa.GetStats(), before) || oa.ValidatePages(NoCorruption) != 0)
+      Fail(name, "a failed TryAllocate changed the pool");
+
+    // A freed block, or one queued by another thread, is handed out again
+    oa.Free(blocks[3]);
+    if(oa.TryAllocate("full") != blocks[3])
+      Fail(name, "TryAllocate didn't hand out the freed block");
+    oa.FreeRemote(blocks[5]);
+    if(oa.TryAllocate("full") != blocks[5])
+      Fail(name, "TryAllocate didn't hand out the block queued by another thread");
+    if(oa.TryAllocate("full") != nullptr)
+      Fail(name, "TryAllocate went past the max pages");
+
+    for(char* block : blocks)
+      oa.Free(block);
+  }
+
+  /*!
+    Runs out of memory at each call to operator new in turn while TryAllocate adds a page and an external 
+    header block with a new label, and checks the pool is whole afterwards
+  */
+  void TryAllocateOutOfMemory(const char* name, const OAConfig& config)
+  {
+    for(long failsIn = 0; failsIn < 64; ++failsIn)
+    {
+      ObjectAllocator oa(OBJECT_SIZE, config);
+      std::vector<char*> blocks = Fill(oa, 1);
+
+      char label[32];
+      std::snprintf(label, sizeof(label), "new label %ld", failsIn);
+
+      NewFailsIn = failsIn;
+      char* block = static_cast<char*>(oa.TryAllocate(label));
+      bool failed = NewFailsIn == -1;
+      NewFailsIn = -1;
+
+      // Every call after the last one succeeds
+      if(!failed)
+      {
+        if(block == nullptr)
+          Fail(name, "TryAllocate returned nullptr with memory left");
+        for(char* freed : blocks)
+          oa.Free(freed);
+        return;
+      }
+
+      OAStats stats = oa.GetStats();
+      unsigned inUse = PER_PAGE + (block != nullptr ? 1 : 0);
+      if(stats.ObjectsInUse_ != inUse || stats.ObjectsInUse_ + stats.FreeObjects_ != stats.PagesInUse_ * PER_PAGE ||
+         oa.DumpMemoryInUse(NoDump) != inUse || oa.ValidatePages(NoCorruption) != 0)
+      {
+        Fail(name, "running out of memory left the pool broken");
+        return;
+      }
+
+      // The next allocation works, with the same label
+      if(block == nullptr)
+        block = static_cast<char*>(oa.TryAllocate(label));
+      if(block == nullptr)
+      {
+        Fail(name, "TryAllocate doesn't work after running out of memory");
+        return;
+      }
+
+      blocks.push_back(block);
+      for(char* freed : blocks)
+        oa.Free(freed);
+      if(oa.GetStats().ObjectsInUse_ != 0)
+        Fail(name, "the blocks weren't all freed");
+    }
+
+    Fail(name, "TryAllocate never stopped running out of memory");
+  }
+
+  /*!
+    Returns the number of blocks in use on each of the given pages
+  */
+  std::vector<unsigned> LiveCounts(const ObjectAllocator& oa, const std::vector<const char*>& pages)
+  {
+    Dumped.clear();
+    oa.DumpMemoryInUse(CollectBlock);
+
+    std::vector<unsigned> counts(pages.size(), 0);
+    for(const void* block : Dumped)
+    {
+      for(size_t p = 0; p < pages.size(); ++p)
+      {
+        if(static_cast<const char*>(block) >= pages[p] && static_cast<const char*>(block) < pages[p] + oa.GetStats().PageSize_)
+          counts[p]++;
+      }
+    }
+
+    return counts;
+  }
+
+  /*!
+    Takes an object for compacting (the object holds its index)
+  */
+  void NewHandle(ObjectAllocator& oa)
+  {
+    char* block = static_cast<char*>(oa.Allocate());
+    unsigned id = static_cast<unsigned>(Handles.size());
+
+    memset(block, static_cast<int>(id & 0x7F), OBJECT_SIZE);
+    memcpy(block, &id, sizeof(id));
+    Handles.push_back(block);
+  }
+
+  /*!
+    Calls Compact once and checks it moved what it said and only freed pages it emptied
+  */
+  unsigned CompactStep(const char* name, ObjectAllocator& oa, unsigned maxMoves)
+  {
+    std::vector<const char*> before = Pages(oa);
+    std::vector<unsigned> live = LiveCounts(oa, before);
+
+    Moves = 0;
+    unsigned moved = (maxMoves > 0) ? oa.Compact(Relocate, maxMoves) : oa.CompactFor(Relocate, 100000);
+
+    if(moved != Moves || (maxMoves > 0 && moved > maxMoves))
+      Fail(name, "Compact didn't report the blocks it moved");
+    if(BadMove)
+    {
+      Fail(name, "a block moved wasn't where the callback was told it was");
+      BadMove = false;
+    }
+
+    std::vector<const char*> after = Pages(oa);
+    if(after.size() != oa.GetStats().PagesInUse_)
+      Fail(name, "the pages in use don't match the page list");
+
+    for(size_t p = 0; p < before.size(); ++p)
+    {
+      bool kept = std::find(after.begin(), after.end(), before[p]) != after.end();
+
+      if(!kept && live[p] == 0)
+        Fail(name, "a page that was already empty was freed");
+      if(!kept && live[p] > moved)
+        Fail(name, "a page was freed with blocks still in use");
+    }
+
+    return moved;
+  }
+
+  /*!
+    Takes validation steps until the given sweep ends and checks it took no more steps than it promised when
+    it started (counting the steps it already took)
+  */
+  void FinishSweep(const char* name, ObjectAllocator& oa, unsigned maxBlocks, unsigned sweeps, unsigned limit, unsigned steps)
+  {
+    while(oa.GetValidateSweeps() == sweeps && steps <= limit)
+    {
+      oa.ValidateStep(NoCorruption, maxBlocks);
+      steps++;
+    }
+
+    if(steps > limit)
+      Fail(name, "a sweep took more steps than it promised");
+  }
+
+  /*!
+    Compacts once in the middle of a validation sweep, with the sweep on a page that stays after pages that
+    move, and checks the sweep and the next one keep their promises
+  */
+  unsigned SweepAcrossCompact(const char* name, ObjectAllocator& oa)
+  {
+    const unsigned maxBlocks = 3;
+
+    // The first 2 pages (partly in use, they're moved to the end) and 5 blocks of the third (empty, it stays)
+    unsigned limit = oa.ValidateStepsPerSweep(maxBlocks);
+    unsigned sweeps = oa.GetValidateSweeps();
+    for(unsigned i = 0; i < 7; ++i)
+      oa.ValidateStep(NoCorruption, maxBlocks);
+    if(oa.GetValidateSweeps() != sweeps)
+      Fail(name, "the sweep ended too soon");
+
+    unsigned moved = CompactStep(name, oa, 1);
+
+    FinishSweep(name, oa, maxBlocks, sweeps, limit, 7);
+    FinishSweep(name, oa, maxBlocks, oa.GetValidateSweeps(), oa.ValidateStepsPerSweep(maxBlocks), 0);
+
+    return moved;
+  }
+
+  /*!
+    Checks the objects compacted are where their handles say, with their contents, and the pages are packed
+  */
+  void CheckCompacted(const char* name, ObjectAllocator& oa, unsigned emptyPages)
+  {
+    for(size_t id = 0; id < Handles.size(); ++id)
+    {
+      if(Handles[id] == nullptr)
+        continue;
+
+      unsigned stored;
+      memcpy(&stored, Handles[id], sizeof(stored));
+      if(stored != id || static_cast<unsigned char>(Handles[id][OBJECT_SIZE - 1]) != (id & 0x7F))
+      {
+        Fail(name, "an object moved lost its contents");
+        break;
+      }
+    }
+
+    if(oa.ValidatePages(NoCorruption) != 0)
+      Fail(name, "the pages are corrupted");
+
+    std::vector<unsigned> live = LiveCounts(oa, Pages(oa));
+    unsigned partly = 0;
+    unsigned empty = 0;
+    for(unsigned count : live)
+    {
+      if(count == 0)
+        empty++;
+      else if(count < PER_PAGE)
+        partly++;
+    }
+
+    if(partly > 1)
+      Fail(name, "more than one page is partly in use");
+    if(empty != emptyPages)
+      Fail(name, "the empty pages weren't all kept");
+  }
+
+  /*!
+    Compacts pages with different numbers of blocks in use, a few moves at a time
+  */
+  void Compact(const char* name, const OAConfig& config)
+  {
+    ObjectAllocator oa(OBJECT_SIZE, config);
+
+    Handles.clear();
+    for(unsigned i = 0; i < 8 * PER_PAGE; ++i)
+      NewHandle(oa);
+
+    // Leave 5, 7, 0, 3, 8, 0, 2 and 1 blocks in use on the pages (2 empty, 1 full and 5 partly in use)
+    std::vector<const char*> pages = Pages(oa);
+    const unsigned keep[] = { 5, 7, 0, 3, 8, 0, 2, 1 };
+    for(size_t id = 0; id < Handles.size(); ++id)
+    {
+      for(unsigned p = 0; p < 8; ++p)
+      {
+        if(Handles[id] >= pages[p] && Handles[id] < pages[p] + oa.GetStats().PageSize_)
+        {
+          if(BlockIndexOf(oa, pages[p], Handles[id]) >= keep[p])
+          {
+            oa.Free(Handles[id]);
+            Handles[id] = nullptr;
+          }
+          break;
+        }
+      }
+    }
+
+    unsigned inUse = oa.GetStats().ObjectsInUse_;
+    if(inUse != 26)
+      Fail(name, "the blocks in use weren't set up");
+
+    // A few moves at a time (the plan is kept between the calls), the rest in one timed call
+    unsigned moved = SweepAcrossCompact(name, oa);
+    for(unsigned i = 1; i <= 4; ++i)
+      moved += CompactStep(name, oa, i);
+    moved += CompactStep(name, oa, 0);
+
+    if(moved == 0)
+      Fail(name, "no blocks were moved");
+    if(CompactStep(name, oa, 100) != 0)
+      Fail(name, "packed pages were compacted again");
+
+    // The 18 blocks of the partly used pages fit in 3 pages, the full page and the 2 empty pages stay
+    if(oa.GetStats().PagesInUse_ != 6 || oa.GetStats().ObjectsInUse_ != inUse)
+      Fail(name, "the pages weren't packed");
+    CheckCompacted(name, oa, 2);
+
+    // Change the pool between the calls (the plan is made again)
+    for(size_t id = 0; id < Handles.size(); id += 2)
+    {
+      if(Handles[id] != nullptr)
+      {
+        oa.Free(Handles[id]);
+        Handles[id] = nullptr;
+      }
+    }
+    for(unsigned i = 0; i < 10; ++i)
+    {
+      CompactStep(name, oa, 2);
+      if(i % 3 == 0)
+        NewHandle(oa);
+      if(i % 4 == 1)
+        oa.FreeEmptyPages();
+    }
+    while(CompactStep(name, oa, 3) != 0)
+      ;
+
+    oa.FreeEmptyPages();
+    CheckCompacted(name, oa, 0);
+
+    for(char* block : Handles)
+    {
+      if(block != nullptr)
+        oa.Free(block);
+    }
+    if(oa.GetStats().ObjectsInUse_ != 0)
+      Fail(name, "the blocks didn't all go back");
+  }
+
+  /*!
+    Returns the distance between the pages of a chunk for a configuration (from the second chunk of a 
+    pool with doubling growth, the first one with more than one page)
+  */
+  size_t PageStrideOf(const OAConfig& config)
+  {
+    OAConfig doubling = config;
+    doubling.Growth_ = OAConfig::gtDoubling;
+    doubling.MaxPages_ = 0;
+    doubling.HugePages_ = false;
+    doubling.NumaNode_ = -1;
+
+    ObjectAllocator oa(OBJECT_SIZE, doubling);
+    Fill(oa, 2);
+    const char* second = static_cast<const char*>(oa.GetPageList());
+    Fill(oa, 1);
+
+    return static_cast<size_t>(static_cast<const char*>(oa.GetPageList()) - second);
+  }
+
+  /*!
+    Adds pages one at a time and returns how many pages each chunk they came from has (a page that isn't 
+    a page stride past the one before it starts a new chunk)
+  */
+  std::vector<unsigned> ChunkRuns(ObjectAllocator& oa, unsigned pages, size_t stride)
+  {
+    std::vector<unsigned> runs;
+    const char* last = nullptr;
+
+    for(unsigned i = 0; i < pages; ++i)
+    {
+      Fill(oa, 1);
+      const char* page = static_cast<const char*>(oa.GetPageList());
+
+      if(last != nullptr && page == last + stride)
+        runs.back()++;
+      else
+        runs.push_back(1);
+
+      last = page;
+    }
+
+    return runs;
+  }
+
+  /*!
+    Checks that a pool at its max pages can't add another one
+  */
+  void CheckNoPages(const char* name, ObjectAllocator& oa)
+  {
+    try
+    {
+      oa.Allocate();
+      Fail(name, "a page was added past the max pages");
+    }
+    catch(const OAException& e)
+    {
+      if(e.code() != OAException::E_NO_PAGES)
+        Fail(name, "the wrong error was reported past the max pages");
+    }
+  }
+
+  /*!
+    Adds pages one at a time and checks the number of pages of each chunk (at least that many for a 
+    chunk mapped on system pages, which is filled with as many pages as fit)
+  */
+  void ChunkSizes(const char* name, const OAConfig& config, const std::vector<unsigned>& expected)
+  {
+    size_t stride = PageStrideOf(config);
+    LargestNew = 0;
+    ObjectAllocator oa(OBJECT_SIZE, config);
+
+    unsigned pages = 0;
+    for(unsigned run : expected)
+      pages += run;
+
+    std::vector<unsigned> runs = ChunkRuns(oa, pages, stride);
+    bool mapped = config.NumaNode_ >= 0;
+
+    if(!mapped && runs != expected)
+      Fail(name, "the chunks aren't the sizes the growth asks for");
+
+    // No chunk has room for pages it doesn't hand out (the chunk header is smaller than a page)
+    if(!mapped && LargestNew >= (*std::max_element(expected.begin(), expected.end()) + 1) * stride)
+      Fail(name, "a chunk has room for more pages than the growth and the max pages allow");
+    for(unsigned i = 0; mapped && i < runs.size() && i < expected.size(); ++i)
+    {
+      if(runs[i] < expected[i])
+      {
+        Fail(name, "a mapped chunk is smaller than the growth asks for");
+        break;
+      }
+    }
+
+    if(config.MaxPages_ == pages)
+      CheckNoPages(name, oa);
+  }
+
+  /*!
+    Checks that a chunk of huge pages is filled with as many pages as fit in a huge page, and that the 
+    max pages still limits it
+  */
+  void HugeChunks(const char* name, const OAConfig& config)
+  {
+    size_t stride = PageStrideOf(config);
+    unsigned fit = static_cast<unsigned>(HUGE_PAGE_SIZE / stride);
+
+    {
+      ObjectAllocator oa(OBJECT_SIZE, config);
+
+      // The chunk header takes some of the huge page, so one page less can fit
+      std::vector<unsigned> runs = ChunkRuns(oa, fit + 1, stride);
+      if(runs.size() != 2 || runs[0] + 1 < fit || runs[0] > fit)
+        Fail(name, "the huge page isn't filled with pages");
+    }
+
+    OAConfig limited = config;
+    limited.MaxPages_ = 5;
+    ObjectAllocator oa(OBJECT_SIZE, limited);
+
+    if(ChunkRuns(oa, 5, stride) != std::vector<unsigned>(1, 5))
+      Fail(name, "the huge page isn't filled up to the max pages");
+    CheckNoPages(name, oa);
+  }
+
+#ifdef TEST_MAPPED_PAGES
+  int ProbePipe[2] = { -1, -1 }; //!< the pipe the bytes checked by IsAccessible are copied through
+
+  /*!
+    Checks if a byte can be read (the system copies it into a pipe, which fails instead of faulting)
+  */
+  bool IsAccessible(const char* address)
+  {
+    if(write(ProbePipe[1], address, 1) != 1)
+      return false;
+
+    char byte;
+    return read(ProbePipe[0], &byte, 1) == 1;
+  }
+
+  /*!
+    Checks that each block of each page is accessible and ends at its own inaccessible guard page
+  */
+  void CheckGuards(const char* name, const ObjectAllocator& oa)
+  {
+    OAConfig config = oa.GetConfig();
+    size_t systemPage = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t alignment = (config.Alignment_ > 1) ? config.Alignment_ : 1;
+
+    for(const char* page : Pages(oa))
+    {
+      for(unsigned i = 0; i < PER_PAGE; ++i)
+      {
+        const char* block = BlockOf(oa, page, i);
+        std::uintptr_t end = reinterpret_cast<std::uintptr_t>(block) + OBJECT_SIZE + config.PadBytes_;
+        const char* guard = reinterpret_cast<const char*>((end + systemPage - 1) / systemPage * systemPage);
+
+        // Only the bytes that keep the next object aligned are between the right pad bytes and the guard page
+        if(static_cast<size_t>(reinterpret_cast<std::uintptr_t>(guard) - end) >= alignment)
+        {
+          Fail(name, "a block doesn't end at its guard page");
+          return;
+        }
+        if(!IsAccessible(block - config.PadBytes_) || !IsAccessible(guard - 1))
+        {
+          Fail(name, "a block isn't accessible");
+          return;
+        }
+        if(IsAccessible(guard) || IsAccessible(guard + systemPage - 1))
+        {
+          Fail(name, "a guard page is accessible");
+          return;
+        }
+      }
+    }
+  }
+
+  /*!
+    Checks that the blocks allocated are the blocks of the pages, on the alignment PoolBlockAlignment 
+    promises, and can be written to
+  */
+  void CheckBlocks(const char* name, const ObjectAllocator& oa, std::vector<char*> blocks)
+  {
+    std::vector<char*> expected;
+    for(const char* page : Pages(oa))
+    {
+      for(unsigned i = 0; i < PER_PAGE; ++i)
+        expected.push_back(BlockOf(oa, page, i));
+    }
+
+    std::sort(blocks.begin(), blocks.end());
+    std::sort(expected.begin(), expected.end());
+    if(blocks != expected)
+      Fail(name, "the blocks aren't at the first block offset and the block stride");
+
+    size_t alignment = PoolBlockAlignment(oa);
+    for(char* block : blocks)
+    {
+      if(reinterpret_cast<std::uintptr_t>(block) % alignment != 0 || 
+         (oa.GetConfig().Alignment_ > 1 && reinterpret_cast<std::uintptr_t>(block) % oa.GetConfig().Alignment_ != 0))
+      {
+        Fail(name, "a block isn't on the alignment");
+        break;
+      }
+
+      memset(block, 0x11, OBJECT_SIZE);
+    }
+  }
+
+  /*!
+    Allocates and frees blocks, frees empty pages and resets a pool with guard pages, checking the guard 
+    pages after each step
+  */
+  void GuardPages(const char* name, const OAConfig& config)
+  {
+    if(pipe(ProbePipe) != 0)
+    {
+      Fail(name, "the pipe can't be created");
+      return;
+    }
+
+    {
+      ObjectAllocator oa(OBJECT_SIZE, config);
+
+      if(!oa.GetConfig().GuardPages_)
+        Fail(name, "the pool has no guard pages");
+      else
+      {
+        std::vector<char*> blocks = Fill(oa, 2);
+        CheckBlocks(name, oa, blocks);
+        CheckGuards(name, oa);
+
+        // Every other block, then the rest of the newest page, which is freed
+        for(unsigned i = 0; i < blocks.size(); i += 2)
+          oa.Free(blocks[i]);
+        CheckGuards(name, oa);
+
+        const char* newest = Pages(oa)[0];
+        for(unsigned i = 1; i < blocks.size(); i += 2)
+        {
+          if(blocks[i] >= newest && blocks[i] < newest + oa.GetStats().PageSize_)
+            oa.Free(blocks[i]);
+        }
+        if(oa.FreeEmptyPages() != 1)
+          Fail(name, "the empty page wasn't freed");
+        CheckGuards(name, oa);
+
+        // A new page gets its guard pages too
+        Fill(oa, 1);
+        CheckGuards(name, oa);
+
+        // The page kept by Reset keeps its guard pages, and is handed out before a new page is added
+        oa.Reset(1);
+        CheckGuards(name, oa);
+        blocks = Fill(oa, 2);
+        CheckBlocks(name, oa, blocks);
+        CheckGuards(name, oa);
+
+        for(char* block : blocks)
+          oa.Free(block);
+        if(oa.ValidatePages(NoCorruption) != 0)
+          Fail(name, "the pages are corrupted");
+      }
+    }
+
+    close(ProbePipe[0]);
+    close(ProbePipe[1]);
+  }
+#endif
+}
+
+int main()
+{
+  try
+  {
+    LazyCarving();
+    LazyAddressOrdered();
+    AddressOrdered();
+    MostFullPage();
+    SmallObjects();
+    ValidateSteps();
+
+    FreeWithoutAllocating("address ordered free", OAConfig(false, PER_PAGE, 0, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtFixed,
+                                                           DEFAULT_MAX_GROWTH_PAGES, false, false, OAConfig::rtAddressOrdered));
+    FreeWithoutAllocating("most full page free", OAConfig(false, PER_PAGE, 0, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtDoubling,
+                                                          DEFAULT_MAX_GROWTH_PAGES, false, false, OAConfig::rtMostFullPage));
+    FreeWithoutAllocating("address ordered debug free", DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtAddressOrdered));
+    FreeWithoutAllocating("most full page debug free", DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtMostFullPage));
+    FreeWithoutAllocating("most full page external free", OAConfig(false, PER_PAGE, 0, true, PAD_BYTES,
+                                                                   OAConfig::HeaderBlockInfo(OAConfig::hbExternal), 0, OAConfig::gtFixed,
+                                                                   DEFAULT_MAX_GROWTH_PAGES, false, false, OAConfig::rtMostFullPage));
+
+    const OAConfig external(false, PER_PAGE, 0, true, PAD_BYTES, OAConfig::HeaderBlockInfo(OAConfig::hbExternal));
+    ResetKeepsPages("reset lifo", DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtLIFO));
+    ResetKeepsPages("reset lazy lifo", DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtLIFO));
+    ResetKeepsPages("reset address ordered", DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtAddressOrdered));
+    ResetKeepsPages("reset most full page", DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtMostFullPage));
+    ResetKeepsPages("reset external", external);
+
+    // With LIFO reuse the kept pages need room, an external header pool needs room of its own
+    ResetOutOfMemory("failed reset lifo", DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtLIFO), 0, true);
+    ResetOutOfMemory("failed reset lazy lifo", DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtLIFO), 0, true);
+    ResetOutOfMemory("failed reset external", external, 0, true);
+    ResetOutOfMemory("failed reset external header pool", external, 1, true);
+    ResetOutOfMemory("reset address ordered", DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtAddressOrdered), 0, false);
+    ResetOutOfMemory("reset most full page", DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtMostFullPage), 0, false);
+
+    TryAllocateMaxPages("try allocate lifo", OAConfig(false, PER_PAGE, 2));
+    TryAllocateMaxPages("try allocate debug", OAConfig(false, PER_PAGE, 2, true, PAD_BYTES, OAConfig::HeaderBlockInfo(OAConfig::hbBasic)));
+    TryAllocateMaxPages("try allocate address ordered", OAConfig(false, PER_PAGE, 2, false, 0, OAConfig::HeaderBlockInfo(), 0,
+                                                                 OAConfig::gtFixed, DEFAULT_MAX_GROWTH_PAGES, false, true,
+                                                                 OAConfig::rtAddressOrdered));
+    TryAllocateMaxPages("try allocate external", OAConfig(false, PER_PAGE, 2, true, PAD_BYTES, OAConfig::HeaderBlockInfo(OAConfig::hbExternal)));
+    TryAllocateOutOfMemory("try allocate external out of memory", external);
+    TryAllocateOutOfMemory("try allocate external lazy out of memory",
+                           OAConfig(false, PER_PAGE, 0, true, PAD_BYTES, OAConfig::HeaderBlockInfo(OAConfig::hbExternal), 0,
+                                    OAConfig::gtDoubling, DEFAULT_MAX_GROWTH_PAGES, false, true, OAConfig::rtMostFullPage));
+
+    Compact("compact lifo", DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtLIFO));
+    Compact("compact lazy lifo", DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtLIFO));
+    Compact("compact address ordered", DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtAddressOrdered));
+    Compact("compact most full page", DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtMostFullPage));
+    Compact("compact external", external);
+    Compact("compact side table", OAConfig(false, PER_PAGE, 0, true, PAD_BYTES, OAConfig::HeaderBlockInfo(OAConfig::hbExtended, 2), 8,
+                                           OAConfig::gtFixed, DEFAULT_MAX_GROWTH_PAGES, false, false, OAConfig::rtLIFO, -1, true));
+
+    ChunkSizes("fixed growth", OAConfig(false, PER_PAGE, 0), std::vector<unsigned>{ 1, 1, 1, 1 });
+    ChunkSizes("doubling growth", OAConfig(false, PER_PAGE, 0, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtDoubling),
+               std::vector<unsigned>{ 1, 2, 4, 8 });
+    ChunkSizes("doubling growth max pages", OAConfig(false, PER_PAGE, 10, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtDoubling),
+               std::vector<unsigned>{ 1, 2, 4, 3 });
+    ChunkSizes("capped growth", OAConfig(false, PER_PAGE, 0, true, PAD_BYTES, OAConfig::HeaderBlockInfo(OAConfig::hbBasic), 16,
+                                         OAConfig::gtCapped, 4),
+               std::vector<unsigned>{ 1, 2, 4, 4, 4 });
+    ChunkSizes("capped growth odd cap", OAConfig(false, PER_PAGE, 0, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtCapped, 3),
+               std::vector<unsigned>{ 1, 2, 3, 3 });
+    ChunkSizes("capped growth max pages", OAConfig(false, PER_PAGE, 9, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtCapped, 4),
+               std::vector<unsigned>{ 1, 2, 4, 2 });
+#ifdef TEST_MAPPED_PAGES
+    ChunkSizes("mapped capped growth", OAConfig(false, PER_PAGE, 0, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtCapped, 4,
+                                                false, false, OAConfig::rtLIFO, 0),
+               std::vector<unsigned>{ 1, 2, 4, 4 });
+    HugeChunks("huge pages", OAConfig(false, PER_PAGE, 0, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtFixed,
+                                      DEFAULT_MAX_GROWTH_PAGES, true));
+    HugeChunks("huge pages debug", OAConfig(false, PER_PAGE, 0, true, PAD_BYTES, OAConfig::HeaderBlockInfo(OAConfig::hbBasic), 0,
+                                            OAConfig::gtDoubling, DEFAULT_MAX_GROWTH_PAGES, true));
+
+    GuardPages("guard pages", OAConfig(false, PER_PAGE, 0, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtFixed,
+                                       DEFAULT_MAX_GROWTH_PAGES, false, false, OAConfig::rtLIFO, -1, false, true));
+    GuardPages("guard pages debug", OAConfig(false, PER_PAGE, 0, true, PAD_BYTES, OAConfig::HeaderBlockInfo(OAConfig::hbBasic), 16,
+                                             OAConfig::gtDoubling, DEFAULT_MAX_GROWTH_PAGES, false, true, OAConfig::rtAddressOrdered,
+                                             -1, false, true));
+    GuardPages("guard pages side table", OAConfig(false, PER_PAGE, 0, true, PAD_BYTES, OAConfig::HeaderBlockInfo(OAConfig::hbExtended, 2),
+                                                  8, OAConfig::gtFixed, DEFAULT_MAX_GROWTH_PAGES, false, false,
+                                                  OAConfig::rtMostFullPage, -1, true, true));
+    GuardPages("guard pages huge pages", OAConfig(false, PER_PAGE, 0, true, PAD_BYTES, OAConfig::HeaderBlockInfo(OAConfig::hbBasic), 0,
+                                                  OAConfig::gtFixed, DEFAULT_MAX_GROWTH_PAGES, true, false, OAConfig::rtLIFO, -1,
+                                                  false, true));
+#endif
+  }
+  catch(const OAException& e)
+  {
+    Fail("unexpected exception", e.what());
+  }
+
+  return Finish("allocator");
+}
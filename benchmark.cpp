@@ -0,0 +1,222 @@
+/**
+ * @file benchmark.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Measures the throughput (ops/sec) and latency (p50/p99/p999) of Allocate and Free across object
+ *        sizes, objects per page, header block types, pad bytes, debug on/off and the new/delete baseline.
+ *        Each configuration is run with the blocks freed in LIFO, FIFO and shuffled order. The results
+ *        are printed as CSV (one line per configuration, pattern and operation) so runs of two versions
+ *        can be diffed or loaded into a spreadsheet to catch regressions.
+ *
+ *        Usage: bench.exe [objects per round] [rounds] [seed]
+ * @date 10-14-2026
+ */
+
+#include "ObjectAllocator.h"
+#include "PRNG.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+  typedef std::chrono::steady_clock Clock;
+
+  /*!
+    The order the blocks of a round are freed in
+  */
+  enum PATTERN
+  {
+    ptLIFO,     //!< the last block allocated is freed first
+    ptFIFO,     //!< the first block allocated is freed first
+    ptShuffled  //!< the blocks are freed in a random order
+  };
+
+  /*!
+    The latencies of one operation over every round of a run
+  */
+  struct Timings
+  {
+    std::vector<long long> nanoseconds_; //!< the latency of each call
+    long long total_;                    //!< the sum of every latency
+  };
+
+  const char* PatternName(PATTERN pattern)
+  {
+    switch(pattern)
+    {
+      case ptLIFO:
+        return "lifo";
+      case ptFIFO:
+        return "fifo";
+      default:
+        return "shuffled";
+    }
+  }
+
+  const char* HeaderName(OAConfig::HBLOCK_TYPE type)
+  {
+    switch(type)
+    {
+      case OAConfig::hbBasic:
+        return "basic";
+      case OAConfig::hbExtended:
+        return "extended";
+      case OAConfig::hbExternal:
+        return "external";
+      default:
+        return "none";
+    }
+  }
+
+  /**
+   * @brief Returns the latency at the given percentile (the timings must be sorted).
+   *
+   * @param sorted - the sorted latencies
+   * @param percentile - the percentile (0 to 1)
+   * @return long long - the latency in nanoseconds
+   */
+  long long Percentile(const std::vector<long long>& sorted, double percentile)
+  {
+    if(sorted.empty())
+      return 0;
+
+    size_t index = static_cast<size_t>(percentile * static_cast<double>(sorted.size() - 1) + 0.5);
+
+    return sorted[index];
+  }
+
+  /**
+   * @brief Prints one CSV line for an operation of a run.
+   */
+  void Report(const char* allocator, const OAConfig& config, size_t objectSize, PATTERN pattern,
+              const char* operation, Timings& timings)
+  {
+    std::sort(timings.nanoseconds_.begin(), timings.nanoseconds_.end());
+
+    size_t ops = timings.nanoseconds_.size();
+    double seconds = static_cast<double>(timings.total_) / 1e9;
+    double opsPerSecond = seconds > 0 ? static_cast<double>(ops) / seconds : 0;
+
+    std::printf("%s,%u,%u,%s,%u,%d,%s,%s,%u,%.0f,%lld,%lld,%lld\n", allocator, static_cast<unsigned>(objectSize),
+                config.ObjectsPerPage_, HeaderName(config.HBlockInfo_.type_), config.PadBytes_,
+                config.DebugOn_ ? 1 : 0, PatternName(pattern), operation, static_cast<unsigned>(ops),
+                opsPerSecond, Percentile(timings.nanoseconds_, 0.50), Percentile(timings.nanoseconds_, 0.99),
+                Percentile(timings.nanoseconds_, 0.999));
+  }
+
+  /**
+   * @brief Times every Allocate and Free of a number of rounds. Each round allocates the given number
+   *        of objects and then frees all of them in the order of the pattern.
+   */
+  void Run(size_t objectSize, const OAConfig& config, PATTERN pattern, unsigned objects, unsigned rounds)
+  {
+    ObjectAllocator oa(objectSize, config);
+
+    std::vector<void*> blocks(objects);
+    Timings allocations = { std::vector<long long>(), 0 };
+    Timings frees = { std::vector<long long>(), 0 };
+    allocations.nanoseconds_.reserve(static_cast<size_t>(objects) * rounds);
+    frees.nanoseconds_.reserve(static_cast<size_t>(objects) * rounds);
+
+    for(unsigned round = 0; round < rounds; ++round)
+    {
+      for(unsigned i = 0; i < objects; ++i)
+      {
+        Clock::time_point start = Clock::now();
+        blocks[i] = oa.Allocate("bench");
+        Clock::time_point end = Clock::now();
+
+        long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        allocations.nanoseconds_.push_back(elapsed);
+        allocations.total_ += elapsed;
+      }
+
+      if(pattern == ptLIFO)
+      {
+        std::reverse(blocks.begin(), blocks.end());
+      }
+      else if(pattern == ptShuffled)
+      {
+        for(unsigned i = objects - 1; i > 0; --i)
+        {
+          unsigned j = static_cast<unsigned>(Digipen::Utils::Random(0, static_cast<int>(i)));
+          std::swap(blocks[i], blocks[j]);
+        }
+      }
+
+      for(unsigned i = 0; i < objects; ++i)
+      {
+        Clock::time_point start = Clock::now();
+        oa.Free(blocks[i]);
+        Clock::time_point end = Clock::now();
+
+        long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        frees.nanoseconds_.push_back(elapsed);
+        frees.total_ += elapsed;
+      }
+    }
+
+    const char* allocator = config.UseCPPMemManager_ ? "new_delete" : "oa";
+    Report(allocator, config, objectSize, pattern, "allocate", allocations);
+    Report(allocator, config, objectSize, pattern, "free", frees);
+  }
+}
+
+/**
+ * @brief Runs every configuration and prints the results as CSV.
+ */
+int main(int argc, char** argv)
+{
+  unsigned objects = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : 4096;
+  unsigned rounds = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 8;
+  unsigned seed = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 1;
+
+  if(objects == 0 || rounds == 0)
+  {
+    std::fprintf(stderr, "Usage: %s [objects per round] [rounds] [seed]\n", argv[0]);
+    return 1;
+  }
+
+  const size_t objectSizes[] = { 16, 64, 256 };
+  const unsigned objectsPerPage[] = { 8, 128 };
+  const unsigned padBytes[] = { 0, 8 };
+  const OAConfig::HBLOCK_TYPE headerTypes[] = { OAConfig::hbNone, OAConfig::hbBasic, OAConfig::hbExtended,
+                                                OAConfig::hbExternal };
+  const PATTERN patterns[] = { ptLIFO, ptFIFO, ptShuffled };
+
+  std::printf("allocator,object_size,objects_per_page,header,pad_bytes,debug,pattern,op,ops,ops_per_sec,"
+              "p50_ns,p99_ns,p999_ns\n");
+
+  for(size_t objectSize : objectSizes)
+  {
+    for(unsigned perPage : objectsPerPage)
+    {
+      for(PATTERN pattern : patterns)
+      {
+        // Every pattern uses the same random order whichever configuration runs it
+        Digipen::Utils::srand(seed, seed + 1);
+
+        // The new/delete baseline
+        Run(objectSize, OAConfig(true, perPage, 0), pattern, objects, rounds);
+
+        for(OAConfig::HBLOCK_TYPE headerType : headerTypes)
+        {
+          OAConfig::HeaderBlockInfo header(headerType, headerType == OAConfig::hbExtended ? 4 : 0);
+
+          for(unsigned pad : padBytes)
+          {
+            for(int debug = 0; debug < 2; ++debug)
+            {
+              Digipen::Utils::srand(seed, seed + 1);
+              Run(objectSize, OAConfig(false, perPage, 0, debug != 0, pad, header), pattern, objects, rounds);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return 0;
+}
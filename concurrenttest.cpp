@@ -0,0 +1,449 @@
+/**
+ * @file concurrenttest.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Checks the allocators with several threads. Producer threads each allocate messages from their own
+ *        pool and consumer threads free them with FreeRemote. The pools have fewer blocks than the messages
+ *        sent, so a producer only keeps going if Allocate reclaims the frees queued by the consumers. Once
+ *        every message is consumed, each pool has to have every block back, the frees counted and its pages
+ *        uncorrupted.
+ *
+ *        Worker threads share a ConcurrentObjectAllocator (with magazines, the lock-free stack or neither),
+ *        trading blocks with each other and freeing the ones they get, and exit while their magazines
+ *        still hold blocks. The stats read while they run have to fit on the pages, the stats have to add
+ *        up across the threads once they're done, and once the blocks left are
+ *        freed, FreeEmptyPages has to free every page. A thread that runs the allocator out of pages has
+ *        to get every block of the pages first. Prints one line for each check that fails and returns 1 if
+ *        any did.
+ *
+ *        Usage: concurrenttest.exe
+ * @date 10-15-2026
+ */
+
+#include "ConcurrentObjectAllocator.h"
+#include "TestChecks.h"
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  const unsigned PRODUCERS = 3;     //!< threads allocating messages
+  const unsigned CONSUMERS = 2;     //!< threads freeing them
+  const unsigned MESSAGES = 20000;  //!< messages sent by each producer
+  const unsigned PER_PAGE = 16;     //!< blocks on a page of a producer's pool
+  const unsigned MAX_PAGES = 4;     //!< pages of a producer's pool (far fewer blocks than messages)
+  const unsigned WORKERS = 4;       //!< threads sharing a concurrent allocator
+  const unsigned ROUNDS = 300;      //!< times each worker allocates a batch
+  const size_t WORK_SIZE = 32;      //!< the size of the workers' blocks
+
+  /*!
+    What a producer sends (the check tells if the block was changed before it was consumed)
+  */
+  struct Message
+  {
+    unsigned producer_; //!< the producer that allocated it
+    unsigned sequence_; //!< the number of messages the producer sent before it
+    unsigned check_;    //!< made from the producer and the sequence
+  };
+
+  unsigned CheckOf(unsigned producer, unsigned sequence)
+  {
+    return (producer * 2654435761u) ^ (sequence * 40503u) ^ 0x5A5A5A5Au;
+  }
+
+  /*!
+    A producer's pool and what happened to its messages
+  */
+  struct Producer
+  {
+    ObjectAllocator* pool_;           //!< only used by the producer until it's done
+    std::atomic<unsigned> consumed_;  //!< messages freed by the consumers
+    std::string error_;               //!< what went wrong in the producer (empty if nothing)
+  };
+
+  /*!
+    The messages sent but not consumed yet (the queue has its own lock, the pools don't)
+  */
+  struct Channel
+  {
+    std::mutex lock_;                   //!< guards the messages
+    std::deque<Message*> messages_;     //!< the messages, oldest first
+    std::atomic<unsigned> producing_;   //!< producers that aren't done
+    std::atomic<unsigned> badMessages_; //!< messages consumed with the wrong contents
+  };
+
+  /*!
+    Sends MESSAGES messages, never more in flight than the pool has blocks
+  */
+  void Produce(Producer* producer, unsigned id, Channel* channel)
+  {
+    try
+    {
+      unsigned capacity = PER_PAGE * MAX_PAGES;
+
+      for(unsigned sequence = 0; sequence < MESSAGES; ++sequence)
+      {
+        while(sequence - producer->consumed_.load(std::memory_order_acquire) >= capacity)
+          std::this_thread::yield();
+
+        // Once the pages are all in use, only the frees queued by the consumers have blocks for this
+        Message* message = static_cast<Message*>(producer->pool_->Allocate());
+        message->producer_ = id;
+        message->sequence_ = sequence;
+        message->check_ = CheckOf(id, sequence);
+
+        std::lock_guard<std::mutex> guard(channel->lock_);
+        channel->messages_.push_back(message);
+      }
+    }
+    catch(const OAException& e)
+    {
+      producer->error_ = e.what();
+    }
+
+    channel->producing_--;
+  }
+
+  /*!
+    Frees messages to the pools of their producers until every producer is done and the queue is empty
+  */
+  void Consume(Producer* producers, Channel* channel)
+  {
+    for(;;)
+    {
+      Message* message = nullptr;
+      bool done = channel->producing_.load() == 0;
+      {
+        std::lock_guard<std::mutex> guard(channel->lock_);
+        if(!channel->messages_.empty())
+        {
+          message = channel->messages_.front();
+          channel->messages_.pop_front();
+        }
+      }
+
+      if(message == nullptr)
+      {
+        if(done)
+          return;
+
+        std::this_thread::yield();
+        continue;
+      }
+
+      unsigned id = message->producer_;
+      if(id >= PRODUCERS || message->check_ != CheckOf(id, message->sequence_))
+      {
+        channel->badMessages_++;
+        continue;
+      }
+
+      producers[id].pool_->FreeRemote(message);
+      producers[id].consumed_.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  /*!
+    Sends messages from the producers to the consumers through pools with the given configuration
+  */
+  void RemoteFrees(const char* name, const OAConfig& config)
+  {
+    std::vector<ObjectAllocator*> pools;
+    Producer producers[PRODUCERS];
+    for(unsigned i = 0; i < PRODUCERS; ++i)
+    {
+      pools.push_back(new ObjectAllocator(sizeof(Message), config));
+      producers[i].pool_ = pools.back();
+      producers[i].consumed_ = 0;
+    }
+
+    Channel channel;
+    channel.producing_ = PRODUCERS;
+    channel.badMessages_ = 0;
+
+    std::vector<std::thread> threads;
+    for(unsigned i = 0; i < PRODUCERS; ++i)
+      threads.push_back(std::thread(Produce, &producers[i], i, &channel));
+    for(unsigned i = 0; i < CONSUMERS; ++i)
+      threads.push_back(std::thread(Consume, producers, &channel));
+    for(std::thread& thread : threads)
+      thread.join();
+
+    if(channel.badMessages_ != 0)
+      Fail(name, "a message was changed before it was consumed");
+
+    for(unsigned i = 0; i < PRODUCERS; ++i)
+    {
+      ObjectAllocator& pool = *pools[i];
+
+      if(!producers[i].error_.empty())
+        Fail(name, producers[i].error_.c_str());
+      if(producers[i].consumed_ != MESSAGES)
+        Fail(name, "the messages weren't all consumed");
+
+      // The owner takes back whatever is still queued
+      pool.ReclaimRemoteFrees();
+
+      OAStats stats = pool.GetStats();
+      if(stats.Allocations_ != MESSAGES || stats.Deallocations_ != MESSAGES || stats.ObjectsInUse_ != 0)
+        Fail(name, "the allocations and frees don't balance");
+      if(stats.PagesInUse_ > MAX_PAGES || stats.FreeObjects_ != stats.PagesInUse_ * PER_PAGE)
+        Fail(name, "the blocks didn't all go back");
+      if(pool.ValidatePages(NoCorruption) != 0)
+        Fail(name, "the pages are corrupted");
+      if(pool.ReclaimRemoteFrees() != 0)
+        Fail(name, "frees were left queued");
+
+      delete pools[i];
+    }
+  }
+
+  /*!
+    What the workers share: the blocks they trade and the blocks they leave in use when they exit
+  */
+  struct Workshop
+  {
+    ConcurrentObjectAllocator* allocator_;  //!< the allocator shared by the workers
+    std::mutex lock_;                       //!< guards the blocks traded and left
+    std::vector<unsigned char*> traded_;    //!< blocks given away for another worker to free
+    std::vector<unsigned char*> left_;      //!< blocks in use when the workers exited
+    std::atomic<unsigned> allocations_;     //!< blocks the workers allocated
+    std::atomic<unsigned> deallocations_;   //!< blocks the workers freed
+    std::atomic<unsigned> badBlocks_;       //!< blocks that were changed by someone else while in use
+    std::atomic<unsigned> working_;         //!< workers that haven't exited
+    std::atomic<unsigned> badStats_;        //!< stats read while the workers ran that didn't fit the pages
+  };
+
+  /*!
+    Fills a block with one byte
+  */
+  void Stamp(unsigned char* block, unsigned char mark)
+  {
+    for(size_t i = 0; i < WORK_SIZE; ++i)
+      block[i] = mark;
+  }
+
+  /*!
+    Checks that a block is still filled with the same byte
+  */
+  bool Stamped(const unsigned char* block)
+  {
+    for(size_t i = 1; i < WORK_SIZE; ++i)
+    {
+      if(block[i] != block[0])
+        return false;
+    }
+
+    return true;
+  }
+
+  /*!
+    Allocates batches of blocks, gives half away, frees what the others gave away and its other half, then
+    exits with blocks still in its magazine (and a few still in use)
+  */
+  void Work(Workshop* shop, unsigned id)
+  {
+    ConcurrentObjectAllocator& allocator = *shop->allocator_;
+    std::vector<unsigned char*> blocks;
+    std::vector<unsigned char*> taken;
+
+    for(unsigned round = 0; round < ROUNDS; ++round)
+    {
+      unsigned count = 5 + (round * 7 + id * 13) % 40;
+      unsigned char mark = static_cast<unsigned char>(id * 64 + round % 64);
+
+      for(unsigned i = 0; i < count; ++i)
+      {
+        blocks.push_back(static_cast<unsigned char*>(allocator.Allocate()));
+        Stamp(blocks.back(), mark);
+      }
+      shop->allocations_ += count;
+
+      std::this_thread::yield();
+
+      // No other thread may have been given the same blocks
+      for(unsigned char* block : blocks)
+      {
+        if(block[0] != mark || !Stamped(block))
+          shop->badBlocks_++;
+      }
+
+      {
+        std::lock_guard<std::mutex> guard(shop->lock_);
+        while(blocks.size() > count / 2)
+        {
+          shop->traded_.push_back(blocks.back());
+          blocks.pop_back();
+        }
+        while(!shop->traded_.empty() && taken.size() < count)
+        {
+          taken.push_back(shop->traded_.back());
+          shop->traded_.pop_back();
+        }
+      }
+
+      for(unsigned char* block : taken)
+      {
+        if(!Stamped(block))
+          shop->badBlocks_++;
+        allocator.Free(block);
+      }
+      for(unsigned char* block : blocks)
+        allocator.Free(block);
+      shop->deallocations_ += static_cast<unsigned>(taken.size() + blocks.size());
+
+      taken.clear();
+      blocks.clear();
+    }
+
+    // The magazine has blocks in it when the thread exits, and a few blocks stay in use
+    for(unsigned i = 0; i < 3; ++i)
+      blocks.push_back(static_cast<unsigned char*>(allocator.Allocate()));
+    shop->allocations_ += 3;
+
+    std::lock_guard<std::mutex> guard(shop->lock_);
+    shop->left_.insert(shop->left_.end(), blocks.begin(), blocks.end());
+  }
+
+  /*!
+    Reads the stats while the workers run (their counters change while they're added up), the blocks in use
+    and free always have to fit on the pages
+  */
+  void Watch(Workshop* shop, unsigned perPage)
+  {
+    while(shop->working_.load() > 0)
+    {
+      OAStats stats = shop->allocator_->GetStats();
+      unsigned blocks = stats.PagesInUse_ * perPage;
+
+      if(stats.ObjectsInUse_ > blocks || stats.FreeObjects_ > blocks)
+        shop->badStats_++;
+    }
+  }
+
+  /*!
+    Runs the workers on a concurrent allocator, then frees everything they left
+  */
+  void Workers(const char* name, const OAConfig& config, unsigned magazineSize, ConcurrentObjectAllocator::CACHE_TYPE cacheType)
+  {
+    ConcurrentObjectAllocator allocator(WORK_SIZE, config, magazineSize, cacheType);
+
+    Workshop shop;
+    shop.allocator_ = &allocator;
+    shop.allocations_ = 0;
+    shop.deallocations_ = 0;
+    shop.badBlocks_ = 0;
+    shop.working_ = WORKERS;
+    shop.badStats_ = 0;
+
+    std::vector<std::thread> threads;
+    for(unsigned i = 0; i < WORKERS; ++i)
+    {
+      threads.push_back(std::thread([&shop, i]()
+      {
+        Work(&shop, i);
+        shop.working_--;
+      }));
+    }
+    threads.push_back(std::thread(Watch, &shop, config.ObjectsPerPage_));
+    for(std::thread& thread : threads)
+      thread.join();
+
+    if(shop.badBlocks_ != 0)
+      Fail(name, "a block was given to two threads at once");
+    if(shop.badStats_ != 0)
+      Fail(name, "the stats read while the threads ran didn't fit on the pages");
+
+    // The exited threads' counters are kept, the blocks in their magazines count as free
+    OAStats stats = allocator.GetStats();
+    unsigned inUse = static_cast<unsigned>(shop.traded_.size() + shop.left_.size());
+    if(stats.Allocations_ != shop.allocations_ || stats.Deallocations_ != shop.deallocations_)
+      Fail(name, "the allocations and frees of the threads don't add up");
+    if(stats.ObjectsInUse_ != inUse || stats.FreeObjects_ + stats.ObjectsInUse_ != stats.PagesInUse_ * config.ObjectsPerPage_)
+      Fail(name, "the blocks in use don't add up");
+
+    for(unsigned char* block : shop.traded_)
+      allocator.Free(block);
+    for(unsigned char* block : shop.left_)
+      allocator.Free(block);
+    allocator.FlushThreadCache();
+
+    stats = allocator.GetStats();
+    if(stats.ObjectsInUse_ != 0 || stats.Allocations_ != stats.Deallocations_)
+      Fail(name, "the blocks didn't all go back");
+
+    // Nothing is left in a magazine of an exited thread
+    allocator.FreeEmptyPages();
+    stats = allocator.GetStats();
+    if(stats.PagesInUse_ != 0 || stats.FreeObjects_ != 0)
+      Fail(name, "pages were left after the blocks were all freed");
+  }
+
+  /*!
+    Allocates from a thread until the allocator runs out of pages, which has to be after every block
+  */
+  void OutOfPages(const char* name, unsigned magazineSize, ConcurrentObjectAllocator::CACHE_TYPE cacheType)
+  {
+    const unsigned pages = 3;
+    ConcurrentObjectAllocator allocator(WORK_SIZE, OAConfig(false, PER_PAGE, pages), magazineSize, cacheType);
+
+    std::thread thread([&]()
+    {
+      std::vector<void*> blocks;
+      try
+      {
+        for(;;)
+          blocks.push_back(allocator.Allocate());
+      }
+      catch(const OAException& e)
+      {
+        if(e.code() != OAException::E_NO_PAGES)
+          Fail(name, "running out of pages threw the wrong error");
+      }
+
+      if(blocks.size() != pages * PER_PAGE)
+        Fail(name, "the allocator ran out of pages before every block was taken");
+
+      for(void* block : blocks)
+        allocator.Free(block);
+    });
+    thread.join();
+
+    allocator.FreeEmptyPages();
+    if(allocator.GetStats().PagesInUse_ != 0)
+      Fail(name, "pages were left after the blocks were all freed");
+  }
+}
+
+int main()
+{
+  try
+  {
+    RemoteFrees("remote frees", OAConfig(false, PER_PAGE, MAX_PAGES));
+    RemoteFrees("remote frees debug", OAConfig(false, PER_PAGE, MAX_PAGES, true, 4, OAConfig::HeaderBlockInfo(OAConfig::hbBasic)));
+    RemoteFrees("remote frees address ordered", OAConfig(false, PER_PAGE, MAX_PAGES, true, 2, OAConfig::HeaderBlockInfo(OAConfig::hbExtended, 2),
+                                                         0, OAConfig::gtFixed, DEFAULT_MAX_GROWTH_PAGES, false, false,
+                                                         OAConfig::rtAddressOrdered));
+
+    // A magazine size that doesn't divide the blocks of a page, the default, the lock-free stack and no caching
+    Workers("magazines", OAConfig(false, PER_PAGE, 0), 10, ConcurrentObjectAllocator::ctMagazines);
+    Workers("default magazines", OAConfig(false, PER_PAGE, 0), DEFAULT_MAGAZINE_SIZE, ConcurrentObjectAllocator::ctMagazines);
+    Workers("lock-free stack", OAConfig(false, PER_PAGE, 0), 10, ConcurrentObjectAllocator::ctLockFree);
+    Workers("no magazines", OAConfig(false, PER_PAGE, 0), 0, ConcurrentObjectAllocator::ctMagazines);
+    Workers("debug", DebugConfig(PER_PAGE, 4), 10,
+            ConcurrentObjectAllocator::ctMagazines);
+
+    OutOfPages("magazines out of pages", 10, ConcurrentObjectAllocator::ctMagazines);
+    OutOfPages("lock-free stack out of pages", 10, ConcurrentObjectAllocator::ctLockFree);
+  }
+  catch(const OAException& e)
+  {
+    Fail("unexpected exception", e.what());
+  }
+
+  return Finish("concurrent");
+}
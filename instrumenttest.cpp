@@ -0,0 +1,286 @@
+/**
+ * @file instrumenttest.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Checks the instrumentation counters, the latency histograms and the allocation site sampling
+ *        against a known sequence of calls. Built with OA_INSTRUMENT (the instrumenttest target).
+ *
+ *        Counters: the pages added, the chunks reserved, the allocations that found no free block and the
+ *        ones that found no pages left are counted once each.
+ *
+ *        Latency: with 1 in every N calls timed, the Allocate and Free histograms get exactly the calls
+ *        sampled (each in one bucket), and nothing once sampling is off.
+ *
+ *        Sites: sampling every allocation gives each label its exact number of allocations and the ones
+ *        still in use (after frees and a reset), and sampling 1 in N gives about 1 in N of them.
+ *
+ *        Prints one line for each check that fails and returns 1 if any did.
+ *
+ *        Usage: instrumenttest.exe
+ * @date 10-15-2026
+ */
+
+#ifndef OA_INSTRUMENT
+#error "instrumenttest needs the allocator built with OA_INSTRUMENT (make instrumenttest)"
+#endif
+
+#include "ObjectAllocator.h"
+#include "TestChecks.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+  const size_t OBJECT_SIZE = 24; //!< size of the objects of every pool
+  const unsigned PER_PAGE = 8;   //!< objects on each page of every pool
+
+  /*!
+    What was sampled for one label (added up over its sites)
+  */
+  struct LabelTotals
+  {
+    const char* label_; //!< the label
+    unsigned sampled_;  //!< the allocations sampled
+    unsigned live_;     //!< the ones not freed yet
+    unsigned rate_;     //!< the sample rate the dump was given
+  };
+
+  std::vector<LabelTotals> Totals; //!< the totals of the labels dumped since the list was last cleared
+
+  void AddSite(const OASampledSite& site, unsigned rate)
+  {
+    for(LabelTotals& totals : Totals)
+    {
+      if((totals.label_ == nullptr) ? site.label_ == nullptr : (site.label_ != nullptr && std::strcmp(totals.label_, site.label_) == 0))
+      {
+        totals.sampled_ += site.sampled_;
+        totals.live_ += site.live_;
+        return;
+      }
+    }
+
+    LabelTotals totals = { site.label_, site.sampled_, site.live_, rate };
+    Totals.push_back(totals);
+  }
+
+  /*!
+    Dumps the sampled sites and returns the totals of a label (all 0 if it wasn't sampled)
+  */
+  LabelTotals TotalsOf(const ObjectAllocator& oa, const char* label)
+  {
+    Totals.clear();
+    oa.DumpSampledSites(AddSite);
+
+    for(const LabelTotals& totals : Totals)
+    {
+      if(totals.label_ != nullptr && std::strcmp(totals.label_, label) == 0)
+        return totals;
+    }
+
+    LabelTotals none = { label, 0, 0, 0 };
+    return none;
+  }
+
+  /*!
+    Returns the number of calls in a histogram
+  */
+  unsigned Samples(const unsigned* histogram)
+  {
+    unsigned samples = 0;
+    for(unsigned bucket = 0; bucket < LATENCY_BUCKETS; ++bucket)
+      samples += histogram[bucket];
+
+    return samples;
+  }
+
+  /*!
+    Grows a pool with doubling growth to its max pages and past it
+  */
+  void Counters()
+  {
+    const char* name = "counters";
+    ObjectAllocator oa(OBJECT_SIZE, OAConfig(false, PER_PAGE, 7, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtDoubling));
+
+    // Chunks of 1, 2 and 4 pages (the first page is added by the constructor, without a stall)
+    std::vector<void*> blocks;
+    for(unsigned i = 0; i < PER_PAGE * 7; ++i)
+      blocks.push_back(oa.Allocate());
+
+    OAInstrumentation counters = oa.GetInstrumentation();
+    if(counters.PagesAllocated_ != 7 || counters.ChunksReserved_ != 3)
+      Fail(name, "the pages or chunks weren't counted");
+    if(counters.FreeListStalls_ != 6 || counters.NoPagesHits_ != 0)
+      Fail(name, "the allocations without a free block weren't counted");
+    if(counters.AllocatePageNanoseconds_ == 0)
+      Fail(name, "adding the pages wasn't timed");
+
+    for(unsigned i = 0; i < 3; ++i)
+    {
+      try
+      {
+        oa.Allocate();
+        Fail(name, "a page was added past the max pages");
+      }
+      catch(const OAException& e)
+      {
+        if(e.code() != OAException::E_NO_PAGES)
+          Fail(name, "the wrong error was reported past the max pages");
+      }
+    }
+    if(oa.TryAllocate() != nullptr)
+      Fail(name, "TryAllocate added a page past the max pages");
+
+    counters = oa.GetInstrumentation();
+    if(counters.NoPagesHits_ != 4 || counters.FreeListStalls_ != 10 || counters.PagesAllocated_ != 7)
+      Fail(name, "the allocations past the max pages weren't counted");
+
+    // Freed blocks are found on the free list, nothing else is counted
+    oa.Free(blocks.back());
+    blocks.pop_back();
+    blocks.push_back(oa.Allocate());
+    if(oa.GetInstrumentation().FreeListStalls_ != 10)
+      Fail(name, "an allocation from the free list was counted as a stall");
+
+    for(void* block : blocks)
+      oa.Free(block);
+  }
+
+  /*!
+    Times 1 in every few calls and checks the histograms have exactly the calls sampled
+  */
+  void Latency(const char* name, unsigned every)
+  {
+    ObjectAllocator oa(OBJECT_SIZE, OAConfig(false, PER_PAGE, 0));
+    const unsigned calls = 400;
+
+    // Nothing is timed until sampling is on
+    std::vector<void*> blocks;
+    for(unsigned i = 0; i < calls; ++i)
+      blocks.push_back(oa.Allocate());
+    for(void* block : blocks)
+      oa.Free(block);
+    blocks.clear();
+
+    OAInstrumentation counters = oa.GetInstrumentation();
+    if(Samples(counters.AllocateLatency_) != 0 || Samples(counters.FreeLatency_) != 0)
+      Fail(name, "calls were timed before sampling was on");
+
+    oa.SetLatencySampling(every);
+    if(oa.GetInstrumentation().LatencySampleEvery_ != every)
+      Fail(name, "the sample rate wasn't kept");
+
+    for(unsigned i = 0; i < calls; ++i)
+      blocks.push_back(oa.Allocate());
+    for(unsigned i = 0; i < calls / 2; ++i)
+      oa.Free(blocks[i]);
+
+    counters = oa.GetInstrumentation();
+    if(Samples(counters.AllocateLatency_) != calls / every)
+      Fail(name, "the Allocate histogram doesn't have the calls sampled");
+    if(Samples(counters.FreeLatency_) != calls / 2 / every)
+      Fail(name, "the Free histogram doesn't have the calls sampled");
+
+    // Nothing is timed once sampling is off
+    oa.SetLatencySampling(0);
+    for(unsigned i = calls / 2; i < calls; ++i)
+      oa.Free(blocks[i]);
+
+    OAInstrumentation after = oa.GetInstrumentation();
+    if(std::memcmp(after.AllocateLatency_, counters.AllocateLatency_, sizeof(after.AllocateLatency_)) != 0 ||
+       std::memcmp(after.FreeLatency_, counters.FreeLatency_, sizeof(after.FreeLatency_)) != 0)
+      Fail(name, "calls were timed after sampling was turned off");
+  }
+
+  /*!
+    Allocates blocks with a label
+  */
+  void AllocateLabelled(ObjectAllocator& oa, const char* label, unsigned count, std::vector<void*>& blocks)
+  {
+    for(unsigned i = 0; i < count; ++i)
+      blocks.push_back(oa.Allocate(label));
+  }
+
+  /*!
+    Samples every allocation and checks each label's totals
+  */
+  void EverySite()
+  {
+    const char* name = "every site";
+    ObjectAllocator oa(OBJECT_SIZE, OAConfig(false, PER_PAGE, 0));
+    oa.SetAllocationSampling(1);
+
+    // The same text at another address is the same label
+    char copy[] = "alpha";
+    std::vector<void*> alpha;
+    std::vector<void*> beta;
+    AllocateLabelled(oa, "alpha", 30, alpha);
+    AllocateLabelled(oa, copy, 10, alpha);
+    AllocateLabelled(oa, "beta", 20, beta);
+    for(unsigned i = 0; i < 15; ++i)
+      oa.Free(alpha[i]);
+
+    LabelTotals totals = TotalsOf(oa, "alpha");
+    if(totals.sampled_ != 40 || totals.live_ != 25 || totals.rate_ != 1)
+      Fail(name, "the first label's totals are wrong");
+    totals = TotalsOf(oa, "beta");
+    if(totals.sampled_ != 20 || totals.live_ != 20)
+      Fail(name, "the second label's totals are wrong");
+
+    // A reset frees everything, the counts sampled stay
+    oa.Reset(1);
+    if(TotalsOf(oa, "alpha").live_ != 0 || TotalsOf(oa, "beta").live_ != 0 || TotalsOf(oa, "alpha").sampled_ != 40)
+      Fail(name, "the blocks freed by the reset are still live");
+  }
+
+  /*!
+    Samples 1 in every few allocations and checks about that many were sampled
+  */
+  void SomeSites()
+  {
+    const char* name = "some sites";
+    const unsigned every = 8;
+    const unsigned count = 8000;
+
+    ObjectAllocator oa(OBJECT_SIZE, OAConfig(false, PER_PAGE, 0));
+    oa.SetAllocationSampling(every);
+
+    std::vector<void*> blocks;
+    AllocateLabelled(oa, "gamma", count, blocks);
+
+    LabelTotals totals = TotalsOf(oa, "gamma");
+    if(totals.rate_ != every || totals.sampled_ * every < count * 4 / 5 || totals.sampled_ * every > count * 6 / 5)
+      Fail(name, "the samples don't stand for the allocations");
+    if(totals.live_ != totals.sampled_)
+      Fail(name, "the sampled blocks aren't live");
+
+    for(void* block : blocks)
+      oa.Free(block);
+    if(TotalsOf(oa, "gamma").live_ != 0)
+      Fail(name, "the freed blocks are still live");
+
+    // Nothing more is sampled once sampling is off
+    oa.SetAllocationSampling(0);
+    AllocateLabelled(oa, "gamma", count, blocks);
+    if(TotalsOf(oa, "gamma").sampled_ != totals.sampled_)
+      Fail(name, "allocations were sampled after sampling was turned off");
+  }
+}
+
+int main()
+{
+  try
+  {
+    Counters();
+    Latency("latency every call", 1);
+    Latency("latency every 4", 4);
+    Latency("latency every 7", 7);
+    EverySite();
+    SomeSites();
+  }
+  catch(const OAException& e)
+  {
+    Fail("unexpected exception", e.what());
+  }
+
+  return Finish("instrumentation");
+}
@@ -0,0 +1,255 @@
+/**
+ * @file mappedtest.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Checks that a pool kept in a mapped file comes back the way it was left. Each configuration builds
+ *        a linked list in a pool, frees some of it (some with FreeRemote, left queued when the pool is
+ *        destroyed), reopens the file and checks the objects in use, the list and the free blocks. Each
+ *        one is reopened in the same process and in a new one (the program runs itself again with
+ *        "reopen", so the file is mapped back at its address in a process that never mapped it). A file
+ *        is also reopened with the wrong configuration, which has to be rejected. On a system without
+ *        mapped files, only the error is checked. Prints one line for each check that fails and returns 1
+ *        if any did.
+ *
+ *        Usage: mappedtest.exe [file]
+ *               mappedtest.exe file reopen configuration head (run by the program itself)
+ * @date 10-14-2026
+ */
+
+#include "ObjectAllocator.h"
+#include "TestChecks.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+  /*!
+    An object in the pool (the list is linked through the pool's own addresses)
+  */
+  struct Node
+  {
+    Node* next_;     //!< the next node of the list
+    unsigned value_; //!< the position of the node in the list
+  };
+
+#if defined(__unix__) || defined(__APPLE__)
+  const unsigned NODES = 2000;           //!< nodes allocated by each check
+  const unsigned LIVE = (NODES + 2) / 3; //!< nodes left on the list (every third one)
+  const unsigned CONFIGS = 12;           //!< configurations checked
+
+  /*!
+    Returns one of the configurations checked, and its name
+  */
+  OAConfig MappedConfig(unsigned index, char* name, size_t nameSize)
+  {
+    const OAConfig::REUSE_TYPE reuses[] = { OAConfig::rtLIFO, OAConfig::rtAddressOrdered, OAConfig::rtMostFullPage };
+    const char* reuseNames[] = { "lifo", "address", "mostfull" };
+
+    unsigned reuse = index / 4;
+    unsigned variant = index % 4;
+    bool debug = (variant & 1) != 0;
+    bool lazy = (variant & 2) != 0;
+
+    std::snprintf(name, nameSize, "%s%s%s%s", reuseNames[reuse], debug ? " debug" : "", lazy ? " lazy" : "",
+                  variant == 3 ? " side table" : "");
+
+    return OAConfig(false, 32, 0, debug, debug ? 8 : 0, OAConfig::HeaderBlockInfo(OAConfig::hbBasic), 0,
+                    OAConfig::gtFixed, DEFAULT_MAX_GROWTH_PAGES, false, lazy, reuses[reuse], -1, variant == 3);
+  }
+
+  /*!
+    Builds a list in a new pool kept in the file and returns its head (the pool is destroyed, so the 
+    list is left in the file)
+  */
+  Node* Build(const char* path, const OAConfig& config)
+  {
+    std::remove(path);
+
+    Node* head = nullptr;
+
+    {
+      ObjectAllocator pool(sizeof(Node), config, path);
+
+      std::vector<Node*> nodes;
+      for(unsigned i = 0; i < NODES; ++i)
+        nodes.push_back(static_cast<Node*>(pool.Allocate()));
+
+      // Every third node stays on the list, the rest are freed (every seventh one from another "thread",
+      // still queued when the pool is destroyed)
+      Node** link = &head;
+      for(unsigned i = 0; i < NODES; ++i)
+      {
+        if(i % 3 == 0)
+        {
+          nodes[i]->value_ = i;
+          *link = nodes[i];
+          link = &nodes[i]->next_;
+        }
+        else if(i % 7 == 0)
+          pool.FreeRemote(nodes[i]);
+        else
+          pool.Free(nodes[i]);
+      }
+      *link = nullptr;
+    }
+
+    return head;
+  }
+
+  /*!
+    Reopens a pool left by Build and checks the list is still there, then frees everything
+  */
+  void Check(const char* path, const char* name, const OAConfig& config, Node* head)
+  {
+    ObjectAllocator pool(sizeof(Node), config, path);
+
+    if(pool.GetStats().ObjectsInUse_ != LIVE)
+      Fail(name, "the objects in use changed");
+    if(pool.GetStats().FreeObjects_ + LIVE != pool.GetStats().PagesInUse_ * config.ObjectsPerPage_)
+      Fail(name, "the free objects changed");
+    if(pool.ValidatePages(NoCorruption) != 0)
+      Fail(name, "the pages are corrupted");
+
+    unsigned listed = 0;
+    for(Node* node = head; node != nullptr; node = node->next_)
+    {
+      if(node->value_ != listed * 3)
+      {
+        Fail(name, "the list changed");
+        break;
+      }
+      listed++;
+    }
+    if(listed != LIVE)
+      Fail(name, "the list lost nodes");
+
+    // The free blocks can be allocated again, and everything freed
+    std::vector<void*> more;
+    for(unsigned i = 0; i < NODES - LIVE; ++i)
+      more.push_back(pool.Allocate());
+    for(void* block : more)
+      pool.Free(block);
+    while(head != nullptr)
+    {
+      Node* next = head->next_;
+      pool.Free(head);
+      head = next;
+    }
+
+    if(pool.GetStats().ObjectsInUse_ != 0)
+      Fail(name, "objects are left in use");
+  }
+
+  /*!
+    Builds a list in a new pool and reopens it in this process
+  */
+  void RoundTrip(const char* path, const char* name, const OAConfig& config)
+  {
+    Node* head = Build(path, config);
+
+    Check(path, name, config, head);
+  }
+
+  /*!
+    Builds a list in a new pool and reopens it in a new process (this program run with "reopen")
+  */
+  void FreshProcess(const char* self, const char* path, const char* name, const OAConfig& config, unsigned index)
+  {
+    Node* head = Build(path, config);
+
+    char command[1024];
+    std::snprintf(command, sizeof(command), "\"%s\" \"%s\" reopen %u %p", self, path, index, static_cast<void*>(head));
+
+    // The new process prints the checks that fail in it
+    std::fflush(stdout);
+    if(std::system(command) != 0)
+      Fail(name, "the pool wasn't the same in a new process");
+  }
+
+  /*!
+    Reopens a saved pool with a different object size
+  */
+  void WrongConfig(const char* path)
+  {
+    std::remove(path);
+
+    {
+      ObjectAllocator pool(sizeof(Node), OAConfig(false, 32, 8), path);
+      pool.Allocate();
+    }
+
+    try
+    {
+      ObjectAllocator pool(sizeof(Node) * 2, OAConfig(false, 32, 8), path);
+      Fail("wrong config", "the file was reopened");
+    }
+    catch(const OAException& e)
+    {
+      if(e.code() != OAException::E_BAD_MAPPED_FILE)
+        Fail("wrong config", "the wrong error was reported");
+    }
+  }
+#endif
+}
+
+int main(int argc, char** argv)
+{
+  const char* path = (argc > 1) ? argv[1] : "mappedtest.pool";
+
+#if defined(__unix__) || defined(__APPLE__)
+  try
+  {
+    // Run by FreshProcess to check the file it left
+    if(argc > 4 && std::strcmp(argv[2], "reopen") == 0)
+    {
+      char name[64];
+      unsigned index = static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10));
+      void* head = nullptr;
+
+      if(index >= CONFIGS || std::sscanf(argv[4], "%p", &head) != 1)
+        Fail("reopen", "the arguments are wrong");
+      else
+      {
+        OAConfig config = MappedConfig(index, name, sizeof(name));
+        std::strncat(name, " new process", sizeof(name) - std::strlen(name) - 1);
+
+        Check(path, name, config, static_cast<Node*>(head));
+      }
+
+      return Failures() == 0 ? 0 : 1;
+    }
+
+    for(unsigned index = 0; index < CONFIGS; ++index)
+    {
+      char name[64];
+      OAConfig config = MappedConfig(index, name, sizeof(name));
+
+      RoundTrip(path, name, config);
+      FreshProcess(argv[0], path, name, config, index);
+    }
+
+    WrongConfig(path);
+  }
+  catch(const OAException& e)
+  {
+    Fail("unexpected exception", e.what());
+  }
+#else
+  // Without mapped files, asking for one has to be rejected
+  try
+  {
+    ObjectAllocator pool(sizeof(Node), OAConfig(false, 32, 8), path);
+    Fail("unsupported", "a mapped file was opened");
+  }
+  catch(const OAException& e)
+  {
+    if(e.code() != OAException::E_BAD_MAPPED_FILE)
+      Fail("unsupported", "the wrong error was reported");
+  }
+#endif
+
+  std::remove(path);
+
+  return Finish("mapped file");
+}
@@ -0,0 +1,229 @@
+/**
+ * @file numatest.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Checks the NUMA front-end and the pools bound to a NUMA node, whatever nodes the system has.
+ *
+ *        Node count: the possible nodes are read from ranges like "0-3" or "0,2-5", and a missing, empty or
+ *        unreadable list falls back to 1 node.
+ *
+ *        Wrong node: blocks are allocated from each node's pool (including nodes the system doesn't have)
+ *        and freed from another thread and from a thread on a different node than their own. Each free has
+ *        to go back to the pool that owns the block (so a double free is still caught) and every page has to
+ *        be freed at the end.
+ *
+ *        Single node: pools bound to node 0 and to a node past the last one still hand out writable blocks
+ *        (the binding is only a hint), uncorrupted, and free their pages.
+ *
+ *        Prints one line for each check that fails and returns 1 if any did.
+ *
+ *        Usage: numatest.exe
+ * @date 10-15-2026
+ */
+
+#include "NumaObjectAllocator.h"
+#include "TestChecks.h"
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  const size_t OBJECT_SIZE = 40;  //!< size of the objects of every pool
+  const unsigned PER_PAGE = 8;    //!< objects on each page of every pool
+  const unsigned PAD_BYTES = 4;   //!< pad bytes of the debug pools
+  const unsigned NODES = 3;       //!< nodes of the front-end checked (more than most systems have)
+  const char* LIST = "numatest.nodes"; //!< the node list written by the checks
+
+  /*!
+    Writes a list of nodes and checks the count read from it
+  */
+  void CountFrom(const char* contents, unsigned expected)
+  {
+    std::FILE* file = std::fopen(LIST, "w");
+    if(file == nullptr)
+    {
+      Fail("node count", "the node list can't be written");
+      return;
+    }
+    std::fputs(contents, file);
+    std::fclose(file);
+
+    if(NumaObjectAllocator::NodeCount(LIST) != expected)
+    {
+      char what[64];
+      std::snprintf(what, sizeof(what), "\"%s\" isn't %u nodes", contents, expected);
+      Fail("node count", what);
+    }
+
+    std::remove(LIST);
+  }
+
+  /*!
+    Checks the node count read from a list and the fallback when there's no list
+  */
+  void NodeCount()
+  {
+    std::remove(LIST);
+    if(NumaObjectAllocator::NodeCount(LIST) != 1)
+      Fail("node count", "a missing node list isn't 1 node");
+
+#if defined(__linux__)
+    CountFrom("0\n", 1);
+    CountFrom("0-3\n", 4);
+    CountFrom("0,2-5\n", 6);
+    CountFrom("", 1);
+    CountFrom("none\n", 1);
+#endif
+
+    if(NumaObjectAllocator::NodeCount() == 0 || NumaObjectAllocator::CurrentNode() >= NumaObjectAllocator::NodeCount())
+      Fail("node count", "the thread isn't on one of the nodes");
+  }
+
+  /*!
+    Returns the objects in use on every node
+  */
+  std::vector<unsigned> InUse(const NumaObjectAllocator& noa)
+  {
+    std::vector<unsigned> inUse;
+    for(unsigned node = 0; node < noa.GetNodes(); ++node)
+      inUse.push_back(noa.GetNodeStats(node).ObjectsInUse_);
+
+    return inUse;
+  }
+
+  /*!
+    Allocates from every node and frees each block from a thread that isn't on the block's node
+  */
+  void WrongNode(const char* name, const OAConfig& config)
+  {
+    NumaObjectAllocator noa(OBJECT_SIZE, config, NODES);
+
+    if(noa.GetNodes() != NODES)
+      Fail(name, "the nodes weren't all created");
+
+    // Every block is on the node it was allocated from (past the last node wraps around), a page from each
+    // node the first time around and another one the second
+    std::vector<std::vector<char*>> blocks(NODES);
+    for(unsigned node = 0; node < NODES * 2; ++node)
+    {
+      for(unsigned i = 0; i < PER_PAGE; ++i)
+      {
+        char* block = static_cast<char*>(noa.AllocateOnNode(node));
+        std::memset(block, static_cast<int>(node), OBJECT_SIZE);
+        blocks[node % NODES].push_back(block);
+      }
+    }
+    for(unsigned node = 0; node < NODES; ++node)
+    {
+      if(InUse(noa)[node] != blocks[node].size())
+        Fail(name, "a block wasn't allocated from its node");
+    }
+
+    // Allocate uses the thread's node
+    std::vector<unsigned> before = InUse(noa);
+    void* local = noa.Allocate();
+    if(InUse(noa)[NumaObjectAllocator::CurrentNode() % NODES] != before[NumaObjectAllocator::CurrentNode() % NODES] + 1)
+      Fail(name, "the block wasn't allocated from the thread's node");
+    noa.Free(local);
+
+    // The first node's blocks are freed by another thread, the others by this one (the thread is on one
+    // node, at most, so the blocks of the other nodes are freed from the wrong node)
+    std::thread other([&noa, &blocks]()
+    {
+      for(char* block : blocks[0])
+        noa.Free(block);
+    });
+    other.join();
+
+    for(unsigned node = 1; node < NODES; ++node)
+    {
+      for(char* block : blocks[node])
+        noa.Free(block);
+    }
+
+    for(unsigned node = 0; node < NODES; ++node)
+    {
+      if(InUse(noa)[node] != 0)
+        Fail(name, "a block wasn't freed to its node");
+    }
+
+    // A double free from the wrong node still goes to the node that owns the block
+    if(config.DebugOn_)
+    {
+      unsigned wrong = NumaObjectAllocator::CurrentNode() + 1;
+      void* block = noa.AllocateOnNode(wrong);
+      noa.Free(block);
+      try
+      {
+        noa.Free(block);
+        Fail(name, "a double free from the wrong node wasn't caught");
+      }
+      catch(const OAException& e)
+      {
+        if(e.code() != OAException::E_MULTIPLE_FREE)
+          Fail(name, "a double free from the wrong node was the wrong error");
+      }
+    }
+
+    unsigned pages = 0;
+    for(unsigned node = 0; node < NODES; ++node)
+      pages += noa.GetNodeStats(node).PagesInUse_;
+    if(noa.FreeEmptyPages() != pages || pages < NODES * 2)
+      Fail(name, "the pages weren't all freed");
+  }
+
+  /*!
+    Allocates from a pool bound to a node, which might not exist
+  */
+  void BoundPool(const char* name, const OAConfig& config)
+  {
+    ObjectAllocator oa(OBJECT_SIZE, config);
+
+    std::vector<char*> blocks;
+    for(unsigned i = 0; i < PER_PAGE * 3; ++i)
+    {
+      char* block = static_cast<char*>(oa.Allocate());
+      std::memset(block, 0x5A, OBJECT_SIZE);
+      blocks.push_back(block);
+    }
+
+    if(oa.GetStats().PagesInUse_ != 3)
+      Fail(name, "the pages weren't added");
+    if(oa.ValidatePages(NoCorruption) != 0)
+      Fail(name, "the pages are corrupted");
+
+    for(char* block : blocks)
+      oa.Free(block);
+
+    if(oa.FreeEmptyPages() != 3)
+      Fail(name, "the pages weren't freed");
+  }
+}
+
+int main()
+{
+  try
+  {
+    NodeCount();
+
+    WrongNode("wrong node", OAConfig(false, PER_PAGE));
+    WrongNode("wrong node debug", DebugConfig(PER_PAGE, PAD_BYTES));
+    WrongNode("wrong node address ordered", DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtAddressOrdered));
+
+    int missing = static_cast<int>(NumaObjectAllocator::NodeCount());
+    BoundPool("node 0", OAConfig(false, PER_PAGE, 0, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtFixed,
+                                 DEFAULT_MAX_GROWTH_PAGES, false, false, OAConfig::rtLIFO, 0));
+    BoundPool("node 0 debug", DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtLIFO, 0));
+    BoundPool("node 0 lazy most full page", DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtMostFullPage, 0));
+    BoundPool("missing node", DebugConfig(PER_PAGE, PAD_BYTES, false, OAConfig::rtLIFO, missing));
+    BoundPool("missing node doubling", OAConfig(false, PER_PAGE, 0, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtDoubling,
+                                                DEFAULT_MAX_GROWTH_PAGES, false, false, OAConfig::rtAddressOrdered, missing));
+  }
+  catch(const OAException& e)
+  {
+    Fail("unexpected exception", e.what());
+  }
+
+  return Finish("NUMA");
+}
@@ -0,0 +1,213 @@
+/**
+ * @file objectpooltest.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Checks the ObjectPool against an ObjectAllocator with the same configuration. Each policy (every
+ *        header type, with and without padding and over-alignment) fills a pool and an OA side by side and
+ *        checks that the blocks are at the same offsets with the same header blocks and alignment, that
+ *        the stats and configurations match, that running out of pages throws E_NO_PAGES, that destroy
+ *        runs the destructor and that a constructor that throws gives its block back. Prints one line for
+ *        each check that fails and returns 1 if any did.
+ *
+ *        Usage: objectpooltest.exe
+ * @date 10-15-2026
+ */
+
+#include "ObjectPool.h"
+#include "TestChecks.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+  /*!
+    An object of Size bytes aligned on Align. Its constructor throws when given a negative value.
+  */
+  template <size_t Size, size_t Align>
+  struct alignas(Align) Item
+  {
+    explicit Item(int value)
+    {
+      if(value < 0)
+        throw value;
+
+      bytes_[0] = static_cast<unsigned char>(value);
+      Live++;
+    }
+
+    ~Item()
+    {
+      Live--;
+    }
+
+    unsigned char bytes_[Size]; //!< the object (the value is kept in the first byte)
+
+    static int Live; //!< objects constructed and not destroyed yet
+  };
+
+  template <size_t Size, size_t Align>
+  int Item<Size, Align>::Live = 0;
+
+  /*!
+    Checks that the pool and the OA have the same statistics
+  */
+  void CompareStats(const char* name, const OAStats& pool, const OAStats& oa)
+  {
+    if(pool.ObjectSize_ != oa.ObjectSize_ || pool.PageSize_ != oa.PageSize_)
+      Fail(name, "the object or page size is different from the OA's");
+    if(pool.FreeObjects_ != oa.FreeObjects_ || pool.ObjectsInUse_ != oa.ObjectsInUse_ || pool.PagesInUse_ != oa.PagesInUse_)
+      Fail(name, "the object or page counts are different from the OA's");
+    if(pool.MostObjects_ != oa.MostObjects_ || pool.Allocations_ != oa.Allocations_ || pool.Deallocations_ != oa.Deallocations_)
+      Fail(name, "the allocation counts are different from the OA's");
+  }
+
+  /*!
+    Fills a pool of T and an OA with its configuration side by side and compares them
+  */
+  template <typename T, typename Policy>
+  void CheckPool(const char* name)
+  {
+    ObjectPool<T, Policy> pool;
+
+    OAConfig config = pool.GetConfig();
+    ObjectAllocator oa(pool.GetStats().ObjectSize_, config);
+    OAConfig oaConfig = oa.GetConfig();
+
+    if(config.ObjectsPerPage_ != Policy::ObjectsPerPage_ || config.MaxPages_ != Policy::MaxPages_ ||
+       config.PadBytes_ != Policy::PadBytes_ || config.HBlockInfo_.type_ != Policy::HeaderType_)
+      Fail(name, "the configuration isn't the policy");
+    if(config.LeftAlignSize_ != oaConfig.LeftAlignSize_ || config.InterAlignSize_ != oaConfig.InterAlignSize_ ||
+       config.HBlockInfo_.size_ != oaConfig.HBlockInfo_.size_)
+      Fail(name, "the alignment or header sizes are different from the OA's");
+    if(config.Alignment_ % alignof(T) != 0 || (Policy::Alignment_ > 0 && config.Alignment_ % Policy::Alignment_ != 0))
+      Fail(name, "the alignment is less than the type or policy needs");
+    CompareStats(name, pool.GetStats(), oa.GetStats());
+
+    size_t headerSize = config.HBlockInfo_.size_;
+    size_t headerOffset = config.PadBytes_ + headerSize;
+    unsigned capacity = Policy::ObjectsPerPage_ * Policy::MaxPages_;
+
+    std::vector<T*> objects;
+    std::vector<void*> blocks;
+    for(unsigned i = 0; i < capacity; ++i)
+    {
+      T* object = pool.emplace(static_cast<int>(i));
+      char* block = static_cast<char*>(oa.Allocate());
+      objects.push_back(object);
+      blocks.push_back(block);
+
+      char* poolBlock = reinterpret_cast<char*>(object);
+      const char* poolPage = static_cast<const char*>(pool.GetPageList());
+      const char* oaPage = static_cast<const char*>(oa.GetPageList());
+
+      // Both take the blocks of their newest page in the same order
+      if(poolBlock - poolPage != block - oaPage)
+      {
+        Fail(name, "a block isn't at the same offset as the OA's");
+        break;
+      }
+      if(reinterpret_cast<std::uintptr_t>(object) % config.Alignment_ != 0)
+      {
+        Fail(name, "a block isn't aligned");
+        break;
+      }
+      if(headerSize > 0 && memcmp(poolBlock - headerOffset, block - headerOffset, headerSize) != 0)
+      {
+        Fail(name, "a header block isn't the same as the OA's");
+        break;
+      }
+    }
+    if(T::Live != static_cast<int>(capacity))
+      Fail(name, "emplace didn't construct every object");
+
+    // The last page is full
+    try
+    {
+      pool.emplace(0);
+      Fail(name, "emplace didn't throw past the last page");
+    }
+    catch(const OAException& e)
+    {
+      if(e.code() != OAException::E_NO_PAGES)
+        Fail(name, "emplace threw the wrong error past the last page");
+    }
+    try
+    {
+      oa.Allocate();
+    }
+    catch(const OAException&)
+    {
+    }
+    CompareStats(name, pool.GetStats(), oa.GetStats());
+
+    for(unsigned i = 0; i < capacity; ++i)
+    {
+      if(objects[i]->bytes_[0] != static_cast<unsigned char>(i))
+      {
+        Fail(name, "an object was overwritten");
+        break;
+      }
+    }
+
+    // A constructor that throws gives its block back (and the block is the next one taken)
+    pool.destroy(objects.back());
+    oa.Free(blocks.back());
+    if(T::Live != static_cast<int>(capacity) - 1)
+      Fail(name, "destroy didn't destroy the object");
+
+    const void* freeList = pool.GetFreeList();
+    OAStats before = pool.GetStats();
+    try
+    {
+      pool.emplace(-1);
+      Fail(name, "the constructor didn't throw");
+    }
+    catch(int)
+    {
+    }
+    if(pool.GetFreeList() != freeList || pool.GetStats().FreeObjects_ != before.FreeObjects_ ||
+       pool.GetStats().ObjectsInUse_ != before.ObjectsInUse_)
+      Fail(name, "a constructor that threw kept its block");
+    if(pool.emplace(7) != objects.back())
+      Fail(name, "the block given back isn't reused");
+
+    pool.destroy(nullptr);
+
+    // Everything goes back (the throwing constructor's block counts as an allocation and a free)
+    for(T* object : objects)
+      pool.destroy(object);
+    oa.Allocate();
+    oa.Free(blocks.back());
+    oa.Allocate();
+    for(void* block : blocks)
+      oa.Free(block);
+
+    if(T::Live != 0)
+      Fail(name, "objects are left alive");
+    if(pool.GetStats().ObjectsInUse_ != 0 || pool.GetStats().FreeObjects_ != capacity)
+      Fail(name, "objects are left in use");
+    CompareStats(name, pool.GetStats(), oa.GetStats());
+  }
+}
+
+int main()
+{
+  try
+  {
+    // Smaller than a pointer, a pointer, a few pointers and over-aligned objects
+    CheckPool<Item<2, 1>, PoolPolicy<4, 2> >("tiny, no headers");
+    CheckPool<Item<8, 8>, PoolPolicy<4, 2, OAConfig::hbBasic> >("basic");
+    CheckPool<Item<20, 4>, PoolPolicy<5, 3, OAConfig::hbBasic, 4> >("basic, padded");
+    CheckPool<Item<12, 4>, PoolPolicy<3, 2, OAConfig::hbExtended, 2, 16, 5> >("extended, padded, aligned");
+    CheckPool<Item<24, 32>, PoolPolicy<4, 2, OAConfig::hbNone, 3> >("align 32, padded");
+    CheckPool<Item<40, 32>, PoolPolicy<4, 3, OAConfig::hbBasic, 5> >("align 32, basic, padded");
+    CheckPool<Item<64, 64>, PoolPolicy<2, 2, OAConfig::hbExtended, 1, 0, 3> >("align 64, extended, padded");
+    CheckPool<Item<16, 16>, PoolPolicy<3, 2, OAConfig::hbBasic, 0, 128> >("policy align 128, basic");
+  }
+  catch(const OAException& e)
+  {
+    Fail("unexpected exception", e.what());
+  }
+
+  return Finish("object pool");
+}
@@ -0,0 +1,218 @@
+/**
+ * @file pooladapterstest.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Checks the PoolAllocator and PoolMemoryResource adapters with standard containers (needs C++17 for
+ *        the memory resource). Lists, maps and unordered maps take their nodes from a debug pool, which
+ *        has to count every node in use, get every node back and stay uncorrupted. Requests that are too
+ *        large or too aligned for the pool's blocks have to go to the fallback, so a pool whose blocks are
+ *        only byte aligned gets nothing. Prints one line for each check that fails and returns 1 if any
+ *        did.
+ *
+ *        Usage: pooladapterstest.exe
+ * @date 10-15-2026
+ */
+
+#include "PoolAllocators.h"
+#include "TestChecks.h"
+#include <cstdio>
+#include <functional>
+#include <list>
+#include <map>
+#include <unordered_map>
+
+#ifndef OA_HAS_PMR
+#error "pooladapterstest needs C++17 and <memory_resource>"
+#endif
+
+namespace
+{
+  const int ITEMS = 500; //!< elements put in each container
+
+  int Corrupted = 0; //!< blocks reported by the last validation
+
+  void CountCorruption(const void*, size_t)
+  {
+    Corrupted++;
+  }
+
+  /*!
+    Checks that the pool has the given number of blocks in use and isn't corrupted
+  */
+  void CheckPool(const char* name, ObjectAllocator& pool, unsigned inUse, const char* what)
+  {
+    if(pool.GetStats().ObjectsInUse_ != inUse)
+      Fail(name, what);
+
+    Corrupted = 0;
+    if(pool.ValidatePages(CountCorruption) != 0 || Corrupted != 0)
+      Fail(name, "the pages are corrupted");
+  }
+
+  /*!
+    A resource that counts what it's asked for and passes it on to new/delete
+  */
+  class CountingResource : public std::pmr::memory_resource
+  {
+    public:
+      int Allocations = 0;   //!< allocations not freed yet
+      int Requests = 0;      //!< every allocation asked for
+
+    protected:
+      void* do_allocate(size_t bytes, size_t alignment) override
+      {
+        Allocations++;
+        Requests++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+      }
+
+      void do_deallocate(void* p, size_t bytes, size_t alignment) override
+      {
+        Allocations--;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+      }
+
+      bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+      {
+        return this == &other;
+      }
+  };
+
+  /*!
+    An object too large for the pool's blocks
+  */
+  struct Large
+  {
+    char bytes_[256]; //!< the object
+  };
+
+  /*!
+    Runs the containers on a pool that fits their nodes
+  */
+  void Containers(const char* name, const OAConfig& config)
+  {
+    ObjectAllocator pool(64, config);
+
+    if(PoolBlockAlignment(pool) < alignof(void*))
+      Fail(name, "the blocks aren't aligned enough for the nodes");
+
+    {
+      std::list<int, PoolAllocator<int> > list{PoolAllocator<int>(pool)};
+      for(int i = 0; i < ITEMS; ++i)
+        list.push_back(i);
+      CheckPool(name, pool, ITEMS, "the list nodes didn't come from the pool");
+
+      list.remove_if([](int i) { return i % 2 == 0; });
+      CheckPool(name, pool, ITEMS / 2, "the list nodes removed didn't go back");
+    }
+    CheckPool(name, pool, 0, "the list nodes didn't go back");
+
+    {
+      typedef PoolAllocator<std::pair<const int, int> > MapAllocator;
+      std::map<int, int, std::less<int>, MapAllocator> map{MapAllocator(pool)};
+      for(int i = 0; i < ITEMS; ++i)
+        map[(i * 7919) % ITEMS] = i;
+      CheckPool(name, pool, ITEMS, "the map nodes didn't come from the pool");
+
+      for(int i = 0; i < ITEMS; i += 3)
+        map.erase(i);
+      CheckPool(name, pool, static_cast<unsigned>(map.size()), "the map nodes erased didn't go back");
+    }
+    CheckPool(name, pool, 0, "the map nodes didn't go back");
+
+    {
+      // The bucket array is more than one object, so it goes to the fallback
+      typedef PoolAllocator<std::pair<const int, int> > MapAllocator;
+      std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, MapAllocator> map{0, std::hash<int>(),
+                                                                                        std::equal_to<int>(),
+                                                                                        MapAllocator(pool)};
+      for(int i = 0; i < ITEMS; ++i)
+        map[i] = i;
+      CheckPool(name, pool, ITEMS, "the unordered map nodes didn't come from the pool");
+    }
+    CheckPool(name, pool, 0, "the unordered map nodes didn't go back");
+
+    {
+      CountingResource upstream;
+      PoolMemoryResource resource(pool, &upstream);
+      {
+        std::pmr::list<int> list(&resource);
+        for(int i = 0; i < ITEMS; ++i)
+          list.push_front(i);
+        CheckPool(name, pool, ITEMS, "the pmr list nodes didn't come from the pool");
+        if(upstream.Requests != 0)
+          Fail(name, "pmr list nodes went upstream");
+      }
+      CheckPool(name, pool, 0, "the pmr list nodes didn't go back");
+
+      // Too large or too aligned for a block
+      void* large = resource.allocate(65, 8);
+      void* aligned = resource.allocate(8, PoolBlockAlignment(pool) * 2);
+      if(upstream.Allocations != 2 || pool.GetStats().ObjectsInUse_ != 0)
+        Fail(name, "a request that doesn't fit didn't go upstream");
+      resource.deallocate(large, 65, 8);
+      resource.deallocate(aligned, 8, PoolBlockAlignment(pool) * 2);
+      if(upstream.Allocations != 0)
+        Fail(name, "a request that doesn't fit didn't go back upstream");
+    }
+
+    // Too large for a block, or more than one object
+    PoolAllocator<Large> large(pool);
+    Large* object = large.allocate(1);
+    int* several = PoolAllocator<int>(pool).allocate(4);
+    CheckPool(name, pool, 0, "an allocation that doesn't fit came from the pool");
+    large.deallocate(object, 1);
+    PoolAllocator<int>(pool).deallocate(several, 4);
+  }
+
+  /*!
+    Runs a list and a pmr list on a pool whose blocks are only byte aligned (everything falls back)
+  */
+  void ByteAligned()
+  {
+    const char* name = "byte aligned";
+
+    // The pad bytes and basic header put the first block at an odd offset
+    ObjectAllocator pool(64, DebugConfig(16, 4));
+
+    if(PoolBlockAlignment(pool) != 1)
+      Fail(name, "the blocks should only be byte aligned");
+
+    {
+      std::list<int, PoolAllocator<int> > list{PoolAllocator<int>(pool)};
+      for(int i = 0; i < ITEMS; ++i)
+        list.push_back(i);
+      CheckPool(name, pool, 0, "list nodes came from the pool");
+    }
+
+    CountingResource upstream;
+    PoolMemoryResource resource(pool, &upstream);
+    {
+      std::pmr::list<int> list(&resource);
+      for(int i = 0; i < ITEMS; ++i)
+        list.push_back(i);
+      CheckPool(name, pool, 0, "pmr list nodes came from the pool");
+      if(upstream.Allocations != ITEMS)
+        Fail(name, "pmr list nodes didn't go upstream");
+    }
+    if(upstream.Allocations != 0)
+      Fail(name, "pmr list nodes didn't go back upstream");
+  }
+}
+
+int main()
+{
+  try
+  {
+    Containers("no debugging", OAConfig(false, 16, 0));
+    Containers("debug, padded, basic headers", OAConfig(false, 16, 0, true, 8, OAConfig::HeaderBlockInfo(OAConfig::hbBasic), 16));
+    Containers("debug, extended side table", OAConfig(false, 16, 0, true, 4, OAConfig::HeaderBlockInfo(OAConfig::hbExtended, 3), 16,
+                                                      OAConfig::gtFixed, DEFAULT_MAX_GROWTH_PAGES, false, false, OAConfig::rtLIFO, -1, true));
+    ByteAligned();
+  }
+  catch(const OAException& e)
+  {
+    Fail("unexpected exception", e.what());
+  }
+
+  return Finish("pool adapter");
+}
@@ -0,0 +1,457 @@
+/**
+ * @file replay.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Replays an allocation trace recorded with ObjectAllocator::StartTrace against a configuration of the
+ *        Object Allocator (OA), the new/delete baseline and the thread-safe front-ends (where every thread
+ *        replays the whole trace with its own blocks). The events run back to back, the recorded times are
+ *        only added up for the summary. For each objects per page given, the throughput, the peak pages in
+ *        use and the fraction of the peak pages' blocks the objects never filled are printed as CSV, so
+ *        ObjectsPerPage_ and MaxPages_ can be tuned on a real workload.
+ *
+ *        Usage: replay.exe trace [-o objects per page]... [-m max pages] [-a alignment] [-p pad bytes]
+ *                                [-h none|basic|extended|external] [-r lifo|address|mostfull] [-d] [-l] [-s]
+ *                                [-t threads]
+ * @date 10-14-2026
+ */
+
+#include "AllocationTrace.h"
+#include "ConcurrentObjectAllocator.h"
+#include "NumaObjectAllocator.h"
+#include "ObjectAllocator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  typedef std::chrono::steady_clock Clock;
+
+  /*!
+    What a replay measured
+  */
+  struct Result
+  {
+    const char* status_;     //!< "ok", or why the replay stopped early
+    unsigned long long ops_; //!< the events replayed (by every thread)
+    double seconds_;         //!< how long the replay took (the slowest thread)
+    unsigned peakPages_;     //!< the most pages in use at once
+    unsigned mostObjects_;   //!< the most objects in use at once
+    size_t pageSize_;        //!< the size of a page
+  };
+
+  const char* HeaderName(OAConfig::HBLOCK_TYPE type)
+  {
+    switch(type)
+    {
+      case OAConfig::hbBasic:
+        return "basic";
+      case OAConfig::hbExtended:
+        return "extended";
+      case OAConfig::hbExternal:
+        return "external";
+      default:
+        return "none";
+    }
+  }
+
+  const char* ReuseName(OAConfig::REUSE_TYPE reuse)
+  {
+    switch(reuse)
+    {
+      case OAConfig::rtAddressOrdered:
+        return "address";
+      case OAConfig::rtMostFullPage:
+        return "mostfull";
+      default:
+        return "lifo";
+    }
+  }
+
+  const char* StatusName(OAException::OA_EXCEPTION code)
+  {
+    switch(code)
+    {
+      case OAException::E_NO_PAGES:
+        return "no_pages";
+      case OAException::E_NO_MEMORY:
+        return "no_memory";
+      default:
+        return "bad_free";
+    }
+  }
+
+  /**
+   * @brief Returns the label an allocation of the trace was made with (nullptr for none).
+   */
+  const char* Label(const AllocationTrace& trace, const TraceEvent& event)
+  {
+    return event.label_ != 0 ? trace.labels_[event.label_ - 1].c_str() : nullptr;
+  }
+
+  /**
+   * @brief Replays the trace on one allocator. The pages in use only go down on a reset or when the empty
+   *        pages are freed, so the peak is checked right before those and at the end. The new/delete
+   *        baseline doesn't reset, so a reset frees every block in use instead.
+   */
+  Result ReplayOne(const AllocationTrace& trace, const OAConfig& config)
+  {
+    Result result = { "ok", 0, 0, 0, 0, 0 };
+
+    ObjectAllocator oa(trace.objectSize_, config);
+    std::vector<void*> blocks(trace.blockIds_, nullptr);
+
+    Clock::time_point start = Clock::now();
+
+    try
+    {
+      for(const TraceEvent& event : trace.events_)
+      {
+        switch(event.type_)
+        {
+          case TraceEvent::etAllocate:
+            blocks[event.id_] = oa.Allocate(Label(trace, event));
+            break;
+          case TraceEvent::etFree:
+            oa.Free(blocks[event.id_]);
+            blocks[event.id_] = nullptr;
+            break;
+          case TraceEvent::etReset:
+            result.peakPages_ = std::max(result.peakPages_, oa.GetStats().PagesInUse_);
+            if(config.UseCPPMemManager_)
+            {
+              for(void*& block : blocks)
+              {
+                if(block != nullptr)
+                  oa.Free(block);
+              }
+            }
+            oa.Reset(event.id_);
+            std::fill(blocks.begin(), blocks.end(), nullptr);
+            break;
+          default:
+            result.peakPages_ = std::max(result.peakPages_, oa.GetStats().PagesInUse_);
+            oa.FreeEmptyPages();
+            break;
+        }
+
+        result.ops_++;
+      }
+    }
+    catch(const OAException& e)
+    {
+      result.status_ = StatusName(e.code());
+    }
+
+    result.seconds_ = std::chrono::duration<double>(Clock::now() - start).count();
+
+    OAStats stats = oa.GetStats();
+    result.peakPages_ = std::max(result.peakPages_, stats.PagesInUse_);
+    result.mostObjects_ = stats.MostObjects_;
+    result.pageSize_ = stats.PageSize_;
+
+    // The blocks the trace never freed (new/delete would leak them)
+    for(void* block : blocks)
+    {
+      if(block != nullptr)
+        oa.Free(block);
+    }
+
+    return result;
+  }
+
+  /**
+   * @brief Replays the whole trace with every thread at once on a shared allocator (ConcurrentObjectAllocator
+   *        or NumaObjectAllocator). The front-ends can't reset and freeing their empty pages isn't safe while
+   *        the other threads allocate, so a reset frees every block the thread has in use, and freeing the
+   *        empty pages is skipped. The pages then never go down, so the pages in use at the end are the peak.
+   */
+  template <typename POOL>
+  Result ReplayThreads(const AllocationTrace& trace, POOL& pool, unsigned threads)
+  {
+    Result result = { "ok", 0, 0, 0, 0, 0 };
+
+    std::atomic<unsigned> ready(0);
+    std::atomic<int> failure(-1);
+    std::vector<unsigned long long> ops(threads, 0);
+    std::vector<double> seconds(threads, 0);
+    std::vector<std::thread> workers;
+
+    for(unsigned t = 0; t < threads; ++t)
+    {
+      workers.push_back(std::thread([&trace, &pool, &ready, &failure, &ops, &seconds, threads, t]()
+      {
+        std::vector<void*> blocks(trace.blockIds_, nullptr);
+
+        // Start every thread at once
+        ready++;
+        while(ready.load() < threads)
+          std::this_thread::yield();
+
+        Clock::time_point start = Clock::now();
+
+        try
+        {
+          for(const TraceEvent& event : trace.events_)
+          {
+            if(event.type_ == TraceEvent::etAllocate)
+            {
+              blocks[event.id_] = pool.Allocate(Label(trace, event));
+            }
+            else if(event.type_ == TraceEvent::etFree)
+            {
+              pool.Free(blocks[event.id_]);
+              blocks[event.id_] = nullptr;
+            }
+            else if(event.type_ == TraceEvent::etReset)
+            {
+              for(void*& block : blocks)
+              {
+                if(block != nullptr)
+                  pool.Free(block);
+                block = nullptr;
+              }
+            }
+
+            ops[t]++;
+          }
+        }
+        catch(const OAException& e)
+        {
+          failure.store(static_cast<int>(e.code()));
+        }
+
+        seconds[t] = std::chrono::duration<double>(Clock::now() - start).count();
+
+        for(void* block : blocks)
+        {
+          if(block != nullptr)
+            pool.Free(block);
+        }
+      }));
+    }
+
+    for(std::thread& worker : workers)
+      worker.join();
+
+    for(unsigned t = 0; t < threads; ++t)
+    {
+      result.ops_ += ops[t];
+      result.seconds_ = std::max(result.seconds_, seconds[t]);
+    }
+
+    if(failure.load() >= 0)
+      result.status_ = StatusName(static_cast<OAException::OA_EXCEPTION>(failure.load()));
+
+    return result;
+  }
+
+  /**
+   * @brief Replays the trace on a ConcurrentObjectAllocator shared by the threads.
+   */
+  Result ReplayConcurrent(const AllocationTrace& trace, const OAConfig& config, unsigned threads,
+                          ConcurrentObjectAllocator::CACHE_TYPE cacheType)
+  {
+    ConcurrentObjectAllocator pool(trace.objectSize_, config, DEFAULT_MAGAZINE_SIZE, cacheType);
+
+    Result result = ReplayThreads(trace, pool, threads);
+
+    OAStats stats = pool.GetStats();
+    result.peakPages_ = stats.PagesInUse_;
+    result.mostObjects_ = stats.MostObjects_;
+    result.pageSize_ = stats.PageSize_;
+
+    return result;
+  }
+
+  /**
+   * @brief Replays the trace on a NumaObjectAllocator shared by the threads (the most objects of every node
+   *        are added up, so they can be more than were in use at once).
+   */
+  Result ReplayNuma(const AllocationTrace& trace, const OAConfig& config, unsigned threads)
+  {
+    NumaObjectAllocator pool(trace.objectSize_, config);
+
+    Result result = ReplayThreads(trace, pool, threads);
+
+    for(unsigned node = 0; node < pool.GetNodes(); ++node)
+    {
+      OAStats stats = pool.GetNodeStats(node);
+      result.peakPages_ += stats.PagesInUse_;
+      result.mostObjects_ += stats.MostObjects_;
+      result.pageSize_ = stats.PageSize_;
+    }
+
+    return result;
+  }
+
+  /**
+   * @brief Prints one CSV line for a replay. The fragmentation is the fraction of the blocks of the peak
+   *        pages that were never in use, even when the most objects were in use.
+   */
+  void Report(const char* allocator, unsigned threads, const OAConfig& config, size_t objectSize, const Result& result)
+  {
+    double opsPerSecond = result.seconds_ > 0 ? static_cast<double>(result.ops_) / result.seconds_ : 0;
+
+    double blocks = static_cast<double>(result.peakPages_) * config.ObjectsPerPage_;
+    double fragmentation = blocks > 0 ? 1.0 - static_cast<double>(result.mostObjects_) / blocks : 0;
+    if(fragmentation < 0)
+      fragmentation = 0;
+
+    std::printf("%s,%u,%u,%u,%u,%s,%u,%d,%s,%d,%s,%llu,%.0f,%u,%llu,%u,%.3f\n", allocator, threads,
+                static_cast<unsigned>(objectSize), config.ObjectsPerPage_, config.MaxPages_,
+                HeaderName(config.HBlockInfo_.type_), config.PadBytes_, config.DebugOn_ ? 1 : 0,
+                ReuseName(config.Reuse_), config.LazyCarving_ ? 1 : 0, result.status_, result.ops_, opsPerSecond,
+                result.peakPages_, static_cast<unsigned long long>(result.peakPages_) * result.pageSize_,
+                result.mostObjects_, fragmentation);
+  }
+
+  void Usage(const char* program)
+  {
+    std::fprintf(stderr, "Usage: %s trace [-o objects per page]... [-m max pages] [-a alignment] [-p pad bytes]\n"
+                         "       [-h none|basic|extended|external] [-r lifo|address|mostfull] [-d] [-l] [-s] [-t threads]\n",
+                 program);
+  }
+}
+
+/**
+ * @brief Loads the trace, then replays it against every objects per page given (with the rest of the
+ *        configuration the same) and prints the results as CSV.
+ */
+int main(int argc, char** argv)
+{
+  if(argc < 2)
+  {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  std::vector<unsigned> objectsPerPage;
+  unsigned maxPages = 0;
+  unsigned alignment = 0;
+  unsigned padBytes = 0;
+  unsigned threads = 4;
+  bool debug = false;
+  bool lazyCarving = false;
+  bool sideTable = false;
+  OAConfig::HBLOCK_TYPE headerType = OAConfig::hbNone;
+  OAConfig::REUSE_TYPE reuse = OAConfig::rtLIFO;
+
+  for(int i = 2; i < argc; ++i)
+  {
+    const char* option = argv[i];
+    const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+    if(std::strcmp(option, "-d") == 0)
+      debug = true;
+    else if(std::strcmp(option, "-l") == 0)
+      lazyCarving = true;
+    else if(std::strcmp(option, "-s") == 0)
+      sideTable = true;
+    else if(value == nullptr)
+    {
+      Usage(argv[0]);
+      return 1;
+    }
+    else
+    {
+      unsigned number = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+      ++i;
+
+      if(std::strcmp(option, "-o") == 0 && number > 0)
+        objectsPerPage.push_back(number);
+      else if(std::strcmp(option, "-m") == 0)
+        maxPages = number;
+      else if(std::strcmp(option, "-a") == 0)
+        alignment = number;
+      else if(std::strcmp(option, "-p") == 0)
+        padBytes = number;
+      else if(std::strcmp(option, "-t") == 0)
+        threads = number;
+      else if(std::strcmp(option, "-h") == 0 && std::strcmp(value, "none") == 0)
+        headerType = OAConfig::hbNone;
+      else if(std::strcmp(option, "-h") == 0 && std::strcmp(value, "basic") == 0)
+        headerType = OAConfig::hbBasic;
+      else if(std::strcmp(option, "-h") == 0 && std::strcmp(value, "extended") == 0)
+        headerType = OAConfig::hbExtended;
+      else if(std::strcmp(option, "-h") == 0 && std::strcmp(value, "external") == 0)
+        headerType = OAConfig::hbExternal;
+      else if(std::strcmp(option, "-r") == 0 && std::strcmp(value, "lifo") == 0)
+        reuse = OAConfig::rtLIFO;
+      else if(std::strcmp(option, "-r") == 0 && std::strcmp(value, "address") == 0)
+        reuse = OAConfig::rtAddressOrdered;
+      else if(std::strcmp(option, "-r") == 0 && std::strcmp(value, "mostfull") == 0)
+        reuse = OAConfig::rtMostFullPage;
+      else
+      {
+        Usage(argv[0]);
+        return 1;
+      }
+    }
+  }
+
+  if(objectsPerPage.empty())
+  {
+    objectsPerPage.push_back(16);
+    objectsPerPage.push_back(64);
+    objectsPerPage.push_back(256);
+  }
+
+  AllocationTrace trace;
+  if(!LoadTrace(argv[1], trace))
+  {
+    std::fprintf(stderr, "%s: %s isn't a trace\n", argv[0], argv[1]);
+    return 1;
+  }
+
+  unsigned long long recorded = 0;
+  for(const TraceEvent& event : trace.events_)
+    recorded += event.delta_;
+
+  std::fprintf(stderr, "%u events, %u labels, object size %u, at most %u blocks in use, recorded over %.3f s\n",
+               static_cast<unsigned>(trace.events_.size()), static_cast<unsigned>(trace.labels_.size()),
+               static_cast<unsigned>(trace.objectSize_), trace.blockIds_, static_cast<double>(recorded) / 1e9);
+
+  std::printf("allocator,threads,object_size,objects_per_page,max_pages,header,pad_bytes,debug,reuse,lazy,status,"
+              "ops,ops_per_sec,peak_pages,peak_bytes,most_objects,fragmentation\n");
+
+  try
+  {
+    // The new/delete baseline
+    OAConfig baseline(true, objectsPerPage[0], 0);
+    Report("new_delete", 1, baseline, trace.objectSize_, ReplayOne(trace, baseline));
+
+    for(unsigned perPage : objectsPerPage)
+    {
+      OAConfig::HeaderBlockInfo header(headerType);
+      OAConfig config(false, perPage, maxPages, debug, padBytes, header, alignment, OAConfig::gtFixed,
+                      DEFAULT_MAX_GROWTH_PAGES, false, lazyCarving, reuse, -1, sideTable);
+
+      Report("oa", 1, config, trace.objectSize_, ReplayOne(trace, config));
+
+      if(threads == 0)
+        continue;
+
+      // Every thread replays the whole trace, so each one gets the max pages
+      OAConfig shared = config;
+      shared.MaxPages_ = maxPages * threads;
+
+      Report("concurrent_magazines", threads, shared, trace.objectSize_,
+             ReplayConcurrent(trace, shared, threads, ConcurrentObjectAllocator::ctMagazines));
+      Report("concurrent_lockfree", threads, shared, trace.objectSize_,
+             ReplayConcurrent(trace, shared, threads, ConcurrentObjectAllocator::ctLockFree));
+      Report("numa", threads, shared, trace.objectSize_, ReplayNuma(trace, shared, threads));
+    }
+  }
+  catch(const OAException& e)
+  {
+    std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+    return 1;
+  }
+
+  return 0;
+}
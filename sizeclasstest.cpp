@@ -0,0 +1,89 @@
+/**
+ * @file sizeclasstest.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Checks that the SizeClassAllocator sends every size to the smallest class that fits. For each set
+ *        of classes (some of them not multiples of the lookup granule), every size from 1 to the largest
+ *        class is allocated, checked against the class it should come from and freed. Sizes past the
+ *        largest class have to by-pass the classes. Prints one line for each check that fails and returns
+ *        1 if any did.
+ *
+ *        Usage: sizeclasstest.exe
+ * @date 10-15-2026
+ */
+
+#include "SizeClassAllocator.h"
+#include "TestChecks.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+  void Fail(const char* name, size_t size, const char* what)
+  {
+    char check[128];
+    std::snprintf(check, sizeof(check), "%s, size %u", name, static_cast<unsigned>(size));
+    ::Fail(check, what);
+  }
+
+  /*!
+    Allocates every size up to the largest class and checks which class each one comes from
+  */
+  void CheckClasses(const char* name, const std::vector<size_t>& classes)
+  {
+    SizeClassAllocator sca(classes, OAConfig(false, 4, 0));
+
+    size_t largest = sca.GetClassSize(sca.GetClassCount() - 1);
+
+    for(size_t size = 1; size <= largest; ++size)
+    {
+      // The smallest class that fits
+      size_t expected = 0;
+      while(sca.GetClassSize(expected) < size)
+        expected++;
+
+      void* block = sca.Allocate(size);
+
+      // Writing the whole size must not touch the other blocks
+      std::memset(block, 0x5A, size);
+
+      for(size_t i = 0; i < sca.GetClassCount(); ++i)
+      {
+        unsigned inUse = sca.GetClassStats(i).ObjectsInUse_;
+
+        if(i == expected && inUse != 1)
+          Fail(name, size, "the smallest class that fits wasn't used");
+        else if(i != expected && inUse != 0)
+          Fail(name, size, "a class that isn't the smallest fit was used");
+      }
+
+      sca.Free(block);
+
+      if(sca.GetClassStats(expected).ObjectsInUse_ != 0)
+        Fail(name, size, "the block wasn't freed back to its class");
+    }
+
+    // Past the largest class, no class is used
+    void* big = sca.Allocate(largest + 1);
+    for(size_t i = 0; i < sca.GetClassCount(); ++i)
+      if(sca.GetClassStats(i).ObjectsInUse_ != 0)
+        Fail(name, largest + 1, "a size past the largest class used a class");
+    sca.Free(big);
+  }
+}
+
+int main()
+{
+  const size_t tenTwenty[] = { 10, 20 };
+  const size_t odd[] = { 3, 10, 17, 20, 33 };
+  const size_t dense[] = { 1, 2, 3, 4, 5, 6, 7, 9, 15 };
+  const size_t one[] = { 13 };
+
+  CheckClasses("10 20", std::vector<size_t>(tenTwenty, tenTwenty + 2));
+  CheckClasses("odd sizes", std::vector<size_t>(odd, odd + 5));
+  CheckClasses("several in a granule", std::vector<size_t>(dense, dense + 9));
+  CheckClasses("one class", std::vector<size_t>(one, one + 1));
+  CheckClasses("default", SizeClassAllocator::DefaultSizeClasses());
+
+  return Finish("size class");
+}
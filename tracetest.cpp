@@ -0,0 +1,305 @@
+/**
+ * @file tracetest.cpp
+ * @author Adam Lonstein (adamlonstein@gmail.com)
+ * @brief Checks that a trace recorded by an Object Allocator reads back as what happened. Each configuration
+ *        allocates (with labels, some the same text at another address) and frees more blocks than fit in
+ *        a byte, compacts the pool and frees the moved blocks at their new addresses, frees the empty pages
+ *        and resets. The trace has to load with its object size, labels and events as numbers that take
+ *        more than one byte, every free has to name a block in use, the ids have to be reused (no more of
+ *        them than the most blocks in use at once) and replaying it on a new pool has to end with the same
+ *        statistics. A trace cut short has to be rejected. Prints one line for each check that fails and
+ *        returns 1 if any did.
+ *
+ *        Usage: tracetest.exe [file]
+ * @date 10-15-2026
+ */
+
+#include "AllocationTrace.h"
+#include "ObjectAllocator.h"
+#include "TestChecks.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const size_t OBJECT_SIZE = 200; //!< size of the objects (takes 2 bytes in the trace)
+  const unsigned PER_PAGE = 8;    //!< objects on each page of every pool
+  const unsigned PAD_BYTES = 4;   //!< pad bytes of the debug pools
+  const unsigned BLOCKS = 300;    //!< blocks allocated at first (the ids take 2 bytes)
+
+  std::vector<char*> Handles; //!< where each block is (the block holds its index)
+  unsigned Moves = 0;         //!< blocks reported moved
+
+  void Relocate(void*, void* to, size_t)
+  {
+    unsigned index;
+    std::memcpy(&index, to, sizeof(index));
+
+    Handles[index] = static_cast<char*>(to);
+    Moves++;
+  }
+
+  /*!
+    Allocates a block and keeps a handle to it
+  */
+  void Allocate(ObjectAllocator& oa, const char* label)
+  {
+    char* block = static_cast<char*>(oa.Allocate(label));
+    unsigned index = static_cast<unsigned>(Handles.size());
+    std::memcpy(block, &index, sizeof(index));
+
+    Handles.push_back(block);
+  }
+
+  /*!
+    Frees the block of a handle
+  */
+  void Free(ObjectAllocator& oa, unsigned index)
+  {
+    oa.Free(Handles[index]);
+    Handles[index] = nullptr;
+  }
+
+  /*!
+    Records a trace of every kind of event, returns the statistics at the end
+  */
+  OAStats Record(const char* path, const char* name, const OAConfig& config, const std::string& longLabel)
+  {
+    ObjectAllocator oa(OBJECT_SIZE, config);
+    Handles.clear();
+
+    if(!oa.StartTrace(path))
+    {
+      Fail(name, "the trace wasn't started");
+      return oa.GetStats();
+    }
+
+    // The same text at another address is the same label
+    std::string copy("short");
+    for(unsigned i = 0; i < BLOCKS; ++i)
+    {
+      const char* labels[] = { "short", longLabel.c_str(), nullptr, copy.c_str() };
+      Allocate(oa, labels[i % 4]);
+    }
+
+    // The ids freed are reused
+    for(unsigned i = 0; i < BLOCKS; i += 2)
+      Free(oa, i);
+    for(unsigned i = 0; i < BLOCKS / 4; ++i)
+      Allocate(oa, "short");
+
+    // Compact moves the blocks left, which are freed where they were moved to
+    for(unsigned i = 1; i < Handles.size(); i += 3)
+    {
+      if(Handles[i] != nullptr)
+        Free(oa, i);
+    }
+    Moves = 0;
+    while(oa.Compact(Relocate, 16) > 0)
+    {
+    }
+    if(Moves == 0)
+      Fail(name, "no blocks were moved");
+    for(unsigned i = 0; i < Handles.size(); ++i)
+    {
+      if(Handles[i] != nullptr)
+        Free(oa, i);
+    }
+
+    oa.FreeEmptyPages();
+
+    // The ids start over after a reset
+    for(unsigned i = 0; i < PER_PAGE * 2; ++i)
+      Allocate(oa, nullptr);
+    oa.Reset(1);
+    Handles.clear();
+    for(unsigned i = 0; i < PER_PAGE; ++i)
+      Allocate(oa, "after reset");
+    for(unsigned i = 0; i < PER_PAGE; i += 2)
+      Free(oa, i);
+
+    if(!oa.StopTrace())
+      Fail(name, "the trace wasn't all written");
+
+    return oa.GetStats();
+  }
+
+  /*!
+    Checks the start of the trace file and that it's rejected when it's cut short
+  */
+  void CheckBytes(const char* path, const char* name)
+  {
+    std::vector<unsigned char> bytes;
+    std::FILE* file = std::fopen(path, "rb");
+    if(file == nullptr)
+    {
+      Fail(name, "the trace can't be read");
+      return;
+    }
+    int byte;
+    while((byte = std::fgetc(file)) != EOF)
+      bytes.push_back(static_cast<unsigned char>(byte));
+    std::fclose(file);
+
+    // The object size is 7 bits at a time, the high bit set on every byte but the last
+    const unsigned char start[] = { 'O', 'A', 'T', 'R', 'A', 'C', 'E', '1', 0xC8, 0x01 };
+    if(bytes.size() < sizeof(start) || std::memcmp(bytes.data(), start, sizeof(start)) != 0)
+      Fail(name, "the trace doesn't start with the object size");
+
+    file = std::fopen(path, "wb");
+    if(file == nullptr)
+      return;
+    std::fwrite(bytes.data(), 1, bytes.size() - 1, file);
+    std::fclose(file);
+
+    AllocationTrace trace;
+    if(LoadTrace(path, trace))
+      Fail(name, "a trace cut short was loaded");
+  }
+
+  /*!
+    Checks the events of a loaded trace: every free is of a block in use, and the ids are reused
+  */
+  void CheckEvents(const char* name, const AllocationTrace& trace, const std::string& longLabel)
+  {
+    if(trace.objectSize_ != OBJECT_SIZE)
+      Fail(name, "the object size changed");
+    if(trace.labels_.size() != 3 || trace.labels_[0] != "short" || trace.labels_[1] != longLabel ||
+       trace.labels_[2] != "after reset")
+      Fail(name, "the labels changed");
+
+    std::vector<bool> live(trace.blockIds_, false);
+    unsigned inUse = 0;
+    unsigned mostInUse = 0;
+    unsigned resets = 0;
+    unsigned emptyPages = 0;
+    unsigned wide = 0;
+
+    for(const TraceEvent& event : trace.events_)
+    {
+      if(event.type_ == TraceEvent::etAllocate)
+      {
+        if(event.id_ >= live.size() || live[event.id_])
+        {
+          Fail(name, "a block got the id of a block in use");
+          return;
+        }
+        live[event.id_] = true;
+        inUse++;
+        mostInUse = std::max(mostInUse, inUse);
+        if(event.id_ >= 0x80)
+          wide++;
+      }
+      else if(event.type_ == TraceEvent::etFree)
+      {
+        if(event.id_ >= live.size() || !live[event.id_])
+        {
+          Fail(name, "a free isn't of a block in use");
+          return;
+        }
+        live[event.id_] = false;
+        inUse--;
+      }
+      else if(event.type_ == TraceEvent::etReset)
+      {
+        if(event.id_ != 1)
+          Fail(name, "the pages kept by the reset changed");
+        live.assign(live.size(), false);
+        inUse = 0;
+        resets++;
+      }
+      else
+      {
+        // Every block was freed before (the moved ones where they were moved to)
+        if(inUse != 0)
+          Fail(name, "the blocks freed after being moved were lost");
+        emptyPages++;
+      }
+    }
+
+    if(mostInUse != trace.blockIds_)
+      Fail(name, "the ids weren't reused");
+    if(wide == 0)
+      Fail(name, "no id took more than a byte");
+    if(resets != 1 || emptyPages != 1)
+      Fail(name, "the reset or the empty pages freed were lost");
+    if(inUse != PER_PAGE / 2)
+      Fail(name, "the blocks freed after the reset were lost");
+  }
+
+  /*!
+    Replays a trace on a new pool and returns its statistics
+  */
+  OAStats Replay(const AllocationTrace& trace, const OAConfig& config)
+  {
+    ObjectAllocator oa(trace.objectSize_, config);
+    std::vector<void*> blocks(trace.blockIds_, nullptr);
+
+    for(const TraceEvent& event : trace.events_)
+    {
+      if(event.type_ == TraceEvent::etAllocate)
+        blocks[event.id_] = oa.Allocate(event.label_ != 0 ? trace.labels_[event.label_ - 1].c_str() : nullptr);
+      else if(event.type_ == TraceEvent::etFree)
+        oa.Free(blocks[event.id_]);
+      else if(event.type_ == TraceEvent::etReset)
+        oa.Reset(event.id_);
+      else
+        oa.FreeEmptyPages();
+    }
+
+    return oa.GetStats();
+  }
+
+  /*!
+    Records a trace, reads it back and replays it
+  */
+  void RoundTrip(const char* path, const char* name, const OAConfig& config)
+  {
+    // The length of the label takes 2 bytes
+    std::string longLabel(150, 'x');
+
+    OAStats recorded = Record(path, name, config, longLabel);
+
+    AllocationTrace trace;
+    if(!LoadTrace(path, trace))
+    {
+      Fail(name, "the trace wasn't loaded");
+      return;
+    }
+
+    CheckEvents(name, trace, longLabel);
+
+    OAStats replayed = Replay(trace, config);
+    if(replayed.Allocations_ != recorded.Allocations_ || replayed.Deallocations_ != recorded.Deallocations_ ||
+       replayed.ObjectsInUse_ != recorded.ObjectsInUse_ || replayed.MostObjects_ != recorded.MostObjects_)
+      Fail(name, "the replay didn't end with the same statistics");
+
+    CheckBytes(path, name);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const char* path = (argc > 1) ? argv[1] : "tracetest.trace";
+
+  try
+  {
+    RoundTrip(path, "lifo", OAConfig(false, PER_PAGE, 0));
+    RoundTrip(path, "debug", DebugConfig(PER_PAGE, PAD_BYTES));
+    RoundTrip(path, "address ordered", DebugConfig(PER_PAGE, PAD_BYTES, true, OAConfig::rtAddressOrdered));
+    RoundTrip(path, "most full page", OAConfig(false, PER_PAGE, 0, false, 0, OAConfig::HeaderBlockInfo(), 0, OAConfig::gtDoubling,
+                                               DEFAULT_MAX_GROWTH_PAGES, false, false, OAConfig::rtMostFullPage));
+    RoundTrip(path, "external", OAConfig(false, PER_PAGE, 0, true, PAD_BYTES, OAConfig::HeaderBlockInfo(OAConfig::hbExternal)));
+  }
+  catch(const OAException& e)
+  {
+    Fail("unexpected exception", e.what());
+  }
+
+  std::remove(path);
+
+  return Finish("trace");
+}